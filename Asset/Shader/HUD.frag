@@ -16,7 +16,6 @@ layout(std140) uniform ub_map
     int height;
     float povX;
     float povY;
-    TileData[MAX_LEVEL_TILE_COUNT] tiles;
 } u_map;
 
 uniform int u_mode;
@@ -31,17 +30,6 @@ in vec2 f_texCoord;
 
 out vec4 color;
 
-int calculateTileIndex(float tileX, float tileY, float levelWidth, float levelHeight)
-{
-    int index = int(clamp(tileY * levelWidth + tileX, 0.0, (levelWidth * levelHeight) - 1.0));
-    return index;
-}
-
-TileData getTileData(float tileX, float tileY, float levelWidth, float levelHeight)
-{
-    return u_map.tiles[calculateTileIndex(tileX, tileY, levelWidth, levelHeight)];
-}
-
 float calculateValidTileMask(float tileX, float tileY, float levelWidth, float levelHeight)
 {
     float validTileMask = max(0.0, sign(tileX + 1));
@@ -60,7 +60,6 @@ layout(std140) uniform ub_map
     float povY;
     uint povDirection;
     uint paddingA;
-    STile[MAX_LEVEL_TILE_COUNT] tiles;
 } u_map;
 
 layout(std140) uniform ub_world
@@ -75,20 +74,17 @@ uniform vec4 u_modeControlB;
 uniform vec2 u_sizeScreenSpace;
 uniform sampler2D u_commonAtlas;
 uniform sampler2DArray u_worldTextures;
+uniform usampler2D u_mapTiles;
 
 in vec2 f_texCoord;
 
 out vec4 color;
 
-int calculateTileIndex(float tileX, float tileY, float levelWidth, float levelHeight)
-{
-    int index = int(clamp(tileY * levelWidth + tileX, 0.0, (levelWidth * levelHeight) - 1.0));
-    return index;
-}
-
 STile getTileData(float tileX, float tileY, float levelWidth, float levelHeight)
 {
-    return u_map.tiles[calculateTileIndex(tileX, tileY, levelWidth, levelHeight)];
+    ivec2 coords = ivec2(clamp(vec2(tileX, tileY), vec2(0.0), vec2(levelWidth, levelHeight) - 1.0));
+    uvec4 tile = texelFetch(u_mapTiles, coords, 0);
+    return STile(tile.x, tile.y, tile.z, tile.w);
 }
 
 float calculateValidTileMask(float tileX, float tileY, float levelWidth, float levelHeight)
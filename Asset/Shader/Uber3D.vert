@@ -1,6 +1,9 @@
 layout(location = 0) in vec3 a_vertexPositionModelSpace;
 layout(location = 1) in vec2 a_texCoord;
 layout(location = 2) in vec3 a_normal;
+layout(location = 3) in mat4 a_model;
+/* x, z, rotation, variant; see STileInstance. */
+layout(location = 7) in ivec4 a_tile;
 
 layout(std140) uniform ub_common
 {
@@ -9,7 +12,7 @@ layout(std140) uniform ub_common
 };
 uniform int u_mode;
 uniform vec4 u_modeControlA;
-uniform mat4 u_model[UBER3D_MODEL_COUNT];
+uniform bool u_tileInstances;
 
 out vec2 f_texCoord;
 out vec4 f_positionViewSpace;
@@ -17,9 +20,22 @@ out vec3 f_positionWorldSpace;
 out vec4 f_vertexColor;
 out vec3 f_eyeDirectionCameraSpace;
 
+/* cos and sin of SDirection::RotationFromDirection() for each direction. */
+const vec2 c_tileRotations[4] = vec2[4](vec2(1.0, 0.0), vec2(0.0, -1.0), vec2(-1.0, 0.0), vec2(0.0, 1.0));
+
+mat4 tileModel(ivec4 tile)
+{
+    vec2 rotation = c_tileRotations[tile.z & 3];
+    return mat4(
+        vec4(rotation.x, 0.0, -rotation.y, 0.0),
+        vec4(0.0, 1.0, 0.0, 0.0),
+        vec4(rotation.y, 0.0, rotation.x, 0.0),
+        vec4(float(tile.x), 0.0, float(tile.y), 1.0));
+}
+
 void main()
 {
-    mat4 model = u_model[gl_InstanceID];
+    mat4 model = u_tileInstances ? tileModel(a_tile) : a_model;
 
     gl_Position = u_projection * u_view * model * vec4(a_vertexPositionModelSpace, 1.0);
 
@@ -0,0 +1,130 @@
+#include <memory>
+#include <random>
+#include <vector>
+#include "Benchmark.hxx"
+#include "LegacyInlineResource.hxx"
+#include "Math.hxx"
+#include "Memory.hxx"
+
+/* Compares CInlineResource with the linear block walk it replaced, on the allocation patterns of the two heaviest users at startup. */
+
+static constexpr int Repetitions = 5;
+
+/* Long-lived blocks with holes between them, so neither allocator starts from an empty heap. */
+template <typename TResource>
+static std::vector<void*> Fragment(TResource& Resource)
+{
+    std::mt19937 Random(42);
+    std::vector<void*> Blocks;
+    for (int Index = 0; Index < 4000; ++Index)
+    {
+        Blocks.push_back(Resource.do_allocate(Random() % 256 + 16, alignof(std::max_align_t)));
+    }
+    for (std::size_t Index = 0; Index < Blocks.size(); Index += 2)
+    {
+        Resource.do_deallocate(Blocks[Index], 0, alignof(std::max_align_t));
+        Blocks[Index] = nullptr;
+    }
+    return Blocks;
+}
+
+template <typename TResource>
+static void Release(TResource& Resource, std::vector<void*>& Blocks)
+{
+    for (auto Block : Blocks)
+    {
+        if (Block != nullptr)
+        {
+            Resource.do_deallocate(Block, 0, alignof(std::max_align_t));
+        }
+    }
+}
+
+/* CRawMesh: four result vectors and four scratch ones growing by push_back while an OBJ is parsed. */
+template <typename TResource>
+static void MeshChurn(TResource& Resource)
+{
+    for (int Mesh = 0; Mesh < 200; ++Mesh)
+    {
+        std::pmr::vector<SVec3> Positions(&Resource);
+        std::pmr::vector<SVec2> TexCoords(&Resource);
+        std::pmr::vector<SVec3> Normals(&Resource);
+        std::pmr::vector<unsigned short> Indices(&Resource);
+        std::pmr::vector<SVec3> ScratchPositions(&Resource);
+        std::pmr::vector<SVec2> ScratchTexCoords(&Resource);
+        std::pmr::vector<SVec3> ScratchNormals(&Resource);
+        std::pmr::vector<SVec3Size> ScratchIndices(&Resource);
+        for (int Vertex = 0; Vertex < 2000; ++Vertex)
+        {
+            auto Value = (float)Vertex;
+            ScratchPositions.push_back({ Value, Value, Value });
+            ScratchTexCoords.push_back({ Value, Value });
+            ScratchNormals.push_back({ Value, Value, Value });
+            ScratchIndices.push_back({ (std::size_t)Vertex, (std::size_t)Vertex, (std::size_t)Vertex });
+        }
+        for (int Vertex = 0; Vertex < 2000; ++Vertex)
+        {
+            Positions.push_back(ScratchPositions[Vertex]);
+            TexCoords.push_back(ScratchTexCoords[Vertex]);
+            Normals.push_back(ScratchNormals[Vertex]);
+            Indices.push_back((unsigned short)Vertex);
+        }
+        Benchmark::DoNotOptimize(Indices.data());
+    }
+}
+
+/* SAtlas::Build: stb_image decodes every sprite with a zlib buffer and an output that grows by realloc, and the decoded
+ * images stay alive until the atlas is uploaded. */
+template <typename TResource>
+static void AtlasChurn(TResource& Resource)
+{
+    static constexpr int SpriteCount = 64;
+    std::mt19937 Random(7);
+    void* Images[SpriteCount]{};
+    for (int Atlas = 0; Atlas < 100; ++Atlas)
+    {
+        for (auto& Image : Images)
+        {
+            auto Size = (std::size_t)(Random() % 49 + 16);
+            auto ImageBytes = Size * Size * 4;
+            auto ZlibBuffer = Resource.do_allocate(16384, alignof(std::max_align_t));
+            std::size_t OutBytes = 4096;
+            auto Out = Resource.do_allocate(OutBytes, alignof(std::max_align_t));
+            while (OutBytes < ImageBytes)
+            {
+                OutBytes *= 2;
+                Out = Resource.do_reallocate(Out, OutBytes);
+            }
+            Image = Resource.do_allocate(ImageBytes, alignof(std::max_align_t));
+            Resource.do_deallocate(Out, 0, alignof(std::max_align_t));
+            Resource.do_deallocate(ZlibBuffer, 0, alignof(std::max_align_t));
+        }
+        for (auto& Image : Images)
+        {
+            Resource.do_deallocate(Image, 0, alignof(std::max_align_t));
+        }
+    }
+}
+
+template <typename TResource>
+static void Run(TResource& Resource, const char* Name)
+{
+    auto Blocks = Fragment(Resource);
+    char Label[64];
+    std::snprintf(Label, sizeof(Label), "Mesh churn, %s", Name);
+    Benchmark::Report(Label, Benchmark::Measure(Repetitions, [&] { MeshChurn(Resource); }));
+    std::snprintf(Label, sizeof(Label), "Atlas churn, %s", Name);
+    Benchmark::Report(Label, Benchmark::Measure(Repetitions, [&] { AtlasChurn(Resource); }));
+    Release(Resource, Blocks);
+}
+
+int main()
+{
+    /* 16 MiB each, too much for the stack. */
+    auto Legacy = std::make_unique<CLegacyInlineResource>();
+    auto Current = std::make_unique<CInlineResource>();
+
+    Run(*Legacy, "linear block walk");
+    Run(*Current, "segregated free lists");
+    return 0;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+/* Shared by the benchmark executables. They print their timings as plain text and aren't part of the tests. */
+namespace Benchmark
+{
+    /* Runs Func Repetitions times and returns the fastest run, in milliseconds. */
+    template <typename F>
+    double Measure(int Repetitions, F&& Func)
+    {
+        auto Best = 1e30;
+        for (int Repetition = 0; Repetition < Repetitions; ++Repetition)
+        {
+            auto Start = std::chrono::steady_clock::now();
+            Func();
+            Best = std::min(Best, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Start).count());
+        }
+        return Best;
+    }
+
+    /* Keeps the compiler from dropping the computation of Value. */
+    template <typename T>
+    inline void DoNotOptimize(const T& Value)
+    {
+        asm volatile("" : : "r,m"(Value) : "memory");
+    }
+
+    inline void Report(const char* Name, double Milliseconds)
+    {
+        std::printf("%-48s %12.3f ms\n", Name, Milliseconds);
+    }
+}
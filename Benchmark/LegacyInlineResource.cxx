@@ -0,0 +1,216 @@
+#include "LegacyInlineResource.hxx"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+CLegacyInlineResource::CLegacyInlineResource(std::pmr::memory_resource* up)
+    : Upstream(up)
+{
+}
+
+void CLegacyInlineResource::DestroyBlock(SAllocationHeader* AllocationHeader)
+{
+    if (AllocationHeader->PreviousBlock == nullptr)
+    {
+        FirstAllocation = AllocationHeader->NextBlock;
+    }
+    else
+    {
+        AllocationHeader->PreviousBlock->NextBlock = AllocationHeader->NextBlock;
+    }
+    if (AllocationHeader->NextBlock != nullptr)
+    {
+        AllocationHeader->NextBlock->PreviousBlock = AllocationHeader->PreviousBlock;
+    }
+}
+
+void* CLegacyInlineResource::do_allocate(size_t bytes, size_t alignment)
+{
+    std::unique_lock Lock{ Mutex };
+    return AllocateInline(nullptr, bytes, alignment);
+}
+
+void CLegacyInlineResource::do_deallocate(void* ptr, [[maybe_unused]] size_t bytes, [[maybe_unused]] size_t alignment)
+{
+    std::unique_lock Lock{ Mutex };
+    AllocateInline(ptr, 0);
+}
+
+void* CLegacyInlineResource::do_reallocate(void* ptr, size_t bytes)
+{
+    std::unique_lock Lock{ Mutex };
+    return AllocateInline(ptr, bytes);
+}
+
+void* CLegacyInlineResource::AllocateInline(void* SrcPtr, size_t Bytes, const size_t Alignment)
+{
+    std::size_t BytesWithHeader = Bytes + sizeof(SAllocationHeader);
+    std::size_t FinalAllocationSize = BytesWithHeader + (Alignment - 1);
+    std::size_t ReallocBytes{};
+    if (SrcPtr != nullptr)
+    {
+        auto BytePtr = static_cast<std::byte*>(SrcPtr);
+        auto AllocationHeader = reinterpret_cast<SAllocationHeader*>(BytePtr) - 1;
+
+        /* Freeing. */
+        if (Bytes == 0)
+        {
+            /* Check if the pointer is within our range. */
+            if (BytePtr < Buffer.data() || BytePtr >= Buffer.data() + Buffer.size())
+            {
+                Upstream->deallocate(SrcPtr, Bytes, Alignment);
+                return nullptr;
+            }
+
+            DestroyBlock(AllocationHeader);
+            return nullptr;
+        }
+
+        /* Reallocating. */
+        if (AllocationHeader->NextBlock != nullptr)
+        {
+            if (BytePtr + BytesWithHeader >= reinterpret_cast<std::byte*>(AllocationHeader->NextBlock) || !IsAlignedPtr(SrcPtr, Alignment))
+            {
+                /* Can't go beyond NextBlock! */
+                ReallocBytes = std::min(AllocationHeader->Length, Bytes);
+                DestroyBlock(AllocationHeader);
+            }
+            else
+            {
+                AllocationHeader->Length = Bytes;
+                return SrcPtr;
+            }
+        }
+        else
+        {
+            if (BytePtr + BytesWithHeader >= Buffer.data() + Buffer.size() || !IsAlignedPtr(SrcPtr, Alignment))
+            {
+                /* Can't go beyond end of the buffer! */
+                ReallocBytes = std::min(AllocationHeader->Length, Bytes);
+                DestroyBlock(AllocationHeader);
+            }
+            else
+            {
+                AllocationHeader->Length = Bytes;
+                return SrcPtr;
+            }
+        }
+    }
+    else if (Bytes == 0)
+    {
+        return nullptr;
+    }
+
+    std::byte* NewPtr{};
+    SAllocationHeader* NewPreviousBlock = nullptr;
+    SAllocationHeader* NewNextBlock = nullptr;
+
+    if (FinalAllocationSize > Buffer.size())
+    {
+        NewPtr = static_cast<std::byte*>(Upstream->allocate(Bytes, Alignment));
+        if (ReallocBytes != 0)
+        {
+            std::memcpy(NewPtr, SrcPtr, std::min(ReallocBytes, Bytes));
+        }
+        return NewPtr;
+    }
+    else
+    {
+        if (FirstAllocation == nullptr)
+        {
+            NewPtr = Buffer.data();
+        }
+        else
+        {
+            if (reinterpret_cast<std::byte*>(FirstAllocation) > Buffer.data() && reinterpret_cast<std::byte*>(FirstAllocation) - Buffer.data() >= (int)BytesWithHeader)
+            {
+                NewPtr = Buffer.data();
+                NewNextBlock = FirstAllocation;
+                FirstAllocation = nullptr;
+            }
+            else
+            {
+                SAllocationHeader* AllocationHeader = FirstAllocation;
+                while (AllocationHeader != nullptr)
+                {
+                    auto DataAfterHeader = reinterpret_cast<std::byte*>(AllocationHeader) + AllocationHeader->Length + sizeof(SAllocationHeader);
+
+                    /* See if there is free space after the header. */
+                    if (AllocationHeader->NextBlock != nullptr)
+                    {
+                        auto NextBlockData = reinterpret_cast<std::byte*>(AllocationHeader->NextBlock);
+                        if (DataAfterHeader + FinalAllocationSize < NextBlockData)
+                        {
+                            /* We can fit an allocation between two. */
+                            NewPtr = DataAfterHeader;
+                            NewPreviousBlock = AllocationHeader;
+                            NewNextBlock = AllocationHeader->NextBlock;
+                            break;
+                        }
+                        else
+                        {
+                            AllocationHeader = AllocationHeader->NextBlock;
+                            continue;
+                        }
+                    }
+                    else
+                    {
+                        /* No next block; just check if it fits. */
+                        if (DataAfterHeader + FinalAllocationSize >= Buffer.data() + Buffer.size())
+                        {
+                            NewPtr = static_cast<std::byte*>(Upstream->allocate(Bytes, Alignment));
+                            if (ReallocBytes != 0)
+                            {
+                                std::memcpy(NewPtr, SrcPtr, std::min(ReallocBytes, Bytes));
+                            }
+                            return NewPtr;
+                        }
+                        else
+                        {
+                            NewPtr = DataAfterHeader;
+                            NewPreviousBlock = AllocationHeader;
+                            NewNextBlock = AllocationHeader->NextBlock;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    if (NewPtr == nullptr)
+    {
+        std::exit(1);
+    }
+
+    /* Shift pointer to point to allocated data. */
+    NewPtr = static_cast<std::byte*>(AlignPtr(NewPtr + sizeof(SAllocationHeader), Alignment));
+
+    auto NewAllocationHeader = reinterpret_cast<SAllocationHeader*>(NewPtr) - 1;
+    NewAllocationHeader->Length = Bytes;
+    NewAllocationHeader->NextBlock = NewNextBlock;
+    NewAllocationHeader->PreviousBlock = NewPreviousBlock;
+
+    if (FirstAllocation == nullptr)
+    {
+        FirstAllocation = NewAllocationHeader;
+    }
+
+    if (NewNextBlock != nullptr)
+    {
+        NewNextBlock->PreviousBlock = NewAllocationHeader;
+    }
+
+    if (NewPreviousBlock != nullptr)
+    {
+        NewPreviousBlock->NextBlock = NewAllocationHeader;
+    }
+
+    if (ReallocBytes != 0)
+    {
+        std::memcpy(NewPtr, SrcPtr, std::min(ReallocBytes, Bytes));
+    }
+
+    return NewPtr;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory_resource>
+#include <mutex>
+#include "Memory.hxx"
+
+/* CInlineResource as it was before segregated free lists: blocks in address order, allocation walks them for the first gap.
+ * Kept only so AllocatorBenchmark has something to compare against. */
+class CLegacyInlineResource final : public std::pmr::memory_resource
+{
+private:
+    struct alignas(alignof(std::max_align_t)) SAllocationHeader
+    {
+        std::size_t Length{};
+        SAllocationHeader* PreviousBlock{};
+        SAllocationHeader* NextBlock{};
+    };
+
+    alignas(alignof(std::max_align_t))
+        std::array<std::byte, HeapSize> Buffer{};
+    SAllocationHeader* FirstAllocation{};
+    std::pmr::memory_resource* Upstream = std::pmr::new_delete_resource();
+    std::mutex Mutex;
+
+    void DestroyBlock(SAllocationHeader* AllocationHeader);
+
+    static constexpr std::size_t DoAlign(std::size_t Num, std::size_t Alignment)
+    {
+        return (Num + (Alignment - 1)) & ~(Alignment - 1);
+    }
+
+    static inline void* AlignPtr(void* Ptr, std::size_t Alignment)
+    {
+        return (void*)(DoAlign((size_t)Ptr, Alignment));
+    }
+
+    static bool IsAlignedPtr(void* Ptr, std::size_t Alignment)
+    {
+        return ((std::size_t)Ptr & (Alignment - 1)) == 0;
+    }
+
+public:
+    explicit CLegacyInlineResource(std::pmr::memory_resource* up = std::pmr::new_delete_resource());
+
+    void* do_allocate(size_t bytes, size_t alignment) override;
+
+    void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
+
+    void* do_reallocate(void* ptr, size_t bytes);
+
+    void* AllocateInline(void* SrcPtr, size_t Bytes, size_t Alignment = alignof(std::max_align_t));
+
+    [[nodiscard]] inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
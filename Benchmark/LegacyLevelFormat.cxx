@@ -0,0 +1,52 @@
+#include "LegacyLevelFormat.hxx"
+
+#include "Serialization.hxx"
+
+void LegacyLevelFormat::Serialize(const STilemap& Level, std::ostream& Stream)
+{
+    Serialization::Write32(Stream, Level.Width);
+    Serialization::Write32(Stream, Level.Height);
+
+    for (uint32_t Index = 0; Index < ETilemapFormat::LegacyTileCount; ++Index)
+    {
+        STile Tile{};
+        if (Index < Level.TileCount())
+        {
+            auto Coords = Level.IndexToCoords(Index);
+            Tile = Level.Tiles.Get(Coords.X, Coords.Y);
+        }
+        Serialization::Write32(Stream, Tile.Flags);
+        Serialization::Write32(Stream, Tile.SpecialFlags);
+        Serialization::Write32(Stream, Tile.EdgeFlags);
+        Serialization::Write32(Stream, Tile.SpecialEdgeFlags);
+    }
+
+    Serialization::Write32(Stream, Level.bUseWallJoints);
+}
+
+bool LegacyLevelFormat::Deserialize(STilemap& Level, std::istream& Stream)
+{
+    Serialization::Read32(Stream, Level.Width);
+    Serialization::Read32(Stream, Level.Height);
+
+    Level.Tiles.Clear();
+    for (uint32_t Index = 0; Index < ETilemapFormat::LegacyTileCount; ++Index)
+    {
+        STile Tile;
+        Serialization::Read32(Stream, Tile.Flags);
+        Serialization::Read32(Stream, Tile.SpecialFlags);
+        Serialization::Read32(Stream, Tile.EdgeFlags);
+        Serialization::Read32(Stream, Tile.SpecialEdgeFlags);
+        if (Index < Level.TileCount())
+        {
+            auto Coords = Level.IndexToCoords(Index);
+            Level.Tiles.Set(Coords.X, Coords.Y, Tile);
+        }
+    }
+
+    Serialization::Read32(Stream, Level.bUseWallJoints);
+
+    Level.PostProcess();
+
+    return !Stream.fail();
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <istream>
+#include <ostream>
+#include "Tilemap.hxx"
+
+/* The level format and loader from before .erm v2 and SpanReader: Width, Height, all LegacyTileCount tiles and
+ * bUseWallJoints, each field read separately from the stream. Kept only so LevelLoadBenchmark has something to compare against. */
+namespace LegacyLevelFormat
+{
+    void Serialize(const STilemap& Level, std::ostream& Stream);
+
+    bool Deserialize(STilemap& Level, std::istream& Stream);
+}
@@ -0,0 +1,131 @@
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+#include "Benchmark.hxx"
+#include "LegacyLevelFormat.hxx"
+#include "Memory.hxx"
+#include "Serialization.hxx"
+#include "Tilemap.hxx"
+
+/* Loads Floor0-Floor3 over and over, straight from memory with SpanReader and through a std::istream over the same bytes.
+ * The levels are also saved in the legacy format, to compare with the per-field stream loader that came before SpanReader. */
+
+static constexpr int Loads = 10000;
+
+using SFile = std::vector<uint8_t>;
+
+static SFile ReadFile(const std::filesystem::path& Path)
+{
+    std::ifstream Stream(Path, std::ios::binary);
+    return SFile(std::istreambuf_iterator<char>(Stream), std::istreambuf_iterator<char>());
+}
+
+static bool LoadWithSpanReader(const std::vector<SFile>& Files)
+{
+    auto bLoaded = true;
+    for (int Load = 0; Load < Loads; ++Load)
+    {
+        for (auto& File : Files)
+        {
+            STilemap Level;
+            Serialization::SpanReader Reader(File.data(), File.size());
+            bLoaded &= Level.Deserialize(Reader);
+            Memory::NextFrame();
+        }
+    }
+    return bLoaded;
+}
+
+static bool LoadWithStream(const std::vector<SFile>& Files)
+{
+    auto bLoaded = true;
+    for (int Load = 0; Load < Loads; ++Load)
+    {
+        for (auto& File : Files)
+        {
+            STilemap Level;
+            Serialization::MemoryStream Stream(reinterpret_cast<const char*>(File.data()), File.size());
+            bLoaded &= Level.Deserialize(Stream);
+            Memory::NextFrame();
+        }
+    }
+    return bLoaded;
+}
+
+static bool LoadWithLegacyStream(const std::vector<SFile>& Files)
+{
+    auto bLoaded = true;
+    for (int Load = 0; Load < Loads; ++Load)
+    {
+        for (auto& File : Files)
+        {
+            STilemap Level;
+            Serialization::MemoryStream Stream(reinterpret_cast<const char*>(File.data()), File.size());
+            bLoaded &= LegacyLevelFormat::Deserialize(Level, Stream);
+            Memory::NextFrame();
+        }
+    }
+    return bLoaded;
+}
+
+static bool Run(const char* Name, const std::vector<SFile>& Files, bool bLegacy)
+{
+    auto bLoaded = true;
+    char Label[64];
+    if (bLegacy)
+    {
+        std::snprintf(Label, sizeof(Label), "%s, per-field std::istream (old)", Name);
+        Benchmark::Report(Label, Benchmark::Measure(1, [&] { bLoaded &= LoadWithLegacyStream(Files); }));
+    }
+    std::snprintf(Label, sizeof(Label), "%s, SpanReader", Name);
+    Benchmark::Report(Label, Benchmark::Measure(1, [&] { bLoaded &= LoadWithSpanReader(Files); }));
+    std::snprintf(Label, sizeof(Label), "%s, std::istream", Name);
+    Benchmark::Report(Label, Benchmark::Measure(1, [&] { bLoaded &= LoadWithStream(Files); }));
+    return bLoaded;
+}
+
+int main()
+{
+    namespace fs = std::filesystem;
+
+    std::vector<SFile> Shipped;
+    std::vector<SFile> Resaved;
+    std::vector<SFile> Legacy;
+    auto TempPath = fs::temp_directory_path() / "LevelLoadBenchmark.erm";
+    for (auto Name : { "Floor0.erm", "Floor1.erm", "Floor2.erm", "Floor3.erm" })
+    {
+        Shipped.push_back(ReadFile(fs::path(EQUINOX_REACH_ASSET_PATH) / "Map" / Name));
+
+        STilemap Level;
+        Serialization::SpanReader Reader(Shipped.back().data(), Shipped.back().size());
+        if (!Level.Deserialize(Reader))
+        {
+            std::printf("Failed to load %s\n", Name);
+            return 1;
+        }
+        {
+            std::ofstream Stream(TempPath, std::ios::binary);
+            Level.Serialize(Stream);
+        }
+        Resaved.push_back(ReadFile(TempPath));
+
+        std::ostringstream LegacyStream;
+        LegacyLevelFormat::Serialize(Level, LegacyStream);
+        auto LegacyBytes = LegacyStream.str();
+        Legacy.emplace_back(LegacyBytes.begin(), LegacyBytes.end());
+    }
+    std::error_code Error;
+    fs::remove(TempPath, Error);
+    std::printf("Floor0-Floor3, each loaded %d times\n", Loads);
+
+    auto bLoaded = Run("Shipped files", Shipped, false);
+    bLoaded &= Run("Re-saved files", Resaved, false);
+    bLoaded &= Run("Legacy files", Legacy, true);
+    if (!bLoaded)
+    {
+        std::printf("Some of the loads failed\n");
+    }
+    return bLoaded ? 0 : 1;
+}
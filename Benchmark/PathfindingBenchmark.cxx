@@ -0,0 +1,124 @@
+#include <memory>
+#include <random>
+#include <vector>
+#include "Benchmark.hxx"
+#include "Memory.hxx"
+#include "Pathfinding.hxx"
+#include "World.hxx"
+
+/* A* queries and flow field builds over generated mazes from 32x32 up to 1024x1024. */
+
+static constexpr int Repetitions = 3;
+static constexpr int PathQueries = 20;
+
+/* Every tile a floor, walls on every edge except the ones a depth-first walk carves through, then a few more knocked out so
+ * there are loops and A* has choices to make. */
+static void GenerateMaze(STilemap& Level, int Size, std::mt19937& Random)
+{
+    Level.Width = Size;
+    Level.Height = Size;
+    auto Cell = STile::Floor();
+    for (auto& Direction : SDirection::All())
+    {
+        Cell.SetWall(Direction);
+    }
+    for (int Y = 0; Y < Size; ++Y)
+    {
+        for (int X = 0; X < Size; ++X)
+        {
+            Level.Tiles.Set(X, Y, Cell);
+        }
+    }
+
+    auto Carve = [&](const SVec2Int& Coords, SDirection Direction) {
+        Level.GetTileAtMutable(Coords)->ClearEdgeFlags(Direction);
+        Level.GetTileAtMutable(Coords + Direction.GetVector<int>())->ClearEdgeFlags(Direction.Inverted());
+    };
+
+    std::vector<uint8_t> Visited((std::size_t)Size * Size);
+    std::vector<SVec2Int> Stack{ { 0, 0 } };
+    Visited[0] = 1;
+    while (!Stack.empty())
+    {
+        auto Coords = Stack.back();
+        SDirection Options[4];
+        int OptionCount = 0;
+        for (auto& Direction : SDirection::All())
+        {
+            auto Next = Coords + Direction.GetVector<int>();
+            if (Level.IsValidTile(Next) && !Visited[Level.CoordsToIndex(Next)])
+            {
+                Options[OptionCount++] = Direction;
+            }
+        }
+        if (OptionCount == 0)
+        {
+            Stack.pop_back();
+            continue;
+        }
+        auto Direction = Options[Random() % OptionCount];
+        auto Next = Coords + Direction.GetVector<int>();
+        Carve(Coords, Direction);
+        Visited[Level.CoordsToIndex(Next)] = 1;
+        Stack.push_back(Next);
+    }
+
+    for (int Loop = 0; Loop < Size * Size / 20; ++Loop)
+    {
+        auto Coords = SVec2Int{ (int)(Random() % (Size - 1)), (int)(Random() % (Size - 1)) };
+        Carve(Coords, Random() % 2 ? SDirection::East() : SDirection::South());
+    }
+
+    Level.PostProcess();
+}
+
+static void Run(int Size)
+{
+    std::mt19937 Random(5);
+    auto Level = std::make_unique<SWorldLevel>();
+    GenerateMaze(*Level, Size, Random);
+
+    auto RandomCoords = [&] { return SVec2Int{ (int)(Random() % Size), (int)(Random() % Size) }; };
+    std::vector<std::pair<SVec2Int, SVec2Int>> Queries;
+    for (int Query = 0; Query < PathQueries; ++Query)
+    {
+        Queries.emplace_back(RandomCoords(), RandomCoords());
+    }
+    std::vector<SVec2Int> Targets;
+    for (std::size_t Target = 0; Target < CPathfinder::MaxFlowFields; ++Target)
+    {
+        Targets.push_back(RandomCoords());
+    }
+
+    CPathfinder Pathfinder;
+    std::size_t Steps{};
+    auto bFound = true;
+    auto PathMilliseconds = Benchmark::Measure(Repetitions, [&] {
+        Steps = 0;
+        for (auto& [Start, Goal] : Queries)
+        {
+            auto Path = Memory::GetVector<SDirection>();
+            bFound &= Pathfinder.FindPath(*Level, Start, Goal, Path);
+            Steps += Path.size();
+        }
+    });
+    auto FlowFieldMilliseconds = Benchmark::Measure(Repetitions, [&] {
+        Pathfinder.Invalidate();
+        for (auto& Target : Targets)
+        {
+            Benchmark::DoNotOptimize(Pathfinder.GetFlowField(*Level, Target));
+        }
+    });
+
+    std::printf("%4dx%-4d A*: %8.3f ms per path (%zu steps on average) | flow field: %8.3f ms per target%s\n", Size, Size,
+        PathMilliseconds / PathQueries, Steps / PathQueries, FlowFieldMilliseconds / Targets.size(), bFound ? "" : " (unreachable goals!)");
+}
+
+int main()
+{
+    for (int Size = 32; Size <= 1024; Size *= 2)
+    {
+        Run(Size);
+    }
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+#include "Benchmark.hxx"
+#include "LegacyInlineResource.hxx"
+#include "Memory.hxx"
+
+/* Decodes every PNG under Asset/ through stb_image, the way CRawImage does, and counts what its reallocations copy:
+ * once on CInlineResource with its growth fast paths and once on the linear block walk from before them.
+ * stb sizes its PNG buffers up front, so a second workload grows buffers in lockstep to make reallocations move. */
+
+struct SHeapCounters
+{
+    std::size_t Reallocations{};
+    std::size_t Moves{};
+    std::size_t BytesCopied{};
+};
+
+/* stb_image's allocation macros are fixed at compile time, so they go through whichever heap is current. */
+struct SHeap
+{
+    void* (*Allocate)(std::size_t Bytes){};
+    void* (*Reallocate)(void* Ptr, std::size_t Bytes){};
+    void (*Free)(void* Ptr){};
+};
+
+static SHeap CurrentHeap{};
+static SHeapCounters Counters{};
+
+template <typename TResource>
+static SHeap MakeHeap(TResource& InResource)
+{
+    static TResource* Resource{};
+    Resource = &InResource;
+    return SHeap{
+        [](std::size_t Bytes) { return Resource->do_allocate(Bytes, alignof(std::max_align_t)); },
+        [](void* Ptr, std::size_t Bytes) { return Resource->do_reallocate(Ptr, Bytes); },
+        [](void* Ptr) { Resource->do_deallocate(Ptr, 0, alignof(std::max_align_t)); }
+    };
+}
+
+static void* CountedReallocate(void* Ptr, std::size_t OldBytes, std::size_t NewBytes)
+{
+    auto NewPtr = Ptr != nullptr ? CurrentHeap.Reallocate(Ptr, NewBytes) : CurrentHeap.Allocate(NewBytes);
+    Counters.Reallocations++;
+    if (Ptr != nullptr && NewPtr != Ptr)
+    {
+        Counters.Moves++;
+        Counters.BytesCopied += std::min(OldBytes, NewBytes);
+    }
+    return NewPtr;
+}
+
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_ONLY_PNG
+#define STBI_NO_FAILURE_STRINGS
+#define STBI_MALLOC(Size) CurrentHeap.Allocate(Size)
+#define STBI_REALLOC_SIZED(Ptr, OldSize, NewSize) CountedReallocate(Ptr, OldSize, NewSize)
+#define STBI_FREE(Ptr) (Ptr != nullptr ? CurrentHeap.Free(Ptr) : (void)0)
+
+#include <stb/stb_image.h>
+
+static constexpr int Rounds = 20;
+static constexpr int GrowthRounds = 50;
+
+/* Interleaved live and freed blocks, like a heap that has been in use for a while. */
+template <typename TResource>
+static std::vector<void*> Fragment(TResource& Resource)
+{
+    std::vector<void*> Blocks;
+    uint32_t Seed = 1;
+    for (int Index = 0; Index < 3000; ++Index)
+    {
+        Seed = Seed * 1103515245 + 12345;
+        auto Block = Resource.do_allocate(256 + (Seed >> 8) % 4096, alignof(std::max_align_t));
+        if (Index % 2)
+        {
+            Blocks.push_back(Block);
+        }
+        else
+        {
+            Resource.do_deallocate(Block, 0, alignof(std::max_align_t));
+        }
+        Blocks.push_back(Resource.do_allocate(48, alignof(std::max_align_t)));
+    }
+    return Blocks;
+}
+
+template <typename TResource>
+static bool Run(TResource& Resource, const char* Name, const std::vector<std::vector<unsigned char>>& Files)
+{
+    auto Blocks = Fragment(Resource);
+    CurrentHeap = MakeHeap(Resource);
+    Counters = {};
+
+    auto bDecoded = true;
+    auto Milliseconds = Benchmark::Measure(1, [&] {
+        for (int Round = 0; Round < Rounds; ++Round)
+        {
+            for (auto& File : Files)
+            {
+                int Width, Height, Channels;
+                auto Data = stbi_load_from_memory(File.data(), (int)File.size(), &Width, &Height, &Channels, STBI_rgb_alpha);
+                bDecoded &= Data != nullptr;
+                stbi_image_free(Data);
+            }
+        }
+    });
+
+    std::printf("%s: %zu reallocations, %zu moved, %zu bytes copied\n", Name, Counters.Reallocations, Counters.Moves, Counters.BytesCopied);
+    Benchmark::Report(Name, Milliseconds);
+
+    for (auto Block : Blocks)
+    {
+        Resource.do_deallocate(Block, 0, alignof(std::max_align_t));
+    }
+    return bDecoded;
+}
+
+/* Four buffers grown 1.5x at a time up to 512 KiB, with a small allocation after every step, so no buffer stays at the heap tail. */
+template <typename TResource>
+static void RunGrowth(TResource& Resource, const char* Name)
+{
+    auto Blocks = Fragment(Resource);
+    CurrentHeap = MakeHeap(Resource);
+    Counters = {};
+
+    auto Milliseconds = Benchmark::Measure(1, [&] {
+        for (int Round = 0; Round < GrowthRounds; ++Round)
+        {
+            void* Buffers[4]{};
+            std::size_t Length = 64;
+            std::vector<void*> Small;
+            while (Length < 512 * 1024)
+            {
+                auto NewLength = Length + Length / 2;
+                for (auto& Buffer : Buffers)
+                {
+                    Buffer = CountedReallocate(Buffer, Length, NewLength);
+                    std::memset(static_cast<unsigned char*>(Buffer) + NewLength - 1, Round, 1);
+                    Small.push_back(CurrentHeap.Allocate(48));
+                }
+                Length = NewLength;
+            }
+            for (auto Buffer : Buffers)
+            {
+                CurrentHeap.Free(Buffer);
+            }
+            for (auto Block : Small)
+            {
+                CurrentHeap.Free(Block);
+            }
+        }
+    });
+
+    std::printf("%s: %zu reallocations, %zu moved, %zu bytes copied\n", Name, Counters.Reallocations, Counters.Moves, Counters.BytesCopied);
+    Benchmark::Report(Name, Milliseconds);
+
+    for (auto Block : Blocks)
+    {
+        Resource.do_deallocate(Block, 0, alignof(std::max_align_t));
+    }
+}
+
+int main()
+{
+    std::vector<std::vector<unsigned char>> Files;
+    for (auto& Entry : std::filesystem::recursive_directory_iterator(EQUINOX_REACH_ASSET_PATH))
+    {
+        if (Entry.is_regular_file() && Entry.path().extension() == ".png")
+        {
+            std::ifstream Stream(Entry.path(), std::ios::binary);
+            Files.emplace_back(std::istreambuf_iterator<char>(Stream), std::istreambuf_iterator<char>());
+        }
+    }
+    std::printf("%zu PNGs, decoded %d times each\n", Files.size(), Rounds);
+
+    /* 16 MiB each, too much for the stack. */
+    auto Legacy = std::make_unique<CLegacyInlineResource>();
+    auto Current = std::make_unique<CInlineResource>();
+
+    auto bDecoded = Run(*Legacy, "Linear block walk", Files);
+    bDecoded &= Run(*Current, "Growth fast paths", Files);
+
+    std::printf("4 buffers grown 1.5x in lockstep, %d times\n", GrowthRounds);
+    RunGrowth(*Legacy, "Lockstep growth, linear block walk");
+    RunGrowth(*Current, "Lockstep growth, growth fast paths");
+    if (!bDecoded)
+    {
+        std::printf("Failed to decode some of the PNGs\n");
+    }
+    return bDecoded ? 0 : 1;
+}
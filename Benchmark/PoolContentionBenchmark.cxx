@@ -0,0 +1,82 @@
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+#include "Benchmark.hxx"
+#include "Memory.hxx"
+
+/* Small-block churn from N threads at once, on the thread-cached pool and on the synchronized pool it replaced. Both sit on the inline resource. */
+
+static constexpr int Repetitions = 3;
+static constexpr int OperationsPerThread = 200000;
+static constexpr std::size_t LiveBlocksPerThread = 64;
+
+static void Churn(std::pmr::memory_resource& Resource, unsigned Seed)
+{
+    struct SBlock
+    {
+        void* Ptr{};
+        std::size_t Bytes{};
+    };
+
+    std::mt19937 Random(Seed);
+    SBlock Live[LiveBlocksPerThread]{};
+    for (int Operation = 0; Operation < OperationsPerThread; ++Operation)
+    {
+        auto& Block = Live[Random() % LiveBlocksPerThread];
+        if (Block.Ptr != nullptr)
+        {
+            Resource.deallocate(Block.Ptr, Block.Bytes);
+        }
+        Block.Bytes = Random() % 497 + 16;
+        Block.Ptr = Resource.allocate(Block.Bytes);
+        Benchmark::DoNotOptimize(Block.Ptr);
+    }
+    for (auto& Block : Live)
+    {
+        if (Block.Ptr != nullptr)
+        {
+            Resource.deallocate(Block.Ptr, Block.Bytes);
+        }
+    }
+}
+
+static double Run(std::pmr::memory_resource& Resource, std::size_t ThreadCount)
+{
+    return Benchmark::Measure(Repetitions, [&] {
+        std::atomic<bool> bStart{};
+        std::vector<std::thread> Threads;
+        for (std::size_t Thread = 0; Thread < ThreadCount; ++Thread)
+        {
+            Threads.emplace_back([&, Thread] {
+                while (!bStart.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                Churn(Resource, (unsigned)Thread + 1);
+            });
+        }
+        bStart.store(true, std::memory_order_release);
+        for (auto& Thread : Threads)
+        {
+            Thread.join();
+        }
+    });
+}
+
+int main()
+{
+    std::pmr::synchronized_pool_resource SynchronizedPool(Memory::GetInlineResource());
+    CThreadCachedResource ThreadCachedPool(Memory::GetInlineResource());
+
+    auto MaxThreads = std::max<std::size_t>(std::thread::hardware_concurrency(), 8);
+    for (std::size_t ThreadCount = 1; ThreadCount <= MaxThreads; ThreadCount *= 2)
+    {
+        char Label[64];
+        std::snprintf(Label, sizeof(Label), "%zu threads, synchronized pool", ThreadCount);
+        Benchmark::Report(Label, Run(SynchronizedPool, ThreadCount));
+        std::snprintf(Label, sizeof(Label), "%zu threads, thread-cached pool", ThreadCount);
+        Benchmark::Report(Label, Run(ThreadCachedPool, ThreadCount));
+    }
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <memory>
+#include <random>
+#include "Benchmark.hxx"
+#include "Memory.hxx"
+#include "Tilemap.hxx"
+
+/* Rebuilding bitplanes, adjacency and wall joints of a 1024x1024 level: all of it with PostProcess, and edit-sized rects with PostProcessRegion. */
+
+static constexpr int Size = 1024;
+static constexpr int Repetitions = 5;
+static constexpr int RegionsPerRun = 100;
+
+int main()
+{
+    auto Level = std::make_unique<STilemap>();
+    Level->Width = Size;
+    Level->Height = Size;
+    std::mt19937 Random(3);
+    for (int Y = 0; Y < Size; ++Y)
+    {
+        for (int X = 0; X < Size; ++X)
+        {
+            Level->Tiles.Set(X, Y, Random() % 4 ? STile::Floor() : STile::WallWE());
+        }
+    }
+
+    Benchmark::Report("PostProcess, 1024x1024", Benchmark::Measure(Repetitions, [&] {
+        Level->PostProcess();
+        Memory::NextFrame();
+    }));
+
+    for (int RectSize : { 1, 16, 64, 256 })
+    {
+        auto Milliseconds = Benchmark::Measure(Repetitions, [&] {
+            for (int Region = 0; Region < RegionsPerRun; ++Region)
+            {
+                auto Min = SVec2Int{ (int)(Random() % (Size - RectSize + 1)), (int)(Random() % (Size - RectSize + 1)) };
+                Level->PostProcessRegion(SRectInt{ Min, Min + SVec2Int{ RectSize - 1, RectSize - 1 } });
+                Memory::NextFrame();
+            }
+        });
+        char Label[64];
+        std::snprintf(Label, sizeof(Label), "PostProcessRegion, %d %dx%d rects", RegionsPerRun, RectSize, RectSize);
+        Benchmark::Report(Label, Milliseconds);
+    }
+    return 0;
+}
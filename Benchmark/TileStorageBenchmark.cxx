@@ -0,0 +1,86 @@
+#include <memory>
+#include <random>
+#include <vector>
+#include "Benchmark.hxx"
+#include "Tilemap.hxx"
+
+/* Sequential and random tile reads from the chunked level storage and from a flat array holding the same tiles. */
+
+static constexpr int Repetitions = 5;
+static constexpr std::size_t RandomReads = 1 << 20;
+
+static void Run(int Size)
+{
+    auto Level = std::make_unique<STilemap>();
+    Level->Width = Size;
+    Level->Height = Size;
+    std::vector<STile> Flat((std::size_t)Size * Size);
+    std::mt19937 Random(1);
+    for (int Y = 0; Y < Size; ++Y)
+    {
+        for (int X = 0; X < Size; ++X)
+        {
+            auto Flags = Random() & 0xFF;
+            Level->GetTileAtMutable({ X, Y })->Flags = Flags;
+            Flat[(std::size_t)Y * Size + X].Flags = Flags;
+        }
+    }
+    std::vector<SVec2Int> RandomCoords(RandomReads);
+    for (auto& Coords : RandomCoords)
+    {
+        Coords = { (int)(Random() % Size), (int)(Random() % Size) };
+    }
+    /* Same bounds check as GetTileAt, so only the storage differs. */
+    auto GetFlat = [&](const SVec2Int& Coords) {
+        return Coords.X >= 0 && Coords.X < Size && Coords.Y >= 0 && Coords.Y < Size ? &Flat[(std::size_t)Coords.Y * Size + Coords.X] : nullptr;
+    };
+
+    uint64_t ChunkedSum{};
+    uint64_t FlatSum{};
+    auto SequentialChunked = Benchmark::Measure(Repetitions, [&] {
+        for (int Y = 0; Y < Size; ++Y)
+        {
+            for (int X = 0; X < Size; ++X)
+            {
+                ChunkedSum += Level->GetTileAt({ X, Y })->Flags;
+            }
+        }
+    });
+    auto SequentialFlat = Benchmark::Measure(Repetitions, [&] {
+        for (int Y = 0; Y < Size; ++Y)
+        {
+            for (int X = 0; X < Size; ++X)
+            {
+                FlatSum += GetFlat({ X, Y })->Flags;
+            }
+        }
+    });
+    auto RandomChunked = Benchmark::Measure(Repetitions, [&] {
+        for (auto& Coords : RandomCoords)
+        {
+            ChunkedSum += Level->GetTileAt(Coords)->Flags;
+        }
+    });
+    auto RandomFlat = Benchmark::Measure(Repetitions, [&] {
+        for (auto& Coords : RandomCoords)
+        {
+            FlatSum += GetFlat(Coords)->Flags;
+        }
+    });
+    Benchmark::DoNotOptimize(ChunkedSum);
+    Benchmark::DoNotOptimize(FlatSum);
+
+    auto TileCount = (double)Size * Size;
+    std::printf("%4dx%-4d sequential: chunked %.2f ns, flat %.2f ns | random: chunked %.2f ns, flat %.2f ns per read%s\n", Size, Size,
+        SequentialChunked * 1e6 / TileCount, SequentialFlat * 1e6 / TileCount, RandomChunked * 1e6 / RandomReads, RandomFlat * 1e6 / RandomReads,
+        ChunkedSum == FlatSum ? "" : " (sums differ!)");
+}
+
+int main()
+{
+    for (int Size : { 32, 256, 1024 })
+    {
+        Run(Size);
+    }
+    return 0;
+}
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <string>
 #include <array>
+#include <utility>
 #include "Utility.hxx"
 #include "Memory.hxx"
 
@@ -16,9 +17,9 @@
 #define STBI_NO_HDR
 #define STBI_NO_TGA
 #define STBI_NO_FAILURE_STRINGS
-#define STBI_MALLOC Memory::Malloc
-#define STBI_REALLOC Memory::Realloc
-#define STBI_FREE Memory::Free
+#define STBI_MALLOC(Size) Memory::Malloc(Size, EMemoryTag::Image)
+#define STBI_REALLOC(Ptr, Size) Memory::Realloc(Ptr, Size, EMemoryTag::Image)
+#define STBI_FREE(Ptr) Memory::Free(Ptr)
 
 #include <stb/stb_image.h>
 
@@ -44,10 +45,10 @@ SAsset::SAsset(const char* InData, size_t InLength)
 CRawMesh::CRawMesh(const SAsset& Resource)
     : Positions(Memory::GetVector<SVec3>()), TexCoords(Memory::GetVector<SVec2>()), Normals(Memory::GetVector<SVec3>()), Indices(Memory::GetVector<unsigned short>())
 {
-    auto ScratchPositions = Memory::GetVector<SVec3>();
-    auto ScratchTexCoords = Memory::GetVector<SVec2>();
-    auto ScratchNormals = Memory::GetVector<SVec3>();
-    auto ScratchOBJIndices = Memory::GetVector<SVec3Size>();
+    auto ScratchPositions = Memory::GetFrameVector<SVec3>();
+    auto ScratchTexCoords = Memory::GetFrameVector<SVec2>();
+    auto ScratchNormals = Memory::GetFrameVector<SVec3>();
+    auto ScratchOBJIndices = Memory::GetFrameVector<SVec3Size>();
 
     Positions.clear();
     Normals.clear();
@@ -135,6 +136,24 @@ CRawImage::CRawImage(const SAsset& Resource)
         4);
 }
 
+CRawImage::CRawImage(CRawImage&& Other) noexcept
+    : Width(Other.Width), Height(Other.Height), Channels(Other.Channels), Data(std::exchange(Other.Data, nullptr))
+{
+}
+
+CRawImage& CRawImage::operator=(CRawImage&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        stbi_image_free(Data);
+        Width = Other.Width;
+        Height = Other.Height;
+        Channels = Other.Channels;
+        Data = std::exchange(Other.Data, nullptr);
+    }
+    return *this;
+}
+
 CRawImage::~CRawImage()
 {
     stbi_image_free(Data);
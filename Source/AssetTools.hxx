@@ -61,7 +61,10 @@ public:
     int Channels{};
     void* Data{};
 
+    CRawImage() = default;
     explicit CRawImage(const SAsset& Resource);
+    CRawImage(CRawImage&& Other) noexcept;
+    CRawImage& operator=(CRawImage&& Other) noexcept;
     ~CRawImage();
 };
 
@@ -1,6 +1,7 @@
 #include "DevTools.hxx"
 
 #include <fstream>
+#include <algorithm>
 #include <glad/gl.h>
 #include <imgui/imgui.h>
 #include <imgui/imgui_internal.h>
@@ -13,11 +14,13 @@
 #include "Game.hxx"
 #include "GameSystem.hxx"
 #include "AssetTools.hxx"
+#include "Jobs.hxx"
 #include "Utility.hxx"
 #include "World.hxx"
 #include "Log.hxx"
 #include "Math.hxx"
 #include "Memory.hxx"
+#include "Platform.hxx"
 #include "SDL_video.h"
 
 #define PARTY_SLOT_COLOR (ImGui::GetColorU32(IM_COL32(100, 75, 230, 200)))
@@ -451,6 +454,7 @@ void SLevelEditor::Init(SGame* InGame)
 
 void SLevelEditor::Cleanup()
 {
+    VisibilityBaker.Wait();
     Game = nullptr;
     Framebuffer.Cleanup();
 }
@@ -538,26 +542,27 @@ void SLevelEditor::EditorUpdate()
         }
         if (LevelEditorMode == ELevelEditorMode::Block)
         {
-            if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)))
-            {
-                Level.EditBlock(SRectInt::FromTwo(SelectedTileCoords, BlockModeTileCoords), TILE_FLOOR_BIT);
+            auto EditBlock = [&, this](ETileFlag Flag) {
+                auto Rect = SRectInt::FromTwo(SelectedTileCoords, BlockModeTileCoords);
+                for (auto& Range : Level.EditBlock(Rect, Flag))
+                {
+                    Level.MarkEdited(Range.X, Range.Y);
+                }
                 LevelEditorMode = ELevelEditorMode::Normal;
                 bEditorStateChanged = true;
                 bLevelChanged = true;
+            };
+            if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)))
+            {
+                EditBlock(TILE_FLOOR_BIT);
             }
             if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_C)))
             {
-                Level.EditBlock(SRectInt::FromTwo(SelectedTileCoords, BlockModeTileCoords), 0);
-                LevelEditorMode = ELevelEditorMode::Normal;
-                bEditorStateChanged = true;
-                bLevelChanged = true;
+                EditBlock(0);
             }
             if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_H)))
             {
-                Level.EditBlock(SRectInt::FromTwo(SelectedTileCoords, BlockModeTileCoords), TILE_HOLE_BIT);
-                LevelEditorMode = ELevelEditorMode::Normal;
-                bEditorStateChanged = true;
-                bLevelChanged = true;
+                EditBlock(TILE_HOLE_BIT);
             }
         }
         else if (LevelEditorMode == ELevelEditorMode::Normal)
@@ -565,16 +570,19 @@ void SLevelEditor::EditorUpdate()
             if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Space)))
             {
                 Level.Edit(SelectedTileCoords, TILE_FLOOR_BIT);
+                Level.MarkEdited(SRectInt{ SelectedTileCoords, SelectedTileCoords });
                 bLevelChanged = true;
             }
             if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_C)))
             {
                 Level.Edit(SelectedTileCoords, 0);
+                Level.MarkEdited(SRectInt{ SelectedTileCoords, SelectedTileCoords });
                 bLevelChanged = true;
             }
             if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_H)))
             {
                 Level.Edit(SelectedTileCoords, TILE_HOLE_BIT);
+                Level.MarkEdited(SRectInt{ SelectedTileCoords, SelectedTileCoords });
                 bLevelChanged = true;
             }
             if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_D)))
@@ -600,6 +608,7 @@ void SLevelEditor::EditorUpdate()
         {
             auto ToggleEdge = [&, this](SDirection Direction) {
                 Level.ToggleEdge(SelectedTileCoords, Direction, ToggleEdgeType);
+                Level.MarkEdited(SRectInt{ SelectedTileCoords, SelectedTileCoords });
                 LevelEditorMode = ELevelEditorMode::Normal;
                 bEditorStateChanged = true;
                 bLevelChanged = true;
@@ -623,6 +632,9 @@ void SLevelEditor::EditorUpdate()
         }
     }
 
+    /* Nothing draws it here, the masks only have to be current by the time the level is imported. */
+    VisibilityBaker.Update(Level.Visibility, Level, Level.VisibilityDirtyRects);
+
     if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Home)) || ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_Keypad7)) || bResetView)
     {
         Scale = std::min(WindowSize.x / (float)OriginalMapSize.X, WindowSize.y / (float)OriginalMapSize.Y);
@@ -715,6 +727,8 @@ void SLevelEditor::EditorTools()
         if (ImGui::Button("Accept"))
         {
             Level = SWorldLevel{ { NewLevelSize.X, NewLevelSize.Y } };
+            VisibilityBaker.Cancel();
+            SavedPath.clear();
             bLevelChanged = true;
             bResetView = true;
             ImGui::CloseCurrentPopup();
@@ -854,8 +868,14 @@ void SLevelEditor::EditorTools()
         {
             if (ImGui::TreeNode(SDirection::Names[Direction]))
             {
-                ImGui::CheckboxFlags("Wall", &SelectedTile->EdgeFlags, STile::DirectionBit(TILE_EDGE_WALL_BIT, SDirection{ Direction }));
-                ImGui::CheckboxFlags("Door", &SelectedTile->EdgeFlags, STile::DirectionBit(TILE_EDGE_DOOR_BIT, SDirection{ Direction }));
+                auto bChanged = ImGui::CheckboxFlags("Wall", &SelectedTile->EdgeFlags, STile::DirectionBit(TILE_EDGE_WALL_BIT, SDirection{ Direction }));
+                bChanged |= ImGui::CheckboxFlags("Door", &SelectedTile->EdgeFlags, STile::DirectionBit(TILE_EDGE_DOOR_BIT, SDirection{ Direction }));
+                if (bChanged)
+                {
+                    auto Index = Level.CoordsToIndex(SelectedTileCoords);
+                    Level.MarkEdited(Index, Index);
+                    Level.PostProcessRegion(SRectInt{ SelectedTileCoords, SelectedTileCoords });
+                }
                 ImGui::TreePop();
                 ImGui::Spacing();
             }
@@ -866,24 +886,193 @@ void SLevelEditor::EditorTools()
 
 void SLevelEditor::SaveTilemapToFile(const class std::filesystem::path& Path)
 {
+    namespace fs = std::filesystem;
+
     Validate(true);
     bLevelChanged = true;
 
-    const auto& Tilemap = Level;
+    ReplayPatchJournal(Path);
+
+    /* Only patch files we wrote ourselves and nobody touched since. */
+    std::error_code Error;
+    bool bCanPatch = Path == SavedPath && fs::last_write_time(Path, Error) == SavedWriteTime && !Error;
+    if (!(bCanPatch && PatchTilemapFile(Path)) && !WriteTilemapFile(Path))
+    {
+        return;
+    }
+
+    SavedPath = Path;
+    SavedWriteTime = fs::last_write_time(Path, Error);
+    Level.SaveDirtySpans.Clear();
+}
+
+static std::filesystem::path GetJournalPath(const std::filesystem::path& Path)
+{
+    auto JournalPath = Path;
+    JournalPath += ".journal";
+    return JournalPath;
+}
 
-    std::ofstream TilemapFile;
-    TilemapFile.open(Path, std::ofstream::binary);
-    Tilemap.Serialize(TilemapFile);
+/* Writes a sealed journal into the map in place and waits for it to reach the disk. */
+static bool ApplyPatchJournal(const std::filesystem::path& Path, const uint8_t* Journal, std::size_t Length)
+{
+    std::fstream TilemapFile(Path, std::fstream::in | std::fstream::out | std::fstream::binary);
+    if (!TilemapFile || !STilemap::ApplyPatchJournal(Journal, Length, TilemapFile))
+    {
+        return false;
+    }
     TilemapFile.close();
+    return !TilemapFile.fail() && SyncFile(Path);
+}
+
+bool SLevelEditor::PatchTilemapFile(const std::filesystem::path& Path)
+{
+    namespace fs = std::filesystem;
+
+    if (!Level.IsSaveDirty())
+    {
+        return true;
+    }
+
+    STilemapFileLayout Layout{};
+    {
+        CMappedFile TilemapFile(Path);
+        auto Asset = TilemapFile.Asset();
+        Serialization::SpanReader Reader(Asset.Data, Asset.Length);
+        if (!TilemapFile.IsValid() || !STilemap::ReadFileLayout(Reader, Layout))
+        {
+            return false;
+        }
+    }
+
+    if (!Level.CanPatch(Layout, Level.SaveDirtySpans))
+    {
+        return false;
+    }
+
+    /* The patch reaches the disk as a journal before the map is touched. Cut short before that, the map is as it was;
+     * cut short after, ReplayPatchJournal finishes it on the next load or save. */
+    auto Journal = Memory::GetFrameVector<uint8_t>();
+    Level.SerializePatch(Journal, Layout, Level.SaveDirtySpans);
+    auto JournalPath = GetJournalPath(Path);
+    {
+        std::ofstream JournalFile(JournalPath, std::ofstream::binary | std::ofstream::trunc);
+        JournalFile.write(reinterpret_cast<const char*>(Journal.data()), (std::streamsize)Journal.size());
+        JournalFile.close();
+        if (!JournalFile || !SyncFile(JournalPath))
+        {
+            Log::DevTools<ELogLevel::Critical>("Failed to write %s", JournalPath.string().c_str());
+            std::error_code Error;
+            fs::remove(JournalPath, Error);
+            return false;
+        }
+    }
+
+    if (!ApplyPatchJournal(Path, Journal.data(), Journal.size()))
+    {
+        Log::DevTools<ELogLevel::Critical>("Failed to patch %s, the journal is kept for the next load", Path.string().c_str());
+        return false;
+    }
+    std::error_code Error;
+    fs::remove(JournalPath, Error);
+
+    Log::DevTools<ELogLevel::Debug>("Patched %zu tiles in %zu spans of %s", Level.SaveDirtySpans.TileCount(), Level.SaveDirtySpans.Count, Path.string().c_str());
+    return true;
+}
+
+void SLevelEditor::ReplayPatchJournal(const std::filesystem::path& Path)
+{
+    namespace fs = std::filesystem;
+
+    std::error_code Error;
+    auto JournalPath = GetJournalPath(Path);
+    if (!fs::exists(JournalPath, Error))
+    {
+        return;
+    }
+
+    auto bDone = false;
+    {
+        CMappedFile JournalFile(JournalPath);
+        auto Asset = JournalFile.Asset();
+        auto Data = reinterpret_cast<const uint8_t*>(Asset.Data);
+        if (!JournalFile.IsValid())
+        {
+            return;
+        }
+        if (!STilemap::IsPatchJournalSealed(Data, Asset.Length))
+        {
+            /* Never finished, so the map was never touched. */
+            Log::DevTools<ELogLevel::Info>("Dropping the unfinished patch journal of %s", Path.string().c_str());
+            bDone = true;
+        }
+        else if (ApplyPatchJournal(Path, Data, Asset.Length))
+        {
+            Log::DevTools<ELogLevel::Info>("Finished an interrupted save of %s", Path.string().c_str());
+            bDone = true;
+        }
+    }
+    if (bDone)
+    {
+        fs::remove(JournalPath, Error);
+    }
+}
+
+bool SLevelEditor::WriteTilemapFile(const std::filesystem::path& Path)
+{
+    namespace fs = std::filesystem;
+
+    /* Write next to the target and rename over it, so a failed save never leaves a half-written map. */
+    auto TempPath = Path;
+    TempPath += ".tmp";
+    {
+        std::ofstream TilemapFile(TempPath, std::ofstream::binary | std::ofstream::trunc);
+        Level.Serialize(TilemapFile, true);
+        TilemapFile.close();
+        if (!TilemapFile)
+        {
+            Log::DevTools<ELogLevel::Critical>("Failed to write %s", TempPath.string().c_str());
+            return false;
+        }
+    }
+
+    std::error_code Error;
+    fs::rename(TempPath, Path, Error);
+    if (Error)
+    {
+        Log::DevTools<ELogLevel::Critical>("Failed to replace %s: %s", Path.string().c_str(), Error.message().c_str());
+        fs::remove(TempPath, Error);
+        return false;
+    }
+
+    /* A journal left from an older patch would be replayed over the new contents. */
+    fs::remove(GetJournalPath(Path), Error);
+    return true;
 }
 
 void SLevelEditor::LoadTilemapFromFile(const std::filesystem::path& Path)
 {
     auto& Tilemap = Level;
-    std::ifstream TilemapFile;
-    TilemapFile.open(Path, std::ifstream::binary);
-    Tilemap.Deserialize(TilemapFile);
-    TilemapFile.close();
+    ReplayPatchJournal(Path);
+    CMappedFile TilemapFile(Path);
+    if (!TilemapFile.IsValid())
+    {
+        return;
+    }
+    auto Asset = TilemapFile.Asset();
+    Serialization::SpanReader Reader(Asset.Data, Asset.Length);
+    if (!Tilemap.Deserialize(Reader))
+    {
+        Log::DevTools<ELogLevel::Critical>("Failed to load %s", Path.string().c_str());
+        return;
+    }
+    std::error_code Error;
+    SavedPath = Path;
+    SavedWriteTime = std::filesystem::last_write_time(Path, Error);
+    Level.SaveDirtySpans.Clear();
+    Level.Visibility.Reset();
+    Level.VisibilityDirtyRects.Clear();
+    VisibilityBaker.Cancel();
     bLevelChanged = true;
     bResetView = true;
 }
@@ -921,43 +1110,118 @@ SValidationResult SLevelEditor::Validate(bool bFix)
         TargetLevel = &TempLevel;
     }
     SValidationResult Result;
-    SVec2Int Coords{};
 
-    auto ValidateEdge = [&](STile* CurrentTile, STile* NeighborTile, SDirection Direction, SDirection NeighborDirection, UFlagType EdgeBit, int* Corrections) {
-        if (CurrentTile->CheckEdgeFlag(EdgeBit, Direction))
+    /* Reads go through GetTileAt so validating doesn't allocate chunks for empty areas. */
+    auto ValidateEdge = [&](const STile* CurrentTile, SVec2Int NeighborCoords, SDirection Direction, UFlagType EdgeBit, int* Corrections) {
+        if (!CurrentTile->CheckEdgeFlag(EdgeBit, Direction))
+        {
+            return;
+        }
+        auto NeighborTile = TargetLevel->GetTileAtMutable(NeighborCoords);
+        if (NeighborTile != nullptr)
         {
+            auto NeighborDirection = Direction.Inverted();
             UFlagType Temp = NeighborTile->EdgeFlags;
             NeighborTile->ClearEdgeFlags(NeighborDirection);
             NeighborTile->SetEdgeFlag(EdgeBit, NeighborDirection);
             if (Temp != NeighborTile->EdgeFlags)
             {
                 *Corrections = *Corrections + 1;
+                auto Index = TargetLevel->CoordsToIndex(NeighborCoords);
+                TargetLevel->MarkEdited(Index, Index);
             }
         }
     };
 
-    for (; Coords.X < TargetLevel->Width; ++Coords.X)
+    /* Only tiles on a suspicious edge can change: both sides disagree, or the edge is a wall and a door at once.
+     * Find those 64 tiles at a time, then run the per-tile pass over them alone, in the same column-major order. */
+    TargetLevel->PostProcess();
+    const auto& Planes = TargetLevel->Bitplanes;
+    auto WordsPerRow = Planes.WordsPerRow;
+    auto Marked = Memory::GetFrameVector<uint64_t>();
+    Marked.assign(WordsPerRow * TargetLevel->Height, 0);
+    auto Mark = [&](int Y, std::size_t Word, uint64_t Bits) {
+        Marked[Y * WordsPerRow + Word] |= Bits << 1 | Bits;
+        if (Word + 1 < WordsPerRow)
+        {
+            Marked[Y * WordsPerRow + Word + 1] |= Bits >> 63;
+        }
+    };
+    for (int Y = 0; Y < TargetLevel->Height; ++Y)
     {
-        for (Coords.Y = 0; Coords.Y < TargetLevel->Height; ++Coords.Y)
+        auto WallEast = Planes.Row(ETileBitplane::WallEast, Y);
+        auto DoorEast = Planes.Row(ETileBitplane::DoorEast, Y);
+        auto WallWest = Planes.Row(ETileBitplane::WallWest, Y);
+        auto DoorWest = Planes.Row(ETileBitplane::DoorWest, Y);
+        auto WallSouth = Planes.Row(ETileBitplane::WallSouth, Y);
+        auto DoorSouth = Planes.Row(ETileBitplane::DoorSouth, Y);
+        auto Visited = Planes.Row(ETileBitplane::Visited, Y);
+        auto Explored = Planes.Row(ETileBitplane::Explored, Y);
+        auto bHasSouthRow = Y + 1 < TargetLevel->Height;
+        for (std::size_t Word = 0; Word < WordsPerRow; ++Word)
         {
-            auto CurrentTile = TargetLevel->GetTileAtMutable(Coords);
-
-            /* @TODO: Should validate these? */
-            CurrentTile->ClearSpecialFlag(TILE_SPECIAL_VISITED_BIT);
-            CurrentTile->ClearSpecialFlag(TILE_SPECIAL_EXPLORED_BIT);
+            /* West edges of the tiles to the right, shifted under their left neighbors. */
+            auto NextWallWest = WallWest[Word] >> 1 | (Word + 1 < WordsPerRow ? WallWest[Word + 1] << 63 : 0);
+            auto NextDoorWest = DoorWest[Word] >> 1 | (Word + 1 < WordsPerRow ? DoorWest[Word + 1] << 63 : 0);
+            auto LastColumn = (Word == (std::size_t)(TargetLevel->Width - 1) / 64) ? uint64_t(1) << ((TargetLevel->Width - 1) % 64) : 0;
+            auto East = ((WallEast[Word] ^ NextWallWest) | (DoorEast[Word] ^ NextDoorWest) | (WallEast[Word] & DoorEast[Word])) & ~LastColumn;
+            Mark(Y, Word, East);
+            Marked[Y * WordsPerRow + Word] |= Visited[Word] | Explored[Word];
+
+            if (bHasSouthRow)
+            {
+                auto WallNorth = Planes.Row(ETileBitplane::WallNorth, Y + 1)[Word];
+                auto DoorNorth = Planes.Row(ETileBitplane::DoorNorth, Y + 1)[Word];
+                auto South = (WallSouth[Word] ^ WallNorth) | (DoorSouth[Word] ^ DoorNorth) | (WallSouth[Word] & DoorSouth[Word]);
+                Marked[Y * WordsPerRow + Word] |= South;
+                Marked[(Y + 1) * WordsPerRow + Word] |= South;
+            }
+        }
+    }
 
-            for (auto& Direction : SDirection::All())
+    auto Candidates = Memory::GetFrameVector<SVec2Int>();
+    for (int Y = 0; Y < TargetLevel->Height; ++Y)
+    {
+        for (std::size_t Word = 0; Word < WordsPerRow; ++Word)
+        {
+            for (auto Bits = Marked[Y * WordsPerRow + Word]; Bits != 0; Bits &= Bits - 1)
             {
-                auto NeighborTile = TargetLevel->GetTileAtMutable(Coords + Direction.GetVector<int>());
-                if (NeighborTile != nullptr)
-                {
-                    auto NeighborDirection = Direction.Inverted();
-                    ValidateEdge(CurrentTile, NeighborTile, Direction, NeighborDirection, TILE_EDGE_WALL_BIT, &Result.Wall);
-                    ValidateEdge(CurrentTile, NeighborTile, Direction, NeighborDirection, TILE_EDGE_DOOR_BIT, &Result.Door);
-                }
+                Candidates.push_back({ (int)(Word * 64) + __builtin_ctzll(Bits), Y });
             }
         }
     }
+    std::sort(Candidates.begin(), Candidates.end(), [](const SVec2Int& A, const SVec2Int& B) {
+        return A.X != B.X ? A.X < B.X : A.Y < B.Y;
+    });
+
+    for (auto& Coords : Candidates)
+    {
+        auto CurrentTile = TargetLevel->GetTileAt(Coords);
+
+        /* @TODO: Should validate these? */
+        if (CurrentTile->CheckSpecialFlag(TILE_SPECIAL_VISITED_BIT) || CurrentTile->CheckSpecialFlag(TILE_SPECIAL_EXPLORED_BIT))
+        {
+            auto MutableTile = TargetLevel->GetTileAtMutable(Coords);
+            MutableTile->ClearSpecialFlag(TILE_SPECIAL_VISITED_BIT);
+            MutableTile->ClearSpecialFlag(TILE_SPECIAL_EXPLORED_BIT);
+            TargetLevel->Bitplanes.Set(ETileBitplane::Visited, Coords.X, Coords.Y, false);
+            TargetLevel->Bitplanes.Set(ETileBitplane::Explored, Coords.X, Coords.Y, false);
+            auto Index = TargetLevel->CoordsToIndex(Coords);
+            TargetLevel->MarkEdited(Index, Index);
+        }
+
+        for (auto& Direction : SDirection::All())
+        {
+            auto NeighborCoords = Coords + Direction.GetVector<int>();
+            ValidateEdge(CurrentTile, NeighborCoords, Direction, TILE_EDGE_WALL_BIT, &Result.Wall);
+            ValidateEdge(CurrentTile, NeighborCoords, Direction, TILE_EDGE_DOOR_BIT, &Result.Door);
+        }
+    }
+
+    if (Result.Wall + Result.Door > 0)
+    {
+        TargetLevel->PostProcess();
+    }
 
     Log::DevTools<ELogLevel::Critical>("[Validate] Successful!");
     Log::DevTools<ELogLevel::Critical>("[Validate] Corrections: Walls = %d, Doors = %d", Result.Wall, Result.Door);
@@ -1118,6 +1382,9 @@ void SDevTools::Update()
     ImGui_ImplSDL3_NewFrame();
     ImGui::NewFrame();
 
+    MemoryHistory[MemoryHistoryOffset] = (float)Memory::GetInlineStats().BytesLive / (1024.0f * 1024.0f);
+    MemoryHistoryOffset = (MemoryHistoryOffset + 1) % (int)MemoryHistory.size();
+
     if (ImGui::IsKeyPressed(ImGui::GetKeyIndex(ImGuiKey_F4)))
     {
         // Game.Renderer.ProgramHUD.Reload();
@@ -1188,7 +1455,87 @@ void SDevTools::ShowDebugTools() const
         {
             ImGui::Text("Frames Per Second: %.f", 1000.0f / Game->Platform.DeltaTime / 1000.0f);
             ImGui::Text("Number Of Blocks: %zu", Memory::NumberOfBlocks());
+            ImGui::Text("Frame Arena High-Water Mark: %zu / %zu bytes", Memory::FrameHighWaterMark(), FrameHeapSize);
+            ImGui::Text("Frame Arena Overflows: %zu", Memory::FrameOverflowCount());
             ImGui::Text("Display Scale: %d", Game->Renderer.MainFramebuffer.Scale);
+            ImGui::Text("Map Tile Uploads: %zu bytes in %zu calls last frame",
+                Game->Renderer.MapTilesTexture.LastFrameUploadBytes, Game->Renderer.MapTilesTexture.LastFrameUploadCalls);
+            ImGui::Text("Instance Uploads: %zu bytes last frame", Game->Renderer.InstanceBuffer.LastFrameUploadBytes);
+            ImGui::Text("Level Chunks: %d drawn, %zu in sight, %d total", Game->Renderer.LevelDrawData.VisibleChunkCount,
+                Game->Renderer.LevelDrawData.PotentiallyVisibleChunks.size(), Game->Renderer.LevelDrawData.TotalChunkCount());
+            ImGui::Text("Level Visibility: %zu bytes baked", Game->World.GetLevel()->Visibility.SizeBytes());
+            ImGui::Text("Draw Calls: %zu, State Changes: %zu last frame", Game->Renderer.LastFrameStats.DrawCalls, Game->Renderer.LastFrameStats.StateChanges);
+            ImGui::BeginDisabled(!Game->Renderer.IndirectDrawBuffer.bSupported);
+            ImGui::Checkbox("Multi-Draw Indirect", &Game->Renderer.bUseMultiDrawIndirect);
+            ImGui::EndDisabled();
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Memory"))
+        {
+            static constexpr float MiB = 1024.0f * 1024.0f;
+            auto Stats = Memory::GetInlineStats();
+            auto TopmostStats = Memory::GetTopmostStats();
+
+            ImGui::Text("Inline: %.2f / %.2f MiB, Peak: %.2f MiB", (float)Stats.BytesLive / MiB, (float)HeapSize / MiB, (float)Stats.PeakBytesLive / MiB);
+            ImGui::PlotLines("##InlineHistory", MemoryHistory.data(), (int)MemoryHistory.size(), MemoryHistoryOffset, nullptr, 0.0f, (float)HeapSize / MiB, ImVec2(0.0f, 60.0f));
+            ImGui::Text("Blocks Live: %zu, Allocations: %zu", Stats.BlocksLive, Stats.Allocations);
+            ImGui::Text("Largest Free Block: %zu bytes, Fragmentation: %.1f%%", Stats.LargestFreeBlock, Stats.GetFragmentation() * 100.0f);
+            ImGui::Text("Upstream Fallbacks: %zu, Upstream Live: %zu bytes", Stats.UpstreamFallbacks, Stats.UpstreamBytesLive);
+            ImGui::Text("Reallocations: %zu, In Place: %zu, Bytes Copied: %zu", Stats.Reallocations, Stats.ReallocationsInPlace, Stats.ReallocBytesCopied);
+            ImGui::Text("Topmost: %zu bytes live, %zu peak, %zu allocations", TopmostStats.BytesLive, TopmostStats.PeakBytesLive, TopmostStats.Allocations);
+
+            if (ImGui::BeginTable("MemoryTags", 4, ImGuiTableFlags_Borders))
+            {
+                ImGui::TableSetupColumn("Tag");
+                ImGui::TableSetupColumn("Allocations");
+                ImGui::TableSetupColumn("Blocks");
+                ImGui::TableSetupColumn("Bytes");
+                ImGui::TableHeadersRow();
+                for (std::size_t Index = 0; Index < Stats.Tags.size(); ++Index)
+                {
+                    auto& TagStats = Stats.Tags[Index];
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(Memory::GetTagName(EMemoryTag(Index)));
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", TagStats.Allocations);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", TagStats.BlocksLive);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", TagStats.BytesLive);
+                }
+                ImGui::EndTable();
+            }
+            ImGui::TreePop();
+        }
+        if (ImGui::TreeNode("Jobs"))
+        {
+            ImGui::Text("Threads: %zu", Jobs::GetThreadCount());
+            if (ImGui::BeginTable("JobTimings", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_ScrollY, ImVec2(0.0f, ImGui::GetFontSize() * 16.0f)))
+            {
+                ImGui::TableSetupColumn("Job");
+                ImGui::TableSetupColumn("Thread");
+                ImGui::TableSetupColumn("Frame");
+                ImGui::TableSetupColumn("Start (ms)");
+                ImGui::TableSetupColumn("Time (ms)");
+                ImGui::TableHeadersRow();
+                auto Timings = Jobs::GetRecentTimings();
+                for (auto Timing = Timings.rbegin(); Timing != Timings.rend(); ++Timing)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableNextColumn();
+                    ImGui::TextUnformatted(Timing->Name);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", Timing->Thread);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%zu", Timing->Frame);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", Timing->StartMilliseconds);
+                    ImGui::TableNextColumn();
+                    ImGui::Text("%.3f", Timing->Milliseconds);
+                }
+                ImGui::EndTable();
+            }
             ImGui::TreePop();
         }
         if (ImGui::TreeNode("Player Info"))
@@ -1217,8 +1564,9 @@ void SDevTools::ShowDebugTools() const
                         }
                     }
                 }
+                Level->Bitplanes.Build(*Level);
                 Level->DirtyFlags = ELevelDirtyFlags::All;
-                Level->DirtyRange = { 0, Level->TileCount() };
+                Level->DirtySpans.Add(0, Level->TileCount() - 1);
             }
             if (ImGui::Button("Visit Level"))
             {
@@ -1234,12 +1582,16 @@ void SDevTools::ShowDebugTools() const
                         }
                     }
                 }
+                Level->Bitplanes.Build(*Level);
                 Level->DirtyFlags = ELevelDirtyFlags::All;
-                Level->DirtyRange = { 0, Level->TileCount() };
+                Level->DirtySpans.Add(0, Level->TileCount() - 1);
             }
             if (ImGui::Button("Import Level From Editor"))
             {
-                Game->ChangeLevel(LevelEditor.Level);
+                /* A running rebake would be lost otherwise, the edits it covers are not dirty anymore. */
+                auto& Editor = Game->DevTools.LevelEditor;
+                Editor.VisibilityBaker.Apply(Editor.Level.Visibility, Editor.Level);
+                Game->ChangeLevel(Editor.Level);
             }
             ImGui::TreePop();
         }
@@ -72,10 +72,16 @@ struct SLevelEditor : SEditorBase
     SVec2Int SelectedTileCoords{};
     SVec2Int BlockModeTileCoords{};
     SWorldLevel Level{};
+    /* Keeps Level's visibility baked while editing, so it goes along when imported into the game. */
+    CVisibilityBaker VisibilityBaker{};
 
     bool bLevelChanged{};
     bool bEditorStateChanged{};
 
+    /* File the level was last loaded from or saved to; saves to it only patch the dirty tiles. */
+    std::filesystem::path SavedPath{};
+    std::filesystem::file_time_type SavedWriteTime{};
+
     void Init(SGame* InGame);
     void Cleanup();
 
@@ -86,6 +92,11 @@ struct SLevelEditor : SEditorBase
     void SaveTilemapToFile(const std::filesystem::path& Path);
     void LoadTilemapFromFile(const std::filesystem::path& Path);
 
+    bool PatchTilemapFile(const std::filesystem::path& Path);
+    /* Finishes a patch of Path that was cut short, or drops it if it never fully reached the disk. */
+    void ReplayPatchJournal(const std::filesystem::path& Path);
+    bool WriteTilemapFile(const std::filesystem::path& Path);
+
     void ScanForLevels();
 
     SVec2Int CalculateMapSize();
@@ -107,6 +118,10 @@ struct SDevTools
     SLevelEditor LevelEditor;
     SWorldEditor WorldEditor;
 
+    /* Inline resource usage in MiB, one sample per frame. */
+    std::array<float, 256> MemoryHistory{};
+    int MemoryHistoryOffset{};
+
     void Init(SGame* InGame);
 
     void Cleanup();
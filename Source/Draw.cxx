@@ -1,13 +1,17 @@
 #include "Draw.hxx"
 
 #include <algorithm>
+#include <cstring>
 #include <numeric>
+#include <optional>
+#include <SDL3/SDL_video.h>
 #include "CommonTypes.hxx"
 #include "Log.hxx"
 #include "Tile.hxx"
 #include "glad/gl.h"
 #include "World.hxx"
 #include "Constants.hxx"
+#include "Jobs.hxx"
 #include "Math.hxx"
 #include "Memory.hxx"
 
@@ -57,10 +61,10 @@ void SProgram::CheckShader(unsigned int ShaderID)
         GLint MaxLength = 0;
         glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &MaxLength);
         GLsizei LengthQuery(0);
-        std::vector<GLchar> InfoLog(MaxLength + 1, '\0');
-        glGetShaderInfoLog(ShaderID, GLsizei(InfoLog.size()), &LengthQuery, &InfoLog[0]);
-        auto Error = std::string(InfoLog.begin(), InfoLog.end());
-        Log::Draw<ELogLevel::Critical>("Shader error!\n %s", Error.c_str());
+        auto InfoLog = Memory::GetFrameVector<GLchar>();
+        InfoLog.resize(MaxLength + 1, '\0');
+        glGetShaderInfoLog(ShaderID, GLsizei(InfoLog.size()), &LengthQuery, InfoLog.data());
+        Log::Draw<ELogLevel::Critical>("Shader error!\n %s", InfoLog.data());
     }
 }
 
@@ -74,10 +78,10 @@ void SProgram::CheckProgram(unsigned int ProgramID)
         GLint MaxLength = 0;
         glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &MaxLength);
         GLsizei LengthQuery(0);
-        std::vector<GLchar> InfoLog(MaxLength + 1, '\0');
-        glGetProgramInfoLog(ProgramID, GLsizei(InfoLog.size()), &LengthQuery, &InfoLog[0]);
-        auto Error = std::string(InfoLog.begin(), InfoLog.end());
-        Log::Draw<ELogLevel::Critical>("Program error!\n %s", Error.c_str());
+        auto InfoLog = Memory::GetFrameVector<GLchar>();
+        InfoLog.resize(MaxLength + 1, '\0');
+        glGetProgramInfoLog(ProgramID, GLsizei(InfoLog.size()), &LengthQuery, InfoLog.data());
+        Log::Draw<ELogLevel::Critical>("Program error!\n %s", InfoLog.data());
     }
 }
 
@@ -173,30 +177,20 @@ void SProgram::Use() const
 }
 
 #ifdef EQUINOX_REACH_DEVELOPMENT
-    #include <sstream>
+    #include "Platform.hxx"
 void SProgram::Reload()
 {
-    namespace fs = std::filesystem;
-
-    std::ifstream ShaderFile;
-
-    unsigned VertexShader, FragmentShader;
-
-    ShaderFile.open(VertexShaderAsset->Path(), std::ifstream::in);
-    std::stringstream VertexShaderStringBuffer;
-    VertexShaderStringBuffer << ShaderFile.rdbuf();
-    auto VertexShaderString = VertexShaderStringBuffer.str();
-    VertexShader = CreateVertexShader(VertexShaderString.data(), (int)VertexShaderString.length());
-
-    ShaderFile.close();
-
-    ShaderFile.open(FragmentShaderAsset->Path(), std::ifstream::in);
-    std::stringstream FragmentShaderStringBuffer;
-    FragmentShaderStringBuffer << ShaderFile.rdbuf();
-    auto FragmentShaderString = FragmentShaderStringBuffer.str();
-    FragmentShader = CreateFragmentShader(FragmentShaderString.data(), (int)FragmentShaderString.length());
+    CMappedFile VertexShaderFile(VertexShaderAsset->Path());
+    CMappedFile FragmentShaderFile(FragmentShaderAsset->Path());
+    if (!VertexShaderFile.IsValid() || !FragmentShaderFile.IsValid())
+    {
+        return;
+    }
 
-    ShaderFile.close();
+    auto VertexShaderSource = VertexShaderFile.Asset(VertexShaderAsset->RelativeAssetPath);
+    auto FragmentShaderSource = FragmentShaderFile.Asset(FragmentShaderAsset->RelativeAssetPath);
+    unsigned VertexShader = CreateVertexShader(VertexShaderSource.SignedCharPtr(), (int)VertexShaderSource.Length);
+    unsigned FragmentShader = CreateFragmentShader(FragmentShaderSource.SignedCharPtr(), (int)FragmentShaderSource.Length);
 
     Log::Draw<ELogLevel::Debug>("Reloading GL program");
     Log::Draw<ELogLevel::Debug>("Vertex shader: %s", VertexShaderAsset->Path().string().c_str());
@@ -221,7 +215,7 @@ void SProgramPostProcess::InitUniforms()
 
 void SProgram3D::InitUniforms()
 {
-    UniformModelID = glGetUniformLocation(ID, "u_model");
+    UniformTileInstancesID = glGetUniformLocation(ID, "u_tileInstances");
     UniformCommonAtlasID = glGetUniformLocation(ID, "u_commonAtlas");
     UniformPrimaryAtlasID = glGetUniformLocation(ID, "u_primaryAtlas");
 
@@ -259,8 +253,10 @@ void SProgramMap::InitUniforms()
 {
     SProgram2D::InitUniforms();
     UniformWorldTextures = glGetUniformLocation(ID, "u_worldTextures");
+    UniformMapTiles = glGetUniformLocation(ID, "u_mapTiles");
 
     glProgramUniform1i(ID, UniformWorldTextures, ETextureUnits::WorldTextures);
+    glProgramUniform1i(ID, UniformMapTiles, ETextureUnits::MapTiles);
 
     glUniformBlockBinding(ID, glGetUniformBlockIndex(ID, "ub_common"), EUniformBlockBinding::MapCommon);
     glUniformBlockBinding(ID, glGetUniformBlockIndex(ID, "ub_editor"), EUniformBlockBinding::MapEditor);
@@ -423,6 +419,8 @@ void STileset::InitBasic(
     const SAsset& DoorFrame,
     const SAsset& Door)
 {
+    Memory::SScopedTag Tag(EMemoryTag::Mesh);
+
     auto Positions = Memory::GetVector<SVec3>();
     auto TexCoords = Memory::GetVector<SVec2>();
     auto Indices = Memory::GetVector<unsigned short>();
@@ -430,9 +428,25 @@ void STileset::InitBasic(
     int LastElementOffset = 0;
     int LastVertexOffset = 0;
 
-    auto InitGeometry = [&](const SAsset& Resource, int Type) {
-        auto Mesh = CRawMesh(Resource);
+    /* Parsed on the job threads, merged in this order. */
+    const std::array<std::pair<const SAsset*, int>, 6> Resources{ {
+        { &Floor, ETileGeometryType::Floor },
+        { &Hole, ETileGeometryType::Hole },
+        { &Wall, ETileGeometryType::Wall },
+        { &WallJoint, ETileGeometryType::WallJoint },
+        { &DoorFrame, ETileGeometryType::DoorFrame },
+        { &Door, ETileGeometryType::Door },
+    } };
+    std::array<std::optional<CRawMesh>, Resources.size()> Meshes;
+    Jobs::ParallelFor("Parse Tileset Meshes", Resources.size(), 1, [&](std::size_t Begin, std::size_t End) {
+        Memory::SScopedTag WorkerTag(EMemoryTag::Mesh);
+        for (auto Index = Begin; Index < End; ++Index)
+        {
+            Meshes[Index].emplace(*Resources[Index].first);
+        }
+    });
 
+    auto InitGeometry = [&](const CRawMesh& Mesh, int Type) {
         auto& Geometry = TileGeometry[Type];
         Geometry.ElementOffset = LastElementOffset;
         Geometry.ElementCount = Mesh.GetElementCount();
@@ -452,12 +466,10 @@ void STileset::InitBasic(
         LastElementOffset += (int)((Geometry.ElementCount) * sizeof(unsigned short));
     };
 
-    InitGeometry(Floor, ETileGeometryType::Floor);
-    InitGeometry(Hole, ETileGeometryType::Hole);
-    InitGeometry(Wall, ETileGeometryType::Wall);
-    InitGeometry(WallJoint, ETileGeometryType::WallJoint);
-    InitGeometry(DoorFrame, ETileGeometryType::DoorFrame);
-    InitGeometry(Door, ETileGeometryType::Door);
+    for (std::size_t Index = 0; Index < Resources.size(); ++Index)
+    {
+        InitGeometry(*Meshes[Index], Resources[Index].second);
+    }
 
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
@@ -508,6 +520,411 @@ void SCamera::RegenerateProjection()
 void SCamera::Update()
 {
     View = SMat4x4::LookAtRH(Position, Target, SVec3{ 0.0f, 1.0f, 0.0f });
+
+    /* Every plane is the last row of the view projection plus or minus one of the others. */
+    auto ViewProjection = Projection * View;
+    auto Row = [&](int Index) {
+        return SVec4{ (&ViewProjection.X.X)[Index], (&ViewProjection.Y.X)[Index], (&ViewProjection.Z.X)[Index], (&ViewProjection.W.X)[Index] };
+    };
+    for (int Index = 0; Index < 3; ++Index)
+    {
+        FrustumPlanes[Index * 2] = Row(3) + Row(Index);
+        FrustumPlanes[Index * 2 + 1] = Row(3) + -Row(Index);
+    }
+}
+
+bool SCamera::IsBoxVisible(const SVec3& Min, const SVec3& Max) const
+{
+    for (auto& Plane : FrustumPlanes)
+    {
+        /* The corner furthest along the normal. */
+        auto X = Plane.X >= 0.0f ? Max.X : Min.X;
+        auto Y = Plane.Y >= 0.0f ? Max.Y : Min.Y;
+        auto Z = Plane.Z >= 0.0f ? Max.Z : Min.Z;
+        if (Plane.X * X + Plane.Y * Y + Plane.Z * Z + Plane.W < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SMapTilesTexture::Init(int InTextureUnitID)
+{
+    TextureUnitID = InTextureUnitID;
+
+    glActiveTexture(GL_TEXTURE0 + TextureUnitID);
+    glGenTextures(1, &ID);
+    glBindTexture(GL_TEXTURE_2D, ID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SMapTilesTexture::Cleanup() const
+{
+    glDeleteTextures(1, &ID);
+
+    Log::Draw<ELogLevel::Debug>("Deleting SMapTilesTexture");
+}
+
+void SMapTilesTexture::Upload(const STilemap* Tilemap, const SRectInt& Rect)
+{
+    static constexpr int ChunkShift = CTileChunks::ChunkShift;
+    static constexpr int ChunkSize = CTileChunks::ChunkSize;
+
+    if (Rect.Max.X < Rect.Min.X || Rect.Max.Y < Rect.Min.Y)
+    {
+        return;
+    }
+
+    Reserve(Tilemap);
+
+    /* Chunks aren't contiguous in memory, so their rows are gathered into one staging rect and sent in a single call. */
+    SVec2Int MinChunk{ Rect.Min.X >> ChunkShift, Rect.Min.Y >> ChunkShift };
+    SVec2Int MaxChunk{ Rect.Max.X >> ChunkShift, Rect.Max.Y >> ChunkShift };
+    auto StagingWidth = (std::size_t)(MaxChunk.X - MinChunk.X + 1) * ChunkSize;
+    auto StagingHeight = (std::size_t)(MaxChunk.Y - MinChunk.Y + 1) * ChunkSize;
+    auto Staging = Memory::GetFrameVector<STile>();
+    Staging.resize(StagingWidth * StagingHeight);
+    for (int ChunkY = MinChunk.Y; ChunkY <= MaxChunk.Y; ++ChunkY)
+    {
+        for (int ChunkX = MinChunk.X; ChunkX <= MaxChunk.X; ++ChunkX)
+        {
+            auto Chunk = Tilemap->Tiles.FindChunk(ChunkX, ChunkY);
+            auto Destination = Staging.data() + (std::size_t)(ChunkY - MinChunk.Y) * ChunkSize * StagingWidth + (std::size_t)(ChunkX - MinChunk.X) * ChunkSize;
+            for (int Y = 0; Y < ChunkSize; ++Y)
+            {
+                std::copy_n(Chunk->Tiles.data() + Y * ChunkSize, ChunkSize, Destination + Y * StagingWidth);
+            }
+        }
+    }
+    glTexSubImage2D(GL_TEXTURE_2D, 0, MinChunk.X * ChunkSize, MinChunk.Y * ChunkSize, (int)StagingWidth, (int)StagingHeight,
+        GL_RGBA_INTEGER, GL_UNSIGNED_INT, Staging.data());
+
+    FrameUploadBytes += Staging.size() * sizeof(STile);
+    FrameUploadCalls++;
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SMapTilesTexture::Upload(const STilemap* Tilemap, const SDirtySpans& DirtySpans)
+{
+    static constexpr int ChunkShift = CTileChunks::ChunkShift;
+
+    if (DirtySpans.IsEmpty() || Tilemap->TileCount() == 0)
+    {
+        return;
+    }
+
+    auto LastIndex = (std::size_t)Tilemap->TileCount() - 1;
+    auto FirstRow = Tilemap->IndexToCoords(std::min(DirtySpans.begin()->X, LastIndex)).Y;
+    auto LastRow = Tilemap->IndexToCoords(std::min((DirtySpans.end() - 1)->Y, LastIndex)).Y;
+    auto BoundingTiles = (std::size_t)(LastRow - FirstRow + 1) * Tilemap->Width;
+    if ((float)DirtySpans.TileCount() > (float)BoundingTiles * SpanFallbackCoverage)
+    {
+        Upload(Tilemap, SRectInt{ { 0, FirstRow }, { Tilemap->Width - 1, LastRow } });
+        return;
+    }
+
+    /* A span is a partial first row, whole rows, then a partial last row. Spans in the same chunk share its upload. */
+    auto Chunks = Memory::GetFrameVector<SVec2Int>();
+    auto AddRect = [&](int MinX, int MinY, int MaxX, int MaxY) {
+        for (int ChunkY = MinY >> ChunkShift; ChunkY <= MaxY >> ChunkShift; ++ChunkY)
+        {
+            for (int ChunkX = MinX >> ChunkShift; ChunkX <= MaxX >> ChunkShift; ++ChunkX)
+            {
+                Chunks.push_back({ ChunkX, ChunkY });
+            }
+        }
+    };
+    for (auto& Span : DirtySpans)
+    {
+        if (Span.X > LastIndex)
+        {
+            break;
+        }
+        auto First = Tilemap->IndexToCoords(Span.X);
+        auto Last = Tilemap->IndexToCoords(std::min(Span.Y, LastIndex));
+        if (First.Y == Last.Y)
+        {
+            AddRect(First.X, First.Y, Last.X, Last.Y);
+            continue;
+        }
+        AddRect(First.X, First.Y, Tilemap->Width - 1, First.Y);
+        if (Last.Y - First.Y > 1)
+        {
+            AddRect(0, First.Y + 1, Tilemap->Width - 1, Last.Y - 1);
+        }
+        AddRect(0, Last.Y, Last.X, Last.Y);
+    }
+    std::sort(Chunks.begin(), Chunks.end(), [](const SVec2Int& A, const SVec2Int& B) {
+        return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+    });
+    Chunks.erase(std::unique(Chunks.begin(), Chunks.end()), Chunks.end());
+
+    Reserve(Tilemap);
+    for (auto& Chunk : Chunks)
+    {
+        UploadChunk(Tilemap, Chunk.X, Chunk.Y);
+    }
+    glActiveTexture(GL_TEXTURE0);
+}
+
+void SMapTilesTexture::EndFrame()
+{
+    LastFrameUploadBytes = FrameUploadBytes;
+    LastFrameUploadCalls = FrameUploadCalls;
+    FrameUploadBytes = 0;
+    FrameUploadCalls = 0;
+}
+
+void SInstanceBuffer::Init()
+{
+    glGenBuffers(1, &StaticVBO);
+    glGenBuffers(1, &TileVBO);
+    glGenBuffers(1, &StreamVBO);
+    glBindBuffer(GL_ARRAY_BUFFER, StreamVBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(FrameCount * FrameCapacity * sizeof(SMat4x4)), nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SInstanceBuffer::Cleanup()
+{
+    for (auto& Fence : Fences)
+    {
+        glDeleteSync(static_cast<GLsync>(Fence));
+        Fence = nullptr;
+    }
+    glDeleteBuffers(1, &StaticVBO);
+    glDeleteBuffers(1, &TileVBO);
+    glDeleteBuffers(1, &StreamVBO);
+}
+
+void SInstanceBuffer::UploadStatic(SInstancedDrawCall* DrawCalls, int DrawCallCount)
+{
+    std::size_t Total{};
+    std::size_t TileTotal{};
+    for (int Index = 0; Index < DrawCallCount; ++Index)
+    {
+        Total += DrawCalls[Index].Count;
+        TileTotal += DrawCalls[Index].Tiles.size();
+    }
+    StaticCapacity = std::max(StaticCapacity, Total);
+    TileCapacity = std::max(TileCapacity, TileTotal);
+
+    /* Orphaning the old storage lets draws still reading it finish without stalling the upload. */
+    glBindBuffer(GL_ARRAY_BUFFER, TileVBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(TileCapacity * sizeof(STileInstance)), nullptr, GL_STATIC_DRAW);
+
+    std::size_t TileOffset{};
+    for (int Index = 0; Index < DrawCallCount; ++Index)
+    {
+        auto& DrawCall = DrawCalls[Index];
+        DrawCall.TileOffset = TileOffset;
+        if (!DrawCall.Tiles.empty())
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(TileOffset * sizeof(STileInstance)), (GLsizeiptr)(DrawCall.Tiles.size() * sizeof(STileInstance)), DrawCall.Tiles.data());
+            TileOffset += DrawCall.Tiles.size();
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, StaticVBO);
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(StaticCapacity * sizeof(SMat4x4)), nullptr, GL_STATIC_DRAW);
+
+    std::size_t Offset{};
+    for (int Index = 0; Index < DrawCallCount; ++Index)
+    {
+        auto& DrawCall = DrawCalls[Index];
+        DrawCall.StaticOffset = Offset;
+        if (DrawCall.Count > 0)
+        {
+            glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(Offset * sizeof(SMat4x4)), (GLsizeiptr)(DrawCall.Count * sizeof(SMat4x4)), DrawCall.Transforms.data());
+            Offset += DrawCall.Count;
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    FrameUploadBytes += Total * sizeof(SMat4x4) + TileTotal * sizeof(STileInstance);
+}
+
+std::size_t SInstanceBuffer::Stream(const SMat4x4* Transforms, std::size_t Count)
+{
+    if (FrameOffset + Count > FrameCapacity)
+    {
+        Log::Draw<ELogLevel::Critical>("%s(): Dropping %zu instances, frame region is full", __func__, Count);
+        return SIZE_MAX;
+    }
+
+    auto Offset = Frame * FrameCapacity + FrameOffset;
+    auto Bytes = Count * sizeof(SMat4x4);
+
+    /* The fence in EndFrame() already made sure the GPU is done with this region. */
+    glBindBuffer(GL_ARRAY_BUFFER, StreamVBO);
+    auto Mapped = glMapBufferRange(GL_ARRAY_BUFFER, (GLintptr)(Offset * sizeof(SMat4x4)), (GLsizeiptr)Bytes,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    if (Mapped == nullptr)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        return SIZE_MAX;
+    }
+    std::memcpy(Mapped, Transforms, Bytes);
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    FrameOffset += Count;
+    FrameUploadBytes += Bytes;
+    return Offset;
+}
+
+void SInstanceBuffer::Bind(unsigned VBO, std::size_t Offset)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+    for (unsigned Column = 0; Column < 4; ++Column)
+    {
+        glEnableVertexAttribArray(AttributeLocation + Column);
+        glVertexAttribPointer(AttributeLocation + Column, 4, GL_FLOAT, GL_FALSE, sizeof(SMat4x4),
+            reinterpret_cast<void*>(Offset * sizeof(SMat4x4) + Column * sizeof(SVec4)));
+        glVertexAttribDivisor(AttributeLocation + Column, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SInstanceBuffer::BindTiles(std::size_t Offset) const
+{
+    glBindBuffer(GL_ARRAY_BUFFER, TileVBO);
+    glEnableVertexAttribArray(TileAttributeLocation);
+    glVertexAttribIPointer(TileAttributeLocation, 4, GL_SHORT, sizeof(STileInstance), reinterpret_cast<void*>(Offset * sizeof(STileInstance)));
+    glVertexAttribDivisor(TileAttributeLocation, 1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+void SInstanceBuffer::Unbind()
+{
+    for (unsigned Column = 0; Column < 4; ++Column)
+    {
+        glDisableVertexAttribArray(AttributeLocation + Column);
+    }
+    glDisableVertexAttribArray(TileAttributeLocation);
+}
+
+void SInstanceBuffer::EndFrame()
+{
+    glDeleteSync(static_cast<GLsync>(Fences[Frame]));
+    Fences[Frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    Frame = (Frame + 1) % FrameCount;
+    FrameOffset = 0;
+
+    /* Only blocks when the GPU is more than FrameCount - 1 frames behind. */
+    if (Fences[Frame] != nullptr)
+    {
+        glClientWaitSync(static_cast<GLsync>(Fences[Frame]), GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000);
+        glDeleteSync(static_cast<GLsync>(Fences[Frame]));
+        Fences[Frame] = nullptr;
+    }
+
+    LastFrameUploadBytes = FrameUploadBytes;
+    FrameUploadBytes = 0;
+}
+
+/* Not in the 4.1 core loader, looked up by SIndirectDrawBuffer::Init(). */
+using PFNMultiDrawElementsIndirect = void(GLAD_API_PTR*)(GLenum Mode, GLenum Type, const void* Indirect, GLsizei DrawCount, GLsizei Stride);
+static PFNMultiDrawElementsIndirect MultiDrawElementsIndirect{};
+
+void SIndirectDrawBuffer::Init()
+{
+    GLint MajorVersion{};
+    GLint MinorVersion{};
+    glGetIntegerv(GL_MAJOR_VERSION, &MajorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &MinorVersion);
+
+    /* Both are core since 4.3, a 4.1 context only gets them as extensions. */
+    auto bMultiDrawIndirect = MajorVersion * 10 + MinorVersion >= 43;
+    auto bBaseInstance = bMultiDrawIndirect;
+    GLint ExtensionCount{};
+    glGetIntegerv(GL_NUM_EXTENSIONS, &ExtensionCount);
+    for (GLint Index = 0; Index < ExtensionCount; ++Index)
+    {
+        auto Name = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, (GLuint)Index));
+        bMultiDrawIndirect |= std::strcmp(Name, "GL_ARB_multi_draw_indirect") == 0;
+        bBaseInstance |= std::strcmp(Name, "GL_ARB_base_instance") == 0;
+    }
+
+    if (bMultiDrawIndirect && bBaseInstance)
+    {
+        MultiDrawElementsIndirect = reinterpret_cast<PFNMultiDrawElementsIndirect>(SDL_GL_GetProcAddress("glMultiDrawElementsIndirect"));
+    }
+    bSupported = MultiDrawElementsIndirect != nullptr;
+    if (bSupported)
+    {
+        glGenBuffers(1, &IBO);
+    }
+
+    Log::Draw<ELogLevel::Info>("%s(): Multi-draw indirect %s", __func__, bSupported ? "supported" : "not supported, drawing ranges one by one");
+}
+
+void SIndirectDrawBuffer::Cleanup()
+{
+    glDeleteBuffers(1, &IBO);
+    IBO = 0;
+    Capacity = 0;
+}
+
+void SIndirectDrawBuffer::Upload()
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IBO);
+    if (Commands.size() > Capacity)
+    {
+        Capacity = std::max(Commands.size(), Capacity * 2);
+    }
+    /* Orphaned every frame, last frame's draws may still be reading the old commands. */
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, (GLsizeiptr)(Capacity * sizeof(SDrawElementsIndirectCommand)), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, (GLsizeiptr)(Commands.size() * sizeof(SDrawElementsIndirectCommand)), Commands.data());
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void SIndirectDrawBuffer::Draw(std::size_t First, std::size_t Count) const
+{
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, IBO);
+    MultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_SHORT, reinterpret_cast<void*>(First * sizeof(SDrawElementsIndirectCommand)), (GLsizei)Count, 0);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void SMapTilesTexture::Reserve(const STilemap* Tilemap)
+{
+    static constexpr int ChunkSize = CTileChunks::ChunkSize;
+
+    glActiveTexture(GL_TEXTURE0 + TextureUnitID);
+    glBindTexture(GL_TEXTURE_2D, ID);
+
+    /* Storage is kept in whole chunks so every chunk uploads as one rect. */
+    SVec2Int RequiredSize{ (Tilemap->Width + ChunkSize - 1) & ~(ChunkSize - 1), (Tilemap->Height + ChunkSize - 1) & ~(ChunkSize - 1) };
+    if (RequiredSize.X > Size.X || RequiredSize.Y > Size.Y)
+    {
+        Size = { std::max(Size.X, RequiredSize.X), std::max(Size.Y, RequiredSize.Y) };
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, Size.X, Size.Y, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+        Log::Draw<ELogLevel::Debug>("%s(): Resized to %dx%d", __func__, Size.X, Size.Y);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+/* Chunks are uploaded whole, missing ones come from the shared empty chunk. */
+void SMapTilesTexture::UploadChunk(const STilemap* Tilemap, int ChunkX, int ChunkY)
+{
+    static constexpr int ChunkSize = CTileChunks::ChunkSize;
+
+    auto Chunk = Tilemap->Tiles.FindChunk(ChunkX, ChunkY);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, ChunkX * ChunkSize, ChunkY * ChunkSize, ChunkSize, ChunkSize,
+        GL_RGBA_INTEGER, GL_UNSIGNED_INT, Chunk->Tiles.data());
+
+    FrameUploadBytes += sizeof(Chunk->Tiles);
+    FrameUploadCalls++;
 }
 
 void SWorldFramebuffer::Init(int TextureUnitID, int InWidth, int InHeight, SVec3 InClearColor)
@@ -744,6 +1161,9 @@ void SRenderer::Init(int Width, int Height)
         int(MapWorldLayerTextureSize.Y),
         TVec3{ 0.0f, 0.0f, 1.0f });
     MainFramebuffer.Init(ETextureUnits::MainFramebuffer, Width, Height);
+    MapTilesTexture.Init(ETextureUnits::MapTiles);
+    InstanceBuffer.Init();
+    IndirectDrawBuffer.Init();
 
     /* Initialize atlases. */
     Atlases[ATLAS_COMMON].Init(ETextureUnits::AtlasCommon);
@@ -762,6 +1182,9 @@ void SRenderer::Cleanup()
 {
     MainFramebuffer.Cleanup();
     WorldLayersFramebuffer.Cleanup();
+    MapTilesTexture.Cleanup();
+    InstanceBuffer.Cleanup();
+    IndirectDrawBuffer.Cleanup();
     for (auto& Atlas : Atlases)
     {
         Atlas.Cleanup();
@@ -803,19 +1226,18 @@ void SRenderer::SetupTileset(const STileset* Tileset)
     }
 }
 
-void SRenderer::UploadMapData(const SWorldLevel* Level, const SCoordsAndDirection& POV) const
+void SRenderer::UploadMapData(const SWorldLevel* Level, const SCoordsAndDirection& POV)
 {
-    SShaderMapData ShaderMapData{};
-
+    SShaderMapData ShaderMapData;
     ShaderMapData.Width = (int)Level->Width;
     ShaderMapData.Height = (int)Level->Height;
     ShaderMapData.POV = POV;
-    ShaderMapData.Tiles = Level->Tiles;
 
     glBindBuffer(GL_UNIFORM_BUFFER, ProgramMap.UniformBlockMap.UBO);
-    /* Upload only relevant tiles within (width * height) range. */
-    glBufferSubData(GL_UNIFORM_BUFFER, 0, offsetof(SShaderMapData, Tiles) + sizeof(STile) * (Level->Width * Level->Height), &ShaderMapData);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SShaderMapData), &ShaderMapData);
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    MapTilesTexture.Upload(Level, SRectInt{ { 0, 0 }, { Level->Width - 1, Level->Height - 1 } });
 }
 
 void SRenderer::SetTime(float Time) const
@@ -840,6 +1262,8 @@ void SRenderer::Flush(const SPlatformState& WindowData)
     glViewport(SceneOffset.X, SceneOffset.Y, Constants::SceneSize.X, Constants::SceneSize.Y);
 
     ProgramUber3D.Use();
+    /* The main framebuffer and the 3D program. */
+    FrameStats.StateChanges += 2;
 
     // glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
     for (int Index = 0; Index < Queue3D.CurrentIndex; ++Index)
@@ -851,28 +1275,128 @@ void SRenderer::Flush(const SPlatformState& WindowData)
         }
         glUniform1i(ProgramUber3D.UniformModeID, Entry.Mode.ID);
         glBindVertexArray(Entry.Geometry->VAO);
+        FrameStats.StateChanges += 2;
         if (Entry.InstancedDrawCall != nullptr)
         {
+            if (bUseMultiDrawIndirect && IndirectDrawBuffer.bSupported)
+            {
+                /* Tile commands first, then static transforms, each addressing its buffer from the start by base instance. */
+                auto& Commands = IndirectDrawBuffer.Commands;
+                Commands.clear();
+                for (int DrawCallIndex = 0; DrawCallIndex < Entry.InstancedDrawCallCount; ++DrawCallIndex)
+                {
+                    auto& DrawCall = *(Entry.InstancedDrawCall + DrawCallIndex);
+                    for (auto& Range : DrawCall.VisibleTiles)
+                    {
+                        Commands.push_back({ (uint32_t)DrawCall.SubGeometry->ElementCount, (uint32_t)Range.Y,
+                            (uint32_t)(DrawCall.SubGeometry->ElementOffset / sizeof(unsigned short)), 0, (uint32_t)(DrawCall.TileOffset + Range.X) });
+                    }
+                }
+                auto TileCommandCount = Commands.size();
+                for (int DrawCallIndex = 0; DrawCallIndex < Entry.InstancedDrawCallCount; ++DrawCallIndex)
+                {
+                    auto& DrawCall = *(Entry.InstancedDrawCall + DrawCallIndex);
+                    for (auto& Range : DrawCall.VisibleTransforms)
+                    {
+                        if (Range.Y > 0)
+                        {
+                            Commands.push_back({ (uint32_t)DrawCall.SubGeometry->ElementCount, (uint32_t)Range.Y,
+                                (uint32_t)(DrawCall.SubGeometry->ElementOffset / sizeof(unsigned short)), 0, (uint32_t)(DrawCall.StaticOffset + Range.X) });
+                        }
+                    }
+                }
+                IndirectDrawBuffer.Upload();
+
+                if (TileCommandCount > 0)
+                {
+                    InstanceBuffer.BindTiles(0);
+                    glUniform1i(ProgramUber3D.UniformTileInstancesID, 1);
+                    IndirectDrawBuffer.Draw(0, TileCommandCount);
+                    glUniform1i(ProgramUber3D.UniformTileInstancesID, 0);
+                    FrameStats.DrawCalls++;
+                    FrameStats.StateChanges += 3;
+                }
+                if (Commands.size() > TileCommandCount)
+                {
+                    SInstanceBuffer::Bind(InstanceBuffer.StaticVBO, 0);
+                    IndirectDrawBuffer.Draw(TileCommandCount, Commands.size() - TileCommandCount);
+                    FrameStats.DrawCalls++;
+                    FrameStats.StateChanges++;
+                }
+            }
+            else
+            {
+                for (int DrawCallIndex = 0; DrawCallIndex < Entry.InstancedDrawCallCount; ++DrawCallIndex)
+                {
+                    auto& DrawCall = *(Entry.InstancedDrawCall + DrawCallIndex);
+                    if (!DrawCall.VisibleTiles.empty())
+                    {
+                        glUniform1i(ProgramUber3D.UniformTileInstancesID, 1);
+                        for (auto& Range : DrawCall.VisibleTiles)
+                        {
+                            /* No base instance in 4.1, every range points the attribute at its own first instance. */
+                            InstanceBuffer.BindTiles(DrawCall.TileOffset + Range.X);
+                            glDrawElementsInstanced(GL_TRIANGLES,
+                                DrawCall.SubGeometry->ElementCount,
+                                GL_UNSIGNED_SHORT,
+                                reinterpret_cast<void*>(DrawCall.SubGeometry->ElementOffset),
+                                Range.Y);
+                            FrameStats.DrawCalls++;
+                            FrameStats.StateChanges++;
+                        }
+                        glUniform1i(ProgramUber3D.UniformTileInstancesID, 0);
+                        FrameStats.StateChanges += 2;
+                    }
+                    for (auto& Range : DrawCall.VisibleTransforms)
+                    {
+                        if (Range.Y == 0)
+                        {
+                            continue;
+                        }
+                        SInstanceBuffer::Bind(InstanceBuffer.StaticVBO, DrawCall.StaticOffset + Range.X);
+                        glDrawElementsInstanced(GL_TRIANGLES,
+                            DrawCall.SubGeometry->ElementCount,
+                            GL_UNSIGNED_SHORT,
+                            reinterpret_cast<void*>(DrawCall.SubGeometry->ElementOffset),
+                            Range.Y);
+                        FrameStats.DrawCalls++;
+                        FrameStats.StateChanges++;
+                    }
+                }
+            }
+
             for (int DrawCallIndex = 0; DrawCallIndex < Entry.InstancedDrawCallCount; ++DrawCallIndex)
             {
                 auto& DrawCall = *(Entry.InstancedDrawCall + DrawCallIndex);
-                auto TotalCount = DrawCall.Count + DrawCall.DynamicCount;
-                if (TotalCount > 0)
+                if (DrawCall.DynamicCount > 0)
                 {
-                    glUniformMatrix4fv(ProgramUber3D.UniformModelID, TotalCount, GL_FALSE,
-                        &DrawCall.Transform[0].X.X);
-                    glDrawElementsInstanced(GL_TRIANGLES,
-                        DrawCall.SubGeometry->ElementCount,
-                        GL_UNSIGNED_SHORT,
-                        reinterpret_cast<void*>(DrawCall.SubGeometry->ElementOffset),
-                        TotalCount);
+                    auto Offset = InstanceBuffer.Stream(&DrawCall.Transforms[DrawCall.Count], DrawCall.DynamicCount);
+                    if (Offset != SIZE_MAX)
+                    {
+                        SInstanceBuffer::Bind(InstanceBuffer.StreamVBO, Offset);
+                        glDrawElementsInstanced(GL_TRIANGLES,
+                            DrawCall.SubGeometry->ElementCount,
+                            GL_UNSIGNED_SHORT,
+                            reinterpret_cast<void*>(DrawCall.SubGeometry->ElementOffset),
+                            DrawCall.DynamicCount);
+                        FrameStats.DrawCalls++;
+                        FrameStats.StateChanges++;
+                    }
                 }
             }
+            SInstanceBuffer::Unbind();
+            FrameStats.StateChanges++;
         }
         else
         {
-            glUniformMatrix4fv(ProgramUber3D.UniformModelID, 1, GL_FALSE, &Entry.Model.X.X);
+            /* With the instance arrays disabled, every vertex reads the current attribute value. */
+            for (unsigned Column = 0; Column < 4; ++Column)
+            {
+                glVertexAttrib4fv(SInstanceBuffer::AttributeLocation + Column, &Entry.Model.X.X + Column * 4);
+            }
             glDrawElements(GL_TRIANGLES, Entry.Geometry->ElementCount, GL_UNSIGNED_SHORT, nullptr);
+            FrameStats.DrawCalls++;
+            FrameStats.StateChanges++;
         }
     }
     // glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
@@ -884,6 +1408,7 @@ void SRenderer::Flush(const SPlatformState& WindowData)
     glViewport(0, 0, MainFramebuffer.Width, MainFramebuffer.Height);
 
     glBindVertexArray(Quad2D.VAO);
+    FrameStats.StateChanges++;
 
     for (int Index = 0; Index < Queue2D.CurrentIndex; ++Index)
     {
@@ -911,21 +1436,26 @@ void SRenderer::Flush(const SPlatformState& WindowData)
 
         const SEntryMode& Mode = Entry.Mode;
         glUniform1i(Program->UniformModeID, Mode.ID);
+        FrameStats.StateChanges += 4;
 
         if (Entry.Program2DType == EProgram2DType::Uber2D)
         {
             glUniform4fv(ProgramUber2D.UniformUVRectID, 1, &Entry.UVRect.X);
+            FrameStats.StateChanges++;
 
             if (Mode.ID > UBER2D_MODE_TEXTURE)
             {
                 glUniform4fv(ProgramUber2D.UniformModeControlAID, 1, &Mode.ControlA.X);
                 glUniform4fv(ProgramUber2D.UniformModeControlBID, 1, &Mode.ControlB.X);
+                FrameStats.StateChanges += 2;
             }
             if (Mode.ID == UBER2D_MODE_BACK_BLUR)
             {
                 glDrawElementsInstanced(GL_TRIANGLES, Quad2D.ElementCount, GL_UNSIGNED_SHORT, nullptr,
                     (int)Mode.ControlA.X);
                 glUniform1i(Program->UniformModeID, 0);
+                FrameStats.DrawCalls++;
+                FrameStats.StateChanges++;
             }
         }
         else if (Entry.Program2DType == EProgram2DType::HUD)
@@ -933,6 +1463,7 @@ void SRenderer::Flush(const SPlatformState& WindowData)
         }
 
         glDrawElements(GL_TRIANGLES, Quad2D.ElementCount, GL_UNSIGNED_SHORT, nullptr);
+        FrameStats.DrawCalls++;
     }
 
     /* Blit main framebuffer to our window. */
@@ -948,9 +1479,17 @@ void SRenderer::Flush(const SPlatformState& WindowData)
 
     ProgramPostProcess.Use();
     glDrawElements(GL_TRIANGLES, Quad2D.ElementCount, GL_UNSIGNED_SHORT, nullptr);
+    FrameStats.DrawCalls++;
+    /* The framebuffer back to the window and the post process program. */
+    FrameStats.StateChanges += 2;
 
     Queue2D.Reset();
     Queue3D.Reset();
+
+    MapTilesTexture.EndFrame();
+    InstanceBuffer.EndFrame();
+    LastFrameStats = FrameStats;
+    FrameStats = {};
 }
 
 void SRenderer::UploadProjectionAndViewFromCamera(const SCamera& Camera) const
@@ -991,13 +1530,12 @@ void SRenderer::DrawMap(SWorldLevel* Level, SVec3 Position, SVec2Int Size, const
 
         if (bDirtyRange)
         {
-            auto DirtyCount = (GLsizeiptr)(Level->DirtyRange.Y - Level->DirtyRange.X) + 1;
-            auto FirstTile = Level->GetTile(Level->DirtyRange.X);
-            glBufferSubData(GL_UNIFORM_BUFFER, offsetof(SShaderMapData, Tiles) + (Level->DirtyRange.X * sizeof(STile)), DirtyCount * (GLsizeiptr)sizeof(STile), FirstTile);
+            MapTilesTexture.Upload(Level, Level->DirtySpans);
 
-            Level->DirtyFlags &= ~ELevelDirtyFlags::DirtyRange;
+            Log::Draw<ELogLevel::Debug>("%s(): DirtySpans: %zu spans, %zu tiles", __func__, Level->DirtySpans.Count, Level->DirtySpans.TileCount());
 
-            Log::Draw<ELogLevel::Debug>("%s(): DirtyRange: %d to %d", __func__, Level->DirtyRange.X, Level->DirtyRange.Y);
+            Level->DirtySpans.Clear();
+            Level->DirtyFlags &= ~ELevelDirtyFlags::DirtyRange;
         }
         glBindBuffer(GL_UNIFORM_BUFFER, 0);
     }
@@ -1070,7 +1608,7 @@ void SRenderer::DrawWorldLayers(const SWorld* World, SVec2Int Range)
     int LayerIndex{};
     for (auto LevelIndex = Range.X; LevelIndex < Range.Y; LevelIndex++)
     {
-        auto Level = &World->Levels[LevelIndex];
+        auto Level = World->FindLevel(LevelIndex);
         if (Level == nullptr)
         {
             continue;
@@ -1222,161 +1760,247 @@ void SRenderer::Draw3D(SVec3 Position, SGeometry* Geometry)
     Queue3D.Enqueue(Entry);
 }
 
-void SRenderer::Draw3DLevel(SWorldLevel* Level, const SVec2Int& POVOrigin, const SDirection& POVDirection)
+void SRenderer::Draw3DLevel(SWorldLevel* Level, const SVec2Int& POVOrigin, const SCamera& Camera)
 {
-    auto constexpr DrawDistanceForward = 4;
-    auto constexpr DrawDistanceSide = 2;
-
     auto& DoorDrawCall = LevelDrawData.DrawCalls[ETileGeometryType::Door];
 
-    /* @TODO: Generic CleanDynamic method? */
-    DoorDrawCall.DynamicCount = 0;
+    DoorDrawCall.ClearDynamic();
 
-    if (Level->DirtyFlags & ELevelDirtyFlags::DrawSet)
+    if ((Level->DirtyFlags & ELevelDirtyFlags::DrawSet) || LevelDrawData.Level != Level)
     {
-        LevelDrawData.Clear();
+        BuildLevelDrawSet(Level);
+    }
+    if (Level->DirtyFlags & ELevelDirtyFlags::Visibility)
+    {
+        LevelDrawData.bVisibilityDirty = true;
+        Level->DirtyFlags &= ~ELevelDirtyFlags::Visibility;
+    }
 
-        auto& FloorDrawCall = LevelDrawData.DrawCalls[ETileGeometryType::Floor];
+    for (auto& DrawCall : LevelDrawData.DrawCalls)
+    {
+        DrawCall.ClearVisible();
+    }
+    LevelDrawData.VisibleChunkCount = 0;
+    if (!Level->Visibility.IsBaked(*Level))
+    {
+        /* Still baking, drawn unculled meanwhile. */
+        for (auto& DrawCall : LevelDrawData.DrawCalls)
+        {
+            DrawCall.ShowAll();
+        }
+        LevelDrawData.VisibleChunkCount = LevelDrawData.TotalChunkCount();
+    }
+    else
+    {
+        auto CameraCoords = SVec2Int{ (int)std::lround(Camera.Position.X), (int)std::lround(Camera.Position.Z) };
+        UpdateLevelVisibility(Level, POVOrigin, CameraCoords);
 
-        auto& HoleDrawCall = LevelDrawData.DrawCalls[ETileGeometryType::Hole];
+        for (auto Chunk : LevelDrawData.PotentiallyVisibleChunks)
+        {
+            auto Min = SVec2Int{ Chunk % LevelDrawData.ChunkCount.X, Chunk / LevelDrawData.ChunkCount.X } * CLevelVisibility::ChunkSize;
+            auto Max = Min + SVec2Int{ CLevelVisibility::ChunkSize, CLevelVisibility::ChunkSize };
+            /* Tiles are centered on their coords, and walls, joints and holes reach a little past them. */
+            if (!Camera.IsBoxVisible({ (float)Min.X - 1.0f, -2.0f, (float)Min.Y - 1.0f }, { (float)Max.X, 2.0f, (float)Max.Y }))
+            {
+                continue;
+            }
+            for (auto& DrawCall : LevelDrawData.DrawCalls)
+            {
+                DrawCall.ShowChunk(Chunk);
+            }
+            LevelDrawData.VisibleChunkCount++;
+        }
+    }
 
-        auto& WallDrawCall = LevelDrawData.DrawCalls[ETileGeometryType::Wall];
+    /* The animated door replaces the static ones on both sides of it. */
+    auto& DoorInfo = Level->DoorInfo;
+    if (DoorInfo.TileCoords.X + DoorInfo.TileCoords.Y >= 0)
+    {
+        auto OtherSide = DoorInfo.TileCoords + DoorInfo.Direction.GetVector<int>();
+        for (int Index = 0; Index < (int)LevelDrawData.Doors.size(); ++Index)
+        {
+            auto& Door = LevelDrawData.Doors[Index];
+            auto Coords = SVec2Int{ Door.X, Door.Z };
+            if ((Coords == DoorInfo.TileCoords && Door.Rotation == (int16_t)DoorInfo.Direction.Index) ||
+                (Coords == OtherSide && Door.Rotation == (int16_t)DoorInfo.Direction.Inverted().Index))
+            {
+                DoorDrawCall.HideTransform(Index);
+            }
+        }
+    }
 
-        auto& WallJointDrawCall = LevelDrawData.DrawCalls[ETileGeometryType::WallJoint];
+    Draw3DLevelDoor(
+        DoorDrawCall,
+        DoorInfo.TileCoords,
+        DoorInfo.Direction,
+        DoorInfo.Timeline.Value);
 
-        auto& DoorFrameDrawCall = LevelDrawData.DrawCalls[ETileGeometryType::DoorFrame];
+    SEntry3D Entry;
 
-        if (!Level->IsValidTile(POVOrigin))
-        {
-            return;
-        }
+    Entry.Geometry = LevelDrawData.TileSet;
+    Entry.Model = SMat4x4::Identity();
+    Entry.InstancedDrawCall = &LevelDrawData.DrawCalls[0];
+    Entry.InstancedDrawCallCount = ETileGeometryType::Count;
 
-        auto POVDirectionInverted = POVDirection.Inverted();
-        auto POVDirectionVectorForward = POVDirection.GetVector<int>();
-        auto POVDirectionVectorSide = SVec2Int{ POVDirectionVectorForward.Y, -POVDirectionVectorForward.X };
+    Entry.Mode = SEntryMode{
+        UBER3D_MODE_LEVEL
+    };
 
-        for (int SideCounter = -DrawDistanceSide; SideCounter <= DrawDistanceSide; ++SideCounter)
-        {
-            for (int ForwardCounter = -1; ForwardCounter < DrawDistanceForward; ++ForwardCounter)
-            {
-                auto RelativeX = (POVDirectionVectorForward.X * ForwardCounter) + (POVDirectionVectorSide.X * SideCounter);
-                auto RelativeY = (POVDirectionVectorForward.Y * ForwardCounter) + (POVDirectionVectorSide.Y * SideCounter);
+    Queue3D.Enqueue(Entry);
+}
 
-                auto X = POVOrigin.X + RelativeX;
-                auto Y = POVOrigin.Y + RelativeY;
+void SRenderer::BuildLevelDrawSet(SWorldLevel* Level)
+{
+    LevelDrawData.Clear();
+    LevelDrawData.Doors.clear();
+    LevelDrawData.Level = Level;
+    LevelDrawData.ChunkCount = {
+        (Level->Width + CLevelVisibility::ChunkSize - 1) / CLevelVisibility::ChunkSize,
+        (Level->Height + CLevelVisibility::ChunkSize - 1) / CLevelVisibility::ChunkSize
+    };
+    LevelDrawData.bVisibilityDirty = true;
 
-                auto XOffset = (float)X;
-                auto YOffset = (float)Y;
+    /* Each chunk row is built into its own draw calls on the job threads, then appended in order so chunk indices stay row-major. */
+    struct SChunkRow
+    {
+        std::array<SInstancedDrawCall, ETileGeometryType::Count> DrawCalls;
+        std::pmr::vector<STileInstance> Doors{ Memory::GetPoolResource() };
+    };
+    std::pmr::vector<SChunkRow> ChunkRows{ Memory::GetPoolResource() };
+    ChunkRows.resize((std::size_t)LevelDrawData.ChunkCount.Y);
 
-                auto TileCoords = SVec2Int{ X, Y };
+    auto BuildChunkRow = [&](int ChunkY) {
+        auto& Row = ChunkRows[(std::size_t)ChunkY];
 
-                auto TileTransform = SMat4x4::Identity();
-                TileTransform.Translate(SVec3{ XOffset, 0.0f, YOffset });
+        auto& FloorDrawCall = Row.DrawCalls[ETileGeometryType::Floor];
 
-                /* @TODO: Draw joints in separate loop. */
-                /* @TODO: Maybe don't store them at all? */
-                if (Level->bUseWallJoints && Level->IsValidWallJoint({ X, Y }))
-                {
-                    auto bWallJoint = Level->IsWallJointAt({ X, Y });
-                    if (bWallJoint)
-                    {
-                        WallJointDrawCall.Push(TileTransform);
-                    }
-                }
+        auto& HoleDrawCall = Row.DrawCalls[ETileGeometryType::Hole];
 
-                auto Tile = Level->GetTileAt(TileCoords);
+        auto& WallDrawCall = Row.DrawCalls[ETileGeometryType::Wall];
 
-                if (Tile == nullptr)
-                {
-                    continue;
-                }
+        auto& WallJointDrawCall = Row.DrawCalls[ETileGeometryType::WallJoint];
 
-                if (SideCounter < -1 && ForwardCounter == 0 && !Tile->IsEdgeEmpty(POVDirection.Side().Inverted()))
-                {
-                    continue;
-                }
+        auto& DoorDrawCall = Row.DrawCalls[ETileGeometryType::Door];
 
-                if (SideCounter > 1 && ForwardCounter == 0 && !Tile->IsEdgeEmpty(POVDirection.Side()))
-                {
-                    continue;
-                }
+        auto& DoorFrameDrawCall = Row.DrawCalls[ETileGeometryType::DoorFrame];
 
-                if (SideCounter == 0 && ForwardCounter >= 1 && !Tile->IsEdgeEmpty(POVDirection.Inverted()))
-                {
-                    break;
-                }
+        for (int ChunkX = 0; ChunkX < LevelDrawData.ChunkCount.X; ++ChunkX)
+        {
+            auto Min = SVec2Int{ ChunkX, ChunkY } * CLevelVisibility::ChunkSize;
+            auto Max = SVec2Int{ std::min(Min.X + CLevelVisibility::ChunkSize, Level->Width), std::min(Min.Y + CLevelVisibility::ChunkSize, Level->Height) };
 
-                if (Tile->CheckFlag(TILE_FLOOR_BIT))
-                {
-                    FloorDrawCall.Push(TileTransform);
-                }
-                else if (Tile->CheckFlag(TILE_HOLE_BIT))
+            /* Joints sit on tile corners, the last row and column of them go to the chunks on the level's edge. */
+            if (Level->bUseWallJoints)
+            {
+                auto JointMax = SVec2Int{ Max.X == Level->Width ? Max.X + 1 : Max.X, Max.Y == Level->Height ? Max.Y + 1 : Max.Y };
+                for (int Y = Min.Y; Y < JointMax.Y; ++Y)
                 {
-                    HoleDrawCall.Push(TileTransform);
+                    for (int X = Min.X; X < JointMax.X; ++X)
+                    {
+                        if (Level->IsWallJointAt({ X, Y }))
+                        {
+                            WallJointDrawCall.PushTile({ X, Y });
+                        }
+                    }
                 }
+            }
 
-                for (auto& Direction : SDirection::All())
+            for (int Y = Min.Y; Y < Max.Y; ++Y)
+            {
+                for (int X = Min.X; X < Max.X; ++X)
                 {
-                    if (Tile->IsEdgeEmpty(Direction))
+                    auto TileCoords = SVec2Int{ X, Y };
+                    auto Tile = Level->GetTileAt(TileCoords);
+
+                    if (Tile->CheckFlag(TILE_FLOOR_BIT))
                     {
-                        continue;
+                        FloorDrawCall.PushTile(TileCoords);
                     }
-
-                    auto Transform = TileTransform;
-                    Transform.Rotate(Direction.RotationFromDirection(),
-                        { 0.0f, 1.0f, 0.0f });
-
-                    if (Tile->CheckEdgeFlag(TILE_EDGE_WALL_BIT, Direction))
+                    else if (Tile->CheckFlag(TILE_HOLE_BIT))
                     {
-                        WallDrawCall.Push(Transform);
+                        HoleDrawCall.PushTile(TileCoords);
                     }
 
-                    if (Tile->CheckEdgeFlag(TILE_EDGE_DOOR_BIT, Direction))
+                    for (auto& Direction : SDirection::All())
                     {
-                        DoorFrameDrawCall.Push(Transform);
+                        if (Tile->IsEdgeEmpty(Direction))
+                        {
+                            continue;
+                        }
 
-                        /* Check two adjacent tiles for ongoing door animation.
-                         * Prevents static doors from being drawn if the animation is playing. */
-                        if (Level->DoorInfo.Timeline.IsPlaying())
+                        if (Tile->CheckEdgeFlag(TILE_EDGE_WALL_BIT, Direction))
                         {
-                            if (TileCoords == Level->DoorInfo.TileCoords && Direction == Level->DoorInfo.Direction)
-                            {
-                                continue;
-                            }
-                            if (TileCoords == POVOrigin && Direction == POVDirectionInverted)
-                            {
-                                continue;
-                            }
+                            WallDrawCall.PushTile(TileCoords, Direction);
                         }
 
-                        Draw3DLevelDoor(DoorDrawCall, TileCoords, Direction, -1.0f);
+                        if (Tile->CheckEdgeFlag(TILE_EDGE_DOOR_BIT, Direction))
+                        {
+                            DoorFrameDrawCall.PushTile(TileCoords, Direction);
+
+                            auto DoorCount = DoorDrawCall.Count;
+                            Draw3DLevelDoor(DoorDrawCall, TileCoords, Direction, -1.0f);
+                            Row.Doors.insert(Row.Doors.end(), DoorDrawCall.Count - DoorCount,
+                                STileInstance{ (int16_t)X, (int16_t)Y, (int16_t)Direction.Index, 0 });
+                        }
                     }
                 }
             }
+
+            for (auto& DrawCall : Row.DrawCalls)
+            {
+                DrawCall.EndChunk();
+            }
+        }
+    };
+    Jobs::ParallelFor("Build Level Draw Set", ChunkRows.size(), 1, [&](std::size_t Begin, std::size_t End) {
+        for (auto ChunkY = Begin; ChunkY < End; ++ChunkY)
+        {
+            BuildChunkRow((int)ChunkY);
         }
-        Level->DirtyFlags &= ~ELevelDirtyFlags::DrawSet;
+    });
 
-        Log::Draw<ELogLevel::Debug>("%s(): Regenerated Level Draw Set", __func__);
+    for (auto& Row : ChunkRows)
+    {
+        for (std::size_t Type = 0; Type < Row.DrawCalls.size(); ++Type)
+        {
+            LevelDrawData.DrawCalls[Type].AppendChunks(Row.DrawCalls[Type]);
+        }
+        LevelDrawData.Doors.insert(LevelDrawData.Doors.end(), Row.Doors.begin(), Row.Doors.end());
     }
+    InstanceBuffer.UploadStatic(LevelDrawData.DrawCalls.data(), (int)LevelDrawData.DrawCalls.size());
+    Level->DirtyFlags &= ~ELevelDirtyFlags::DrawSet;
 
-    Draw3DLevelDoor(
-        DoorDrawCall,
-        Level->DoorInfo.TileCoords,
-        Level->DoorInfo.Direction,
-        Level->DoorInfo.Timeline.Value);
-
-    SEntry3D Entry;
+    Log::Draw<ELogLevel::Debug>("%s(): Built level draw set, %d chunks", __func__, LevelDrawData.TotalChunkCount());
+}
 
-    Entry.Geometry = LevelDrawData.TileSet;
-    Entry.Model = SMat4x4::Identity();
-    Entry.InstancedDrawCall = &LevelDrawData.DrawCalls[0];
-    Entry.InstancedDrawCallCount = ETileGeometryType::Count;
+void SRenderer::UpdateLevelVisibility(const SWorldLevel* Level, const SVec2Int& POVOrigin, const SVec2Int& CameraCoords)
+{
+    /* Mid step the camera is still on the tile being left, which sees things the POV doesn't. */
+    std::array<SVec2Int, 2> Origins{ POVOrigin, CameraCoords };
+    if (!LevelDrawData.bVisibilityDirty && Origins == LevelDrawData.VisibilityOrigins)
+    {
+        return;
+    }
+    LevelDrawData.VisibilityOrigins = Origins;
+    LevelDrawData.bVisibilityDirty = false;
 
-    Entry.Mode = SEntryMode{
-        UBER3D_MODE_LEVEL
-    };
+    auto Marks = Memory::GetFrameVector<uint8_t>();
+    Marks.resize(LevelDrawData.TotalChunkCount());
+    for (auto& Origin : Origins)
+    {
+        Level->Visibility.ForEachChunk(Origin, [&](const SVec2Int& Chunk) {
+            Marks[Chunk.Y * LevelDrawData.ChunkCount.X + Chunk.X] = 1;
+        });
+    }
 
-    Queue3D.Enqueue(Entry);
+    LevelDrawData.PotentiallyVisibleChunks.clear();
+    for (int Chunk = 0; Chunk < (int)Marks.size(); ++Chunk)
+    {
+        if (Marks[Chunk])
+        {
+            LevelDrawData.PotentiallyVisibleChunks.push_back(Chunk);
+        }
+    }
 }
 
 void SRenderer::Draw3DLevelDoor(SInstancedDrawCall& DoorDrawCall, const SVec2Int& TileCoords, SDirection Direction, float AnimationAlpha) const
@@ -1493,8 +2117,24 @@ SSpriteHandle SAtlas::AddSprite(const SAsset& Resource)
     return { this, &Sprites[CurrentIndex++] };
 }
 
+void SAtlas::Decode()
+{
+    Jobs::ParallelFor("Decode Sprites", CurrentIndex, 1, [&](std::size_t Begin, std::size_t End) {
+        for (auto Index = Begin; Index < End; ++Index)
+        {
+            Images[Index] = CRawImage(*Sprites[Index].Resource);
+        }
+    });
+    bDecoded = true;
+}
+
 void SAtlas::Build()
 {
+    if (!bDecoded)
+    {
+        Decode();
+    }
+
     glActiveTexture(GL_TEXTURE0 + TextureUnitID);
     glBindTexture(GL_TEXTURE_2D, ID);
 
@@ -1509,7 +2149,7 @@ void SAtlas::Build()
     for (int Index = 0; Index < CurrentIndex; ++Index)
     {
         auto& Sprite = Sprites[SortingIndices[Index]];
-        CRawImage const Image(*Sprite.Resource);
+        auto& Image = Images[SortingIndices[Index]];
 
         if (CursorX + Image.Width > WidthAndHeight)
         {
@@ -1543,5 +2183,11 @@ void SAtlas::Build()
         }
     }
 
+    for (auto& Image : Images)
+    {
+        Image = CRawImage{};
+    }
+    bDecoded = false;
+
     glActiveTexture(GL_TEXTURE0);
 }
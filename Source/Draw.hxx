@@ -3,6 +3,7 @@
 #include <array>
 #include "CommonTypes.hxx"
 #include "AssetTools.hxx"
+#include "Memory.hxx"
 #include "SharedConstants.hxx"
 #include "Math.hxx"
 #include "Tile.hxx"
@@ -27,7 +28,8 @@ namespace ETextureUnits
         AtlasPrimary3D,
         MainFramebuffer,
         MapFramebuffer,
-        WorldTextures
+        WorldTextures,
+        MapTiles
     };
 }
 
@@ -59,7 +61,7 @@ struct SShaderSprite
     int : 32;
 };
 
-/* @TODO: Redesign so it's easier to upload. */
+/* Tiles themselves live in SMapTilesTexture, levels can be far bigger than a uniform block. */
 struct SShaderMapData
 {
     int32_t Width{};
@@ -68,7 +70,6 @@ struct SShaderMapData
     int : 32;
     int : 32;
     int : 32;
-    std::array<STile, MAX_LEVEL_TILE_COUNT> Tiles{};
 };
 
 struct SShaderWorld
@@ -214,6 +215,7 @@ public:
     SUniformBlock UniformBlockMap{};
     SUniformBlock UniformBlockWorld{};
     int UniformWorldTextures{};
+    int UniformMapTiles{};
 
     void SetEditorData(const SVec2& SelectedTile, const SVec4& SelectedBlock, uint32_t bEnabled, uint32_t bToggleMode, uint32_t bBlockMode) const;
     void SetCursor(const SVec2& Cursor) const;
@@ -225,11 +227,45 @@ protected:
     void InitUniforms() override;
 
 public:
-    int UniformModelID{};
+    int UniformTileInstancesID{};
     int UniformCommonAtlasID{};
     int UniformPrimaryAtlasID{};
 };
 
+/* One RGBA32UI texel per tile, uploaded in whole chunks. Grows to fit the largest level seen so far. */
+struct SMapTilesTexture
+{
+    /* Past this share of dirty tiles between the first and last span, the whole rows are uploaded as one rect instead. */
+    static constexpr float SpanFallbackCoverage = 0.5f;
+
+    unsigned ID{};
+    int TextureUnitID{};
+    SVec2Int Size{};
+
+    /* Upload counters of the frame in progress, and of the last finished one. */
+    std::size_t FrameUploadBytes{};
+    std::size_t FrameUploadCalls{};
+    std::size_t LastFrameUploadBytes{};
+    std::size_t LastFrameUploadCalls{};
+
+    void Init(int InTextureUnitID);
+
+    void Cleanup() const;
+
+    /* Uploads every chunk overlapping the inclusive tile rect, in one call. */
+    void Upload(const struct STilemap* Tilemap, const SRectInt& Rect);
+
+    /* Uploads every chunk touched by the spans, each once. */
+    void Upload(const struct STilemap* Tilemap, const struct SDirtySpans& DirtySpans);
+
+    void EndFrame();
+
+private:
+    void Reserve(const STilemap* Tilemap);
+
+    void UploadChunk(const STilemap* Tilemap, int ChunkX, int ChunkY);
+};
+
 struct SWorldFramebuffer
 {
     int Width{};
@@ -341,9 +377,15 @@ struct SCamera
     float ZNear = 0.01f;
     float ZFar = 100.0f;
 
+    /* Left, right, bottom, top, near and far, as of the last Update(). Normals point inwards. */
+    std::array<SVec4, 6> FrustumPlanes{};
+
     void RegenerateProjection();
 
     void Update();
+
+    /* False only when the box is entirely outside one of the planes, so some boxes near the corners pass. */
+    [[nodiscard]] bool IsBoxVisible(const SVec3& Min, const SVec3& Max) const;
 };
 
 struct STexture
@@ -386,22 +428,121 @@ struct SEntry2D : SEntry
     SVec4 UVRect{};
 };
 
+/* A tile placed on the grid, expanded into its model matrix by Uber3D.vert: 8 bytes instead of a 64 byte matrix.
+ * Rotation is the SDirection index, turning like SDirection::RotationFromDirection(). Variant isn't read by any tileset yet. */
+struct STileInstance
+{
+    int16_t X{};
+    int16_t Z{};
+    int16_t Rotation{};
+    int16_t Variant{};
+};
+
 struct SInstancedDrawCall
 {
     const SSubGeometry* SubGeometry{};
-    std::array<SMat4x4, UBER3D_MODEL_COUNT> Transform{};
+    /* Static tile instances. */
+    std::pmr::vector<STileInstance> Tiles{ Memory::GetPoolResource() };
+    /* First tile instance in the instance buffer, set by SInstanceBuffer::UploadStatic(). */
+    std::size_t TileOffset{};
+    /* Full transforms for anything off the grid: static instances first, then the dynamic ones of this frame. */
+    std::pmr::vector<SMat4x4> Transforms{ Memory::GetPoolResource() };
     int Count{};
     int DynamicCount{};
+    /* First static instance in the instance buffer, set by SInstanceBuffer::UploadStatic(). */
+    std::size_t StaticOffset{};
+    void PushTile(const SVec2Int& Coords, SDirection Direction = SDirection::North())
+    {
+        Tiles.push_back({ (int16_t)Coords.X, (int16_t)Coords.Y, (int16_t)Direction.Index, 0 });
+    }
     void Push(const SMat4x4& NewTransform)
     {
-        Transform[Count % UBER3D_MODEL_COUNT] = NewTransform;
+        Transforms.insert(Transforms.begin() + Count, NewTransform);
         Count++;
     }
     void PushDynamic(const SMat4x4& NewTransform)
     {
-        Transform[(Count + DynamicCount) % UBER3D_MODEL_COUNT] = NewTransform;
+        Transforms.push_back(NewTransform);
         DynamicCount++;
     }
+    void ClearDynamic()
+    {
+        Transforms.resize(Count);
+        DynamicCount = 0;
+    }
+
+    /* Draw calls built chunk by chunk: where each chunk's static tiles and transforms end. */
+    std::pmr::vector<int> ChunkTileEnds{ Memory::GetPoolResource() };
+    std::pmr::vector<int> ChunkTransformEnds{ Memory::GetPoolResource() };
+    /* Static instances drawn this frame, as first and count. */
+    std::pmr::vector<SVec2Int> VisibleTiles{ Memory::GetPoolResource() };
+    std::pmr::vector<SVec2Int> VisibleTransforms{ Memory::GetPoolResource() };
+    void EndChunk()
+    {
+        ChunkTileEnds.push_back((int)Tiles.size());
+        ChunkTransformEnds.push_back(Count);
+    }
+    /* Appends the static instances and chunks of Other after this one's. */
+    void AppendChunks(const SInstancedDrawCall& Other)
+    {
+        auto TileBase = (int)Tiles.size();
+        auto TransformBase = Count;
+        Tiles.insert(Tiles.end(), Other.Tiles.begin(), Other.Tiles.end());
+        Transforms.insert(Transforms.begin() + Count, Other.Transforms.begin(), Other.Transforms.begin() + Other.Count);
+        Count += Other.Count;
+        for (std::size_t Chunk = 0; Chunk < Other.ChunkTileEnds.size(); ++Chunk)
+        {
+            ChunkTileEnds.push_back(TileBase + Other.ChunkTileEnds[Chunk]);
+            ChunkTransformEnds.push_back(TransformBase + Other.ChunkTransformEnds[Chunk]);
+        }
+    }
+    void ShowChunk(std::size_t Chunk)
+    {
+        Show(VisibleTiles, Chunk > 0 ? ChunkTileEnds[Chunk - 1] : 0, ChunkTileEnds[Chunk]);
+        Show(VisibleTransforms, Chunk > 0 ? ChunkTransformEnds[Chunk - 1] : 0, ChunkTransformEnds[Chunk]);
+    }
+    void ShowAll()
+    {
+        Show(VisibleTiles, 0, (int)Tiles.size());
+        Show(VisibleTransforms, 0, Count);
+    }
+    /* Splits a static transform out of the visible ranges. */
+    void HideTransform(int Index)
+    {
+        for (std::size_t RangeIndex = 0; RangeIndex < VisibleTransforms.size(); ++RangeIndex)
+        {
+            auto Range = VisibleTransforms[RangeIndex];
+            if (Index >= Range.X && Index < Range.X + Range.Y)
+            {
+                VisibleTransforms[RangeIndex].Y = Index - Range.X;
+                VisibleTransforms.insert(VisibleTransforms.begin() + (std::ptrdiff_t)RangeIndex + 1, { Index + 1, Range.X + Range.Y - Index - 1 });
+                return;
+            }
+        }
+    }
+    void ClearVisible()
+    {
+        VisibleTiles.clear();
+        VisibleTransforms.clear();
+    }
+
+private:
+    /* Chunks are shown in order, so neighbors in a row merge into one range. */
+    static void Show(std::pmr::vector<SVec2Int>& Ranges, int First, int Last)
+    {
+        if (First >= Last)
+        {
+            return;
+        }
+        if (!Ranges.empty() && Ranges.back().X + Ranges.back().Y == First)
+        {
+            Ranges.back().Y += Last - First;
+        }
+        else
+        {
+            Ranges.push_back({ First, Last - First });
+        }
+    }
 };
 
 template <int Size>
@@ -414,11 +555,119 @@ struct SInstancedDrawData
     {
         for (auto& DrawCall : DrawCalls)
         {
+            DrawCall.Tiles.clear();
+            DrawCall.Transforms.clear();
             DrawCall.Count = 0;
+            DrawCall.DynamicCount = 0;
+            DrawCall.ChunkTileEnds.clear();
+            DrawCall.ChunkTransformEnds.clear();
+            DrawCall.ClearVisible();
         }
     }
 };
 
+/* Static geometry of a whole level, built once and kept in the instance buffer, with instances grouped by CLevelVisibility chunks.
+ * Each frame only chunks in the level's baked visibility of the POV that touch the camera frustum are drawn. */
+struct SLevelDrawData : SInstancedDrawData<ETileGeometryType::Count>
+{
+    /* The level the draw calls were built from. */
+    const SWorldLevel* Level{};
+    SVec2Int ChunkCount{};
+    /* The door each static door transform belongs to, the coords and SDirection index of its edge. */
+    std::pmr::vector<STileInstance> Doors{ Memory::GetPoolResource() };
+
+    /* Chunks in sight of the tiles in VisibilityOrigins, in order. */
+    std::pmr::vector<int> PotentiallyVisibleChunks{ Memory::GetPoolResource() };
+    std::array<SVec2Int, 2> VisibilityOrigins{};
+    bool bVisibilityDirty = true;
+    int VisibleChunkCount{};
+
+    [[nodiscard]] int TotalChunkCount() const { return ChunkCount.X * ChunkCount.Y; }
+};
+
+/* Instance data, read by Uber3D as per-instance attributes: either a full transform or a compact tile instance.
+ * Static instances stay uploaded until the draw set changes. Dynamic ones are streamed through a ring of frame regions, each fenced until the GPU is done reading it. */
+struct SInstanceBuffer
+{
+    static constexpr std::size_t FrameCount = 3;
+    /* Dynamic instances per frame, any more are dropped. */
+    static constexpr std::size_t FrameCapacity = 1024;
+    /* Takes four locations, one per column. */
+    static constexpr unsigned AttributeLocation = 3;
+    static constexpr unsigned TileAttributeLocation = 7;
+
+    unsigned StaticVBO{};
+    unsigned TileVBO{};
+    unsigned StreamVBO{};
+    std::size_t StaticCapacity{};
+    std::size_t TileCapacity{};
+    std::size_t Frame{};
+    std::size_t FrameOffset{};
+    /* GLsync of the frame that last wrote each region. */
+    std::array<void*, FrameCount> Fences{};
+
+    /* Upload counters of the frame in progress, and of the last finished one. */
+    std::size_t FrameUploadBytes{};
+    std::size_t LastFrameUploadBytes{};
+
+    void Init();
+
+    void Cleanup();
+
+    /* Packs the static instances of the draw calls together and sets their offsets. */
+    void UploadStatic(SInstancedDrawCall* DrawCalls, int DrawCallCount);
+
+    /* Returns the offset of the written instances in the stream buffer, or SIZE_MAX when the frame region is full. */
+    std::size_t Stream(const SMat4x4* Transforms, std::size_t Count);
+
+    /* Points the transform attribute of the bound vertex array at Offset instances into VBO. */
+    static void Bind(unsigned VBO, std::size_t Offset);
+
+    /* Points the tile attribute of the bound vertex array at Offset tile instances into TileVBO. */
+    void BindTiles(std::size_t Offset) const;
+
+    /* Back to per-vertex-array constant values, for draws without instance data. */
+    static void Unbind();
+
+    void EndFrame();
+};
+
+/* Layout read by glMultiDrawElementsIndirect. */
+struct SDrawElementsIndirectCommand
+{
+    uint32_t Count{};
+    uint32_t InstanceCount{};
+    uint32_t FirstIndex{};
+    int32_t BaseVertex{};
+    uint32_t BaseInstance{};
+};
+
+/* Draw commands for glMultiDrawElementsIndirect, rebuilt every frame. Instance data is addressed through BaseInstance,
+ * so the draw needs ARB_base_instance next to ARB_multi_draw_indirect; neither is core in 4.1, without them bSupported stays false. */
+struct SIndirectDrawBuffer
+{
+    unsigned IBO{};
+    std::size_t Capacity{};
+    bool bSupported{};
+    std::pmr::vector<SDrawElementsIndirectCommand> Commands{ Memory::GetPoolResource() };
+
+    void Init();
+
+    void Cleanup();
+
+    /* Uploads Commands, draws refer to them by index. */
+    void Upload();
+
+    void Draw(std::size_t First, std::size_t Count) const;
+};
+
+/* What Flush() sent to the driver. State changes are program, vertex array and framebuffer binds, uniform uploads and instance attribute setups. */
+struct SRenderStats
+{
+    std::size_t DrawCalls{};
+    std::size_t StateChanges{};
+};
+
 struct SEntry3D : SEntry
 {
     SMat4x4 Model{};
@@ -470,6 +719,8 @@ private:
     static constexpr int WidthAndHeight = ATLAS_SIZE;
     int CurrentIndex{};
     int TextureUnitID{};
+    bool bDecoded{};
+    std::array<CRawImage, ATLAS_MAX_SPRITE_COUNT> Images;
 
 public:
     std::array<SSprite, ATLAS_MAX_SPRITE_COUNT> Sprites;
@@ -478,6 +729,9 @@ public:
 
     SSpriteHandle AddSprite(const SAsset& Resource);
 
+    /* Decodes the added sprites on the job threads, safe to call off the main thread. Build() does it when nobody did. */
+    void Decode();
+
     void Build();
 };
 
@@ -497,8 +751,17 @@ struct SRenderer
 
     SMainFramebuffer MainFramebuffer;
     SWorldFramebuffer WorldLayersFramebuffer;
+    SMapTilesTexture MapTilesTexture;
     SGeometry Quad2D;
-    SInstancedDrawData<ETileGeometryType::Count> LevelDrawData;
+    SLevelDrawData LevelDrawData;
+    SInstanceBuffer InstanceBuffer;
+    SIndirectDrawBuffer IndirectDrawBuffer;
+    /* Instanced entries go through IndirectDrawBuffer when it's supported, can be turned off to compare. */
+    bool bUseMultiDrawIndirect = true;
+
+    /* Counters of the frame in progress, and of the last finished one. */
+    SRenderStats FrameStats{};
+    SRenderStats LastFrameStats{};
 
     void Init(int Width, int Height);
 
@@ -508,7 +771,7 @@ struct SRenderer
 
     /* Map */
     void SetMapIcons(const std::array<SSpriteHandle, MAP_ICON_COUNT>& SpriteHandles) const;
-    void UploadMapData(const SWorldLevel* Level, const SCoordsAndDirection& POV) const;
+    void UploadMapData(const SWorldLevel* Level, const SCoordsAndDirection& POV);
 
     void UploadProjectionAndViewFromCamera(const SCamera& Camera) const;
 
@@ -553,9 +816,15 @@ struct SRenderer
 
     void Draw3D(SVec3 Position, SGeometry* Geometry);
 
-    void Draw3DLevel(SWorldLevel* Level, const SVec2Int& POVOrigin, const SDirection& POVDirection);
+    void Draw3DLevel(SWorldLevel* Level, const SVec2Int& POVOrigin, const SCamera& Camera);
 
     void Draw3DLevelDoor(SInstancedDrawCall& DoorDrawCall, const SVec2Int& TileCoords, SDirection Direction, float AnimationAlpha = 0.0f) const;
 
+    /* Rebuilds the static draw calls of the whole level, a row of chunks per job, and uploads them. */
+    void BuildLevelDrawSet(SWorldLevel* Level);
+
+    /* Picks the chunks in sight of the POV and the tile the camera is in, only when either changed tiles. */
+    void UpdateLevelVisibility(const SWorldLevel* Level, const SVec2Int& POVOrigin, const SVec2Int& CameraCoords);
+
 #pragma endregion
 };
@@ -0,0 +1,283 @@
+#include "FieldOfView.hxx"
+
+#include <algorithm>
+#include <cmath>
+#include "Memory.hxx"
+#include "Tilemap.hxx"
+
+static int CompareSlopes(const SSlope& A, const SSlope& B)
+{
+    auto Left = (int64_t)A.Lateral * B.Depth;
+    auto Right = (int64_t)B.Lateral * A.Depth;
+    return (Left > Right) - (Left < Right);
+}
+
+/* Anything steeper than a quadrant's edges. */
+static constexpr SSlope MinSlope{ -2, 1 };
+static constexpr SSlope MaxSlope{ 2, 1 };
+
+/* Walks one quadrant row by row: Forward is the row direction, Lateral offsets are towards Right. */
+class CQuadrantCaster
+{
+public:
+    CQuadrantCaster(const STilemap& InTilemap, const SVec2Int& InOrigin, SDirection InForward, std::pmr::vector<SLightSpan>& InSpans,
+        std::pmr::vector<SLightSpan>& InScratchSpans)
+        : Tilemap(InTilemap), Origin(InOrigin), Forward(InForward), Right(InForward), Spans(InSpans), ScratchSpans(InScratchSpans)
+    {
+        Right.CycleCW();
+        Left = Right.Inverted();
+        ForwardVector = Forward.GetVector<int>();
+        RightVector = Right.GetVector<int>();
+    }
+
+    void Cast(int Radius, ERevealShape::Type Shape, std::pmr::vector<SVec2Int>& OutVisible)
+    {
+        Spans.clear();
+        Spans.push_back({ { -1, 1 }, { 1, 1 }, false, false });
+
+        for (auto Depth = 1; Depth <= Radius && !Spans.empty(); ++Depth)
+        {
+            auto BoundaryDepth = 2 * Depth - 1;
+
+            /* Only columns the remaining rays can reach while crossing this row, with a tile of slack for rounding. */
+            auto MinLateral = std::max((int)std::floor((double)Spans.front().Min.Lateral / Spans.front().Min.Depth * (Depth + 0.5)) - 1, -Depth);
+            auto MaxLateral = std::min((int)std::ceil((double)Spans.back().Max.Lateral / Spans.back().Max.Depth * (Depth + 0.5)) + 1, Depth);
+
+            /* Edges between the previous row and this one. */
+            for (auto Lateral = std::max(MinLateral, -(Depth - 1)); Lateral <= std::min(MaxLateral, Depth - 1); ++Lateral)
+            {
+                if (!IsClear(Lateral, Depth - 1, Forward))
+                {
+                    Cut({ 2 * Lateral - 1, BoundaryDepth }, true, { 2 * Lateral + 1, BoundaryDepth }, true);
+                }
+            }
+
+            /* Corners on the same boundary, Corner + 0.5 being their lateral offset. */
+            for (auto Corner = MinLateral; Corner <= std::min(MaxLateral, Depth - 1); ++Corner)
+            {
+                SSlope Slope{ 2 * Corner + 1, BoundaryDepth };
+                if (!IsLit(Slope))
+                {
+                    continue;
+                }
+                auto Side = Corner >= 0 ? Right : Left;
+                auto From = Corner >= 0 ? Corner : Corner + 1;
+                auto To = Corner >= 0 ? Corner + 1 : Corner;
+                auto bForwardFirst = IsClear(From, Depth - 1, Forward) && IsClear(From, Depth, Side);
+                auto bSideFirst = IsClear(From, Depth - 1, Side) && IsClear(To, Depth - 1, Forward);
+                if (!bForwardFirst && !bSideFirst)
+                {
+                    Cut(Slope, false, Slope, false);
+                }
+            }
+
+            /* Quadrants share their diagonals, each one only reports the one on its right. */
+            for (auto Lateral = std::max(MinLateral, -Depth + 1); Lateral <= MaxLateral; ++Lateral)
+            {
+                auto Coords = ToCoords(Lateral, Depth);
+                if (ERevealShape::Contains(Shape, Lateral, Depth, Radius) && Tilemap.IsValidTile(Coords) && IsLit({ Lateral, Depth }))
+                {
+                    OutVisible.push_back(Coords);
+                }
+            }
+
+            if (Depth == Radius)
+            {
+                break;
+            }
+
+            /* Edges between columns of this row, crossed anywhere along the row's depth. */
+            for (auto Corner = MinLateral; Corner <= std::min(MaxLateral, Depth - 1); ++Corner)
+            {
+                if (IsClear(Corner, Depth, Right))
+                {
+                    continue;
+                }
+                SSlope Near{ 2 * Corner + 1, 2 * Depth - 1 };
+                SSlope Far{ 2 * Corner + 1, 2 * Depth + 1 };
+                if (Corner >= 0)
+                {
+                    Cut(Far, true, Near, true);
+                }
+                else
+                {
+                    Cut(Near, true, Far, true);
+                }
+            }
+        }
+    }
+
+private:
+    const STilemap& Tilemap;
+    SVec2Int Origin;
+    SDirection Forward;
+    SDirection Right;
+    SDirection Left{};
+    SVec2Int ForwardVector{};
+    SVec2Int RightVector{};
+    std::pmr::vector<SLightSpan>& Spans;
+    std::pmr::vector<SLightSpan>& ScratchSpans;
+
+    [[nodiscard]] SVec2Int ToCoords(int Lateral, int Depth) const
+    {
+        return Origin + RightVector * Lateral + ForwardVector * Depth;
+    }
+
+    /* Sight crosses the edge only when neither tile has a wall or door on it. */
+    [[nodiscard]] bool IsClear(int Lateral, int Depth, SDirection Direction) const
+    {
+        auto Coords = ToCoords(Lateral, Depth);
+        auto Neighbor = Coords + Direction.GetVector<int>();
+        if (!Tilemap.IsValidTile(Coords) || !Tilemap.IsValidTile(Neighbor))
+        {
+            return false;
+        }
+        return ETileAdjacency::IsEmpty(Tilemap.Adjacency[Tilemap.CoordsToIndex(Coords)], Direction) &&
+            ETileAdjacency::IsEmpty(Tilemap.Adjacency[Tilemap.CoordsToIndex(Neighbor)], Direction.Inverted());
+    }
+
+    [[nodiscard]] bool IsLit(const SSlope& Slope) const
+    {
+        for (auto& Span : Spans)
+        {
+            auto MinOrder = CompareSlopes(Slope, Span.Min);
+            auto MaxOrder = CompareSlopes(Slope, Span.Max);
+            if ((MinOrder > 0 || (MinOrder == 0 && !Span.bMinOpen)) && (MaxOrder < 0 || (MaxOrder == 0 && !Span.bMaxOpen)))
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /* Removes the rays between Min and Max, the bounds themselves only when open. */
+    void Cut(const SSlope& Min, bool bMinOpen, const SSlope& Max, bool bMaxOpen)
+    {
+        /* Most blocked edges are already in shadow. */
+        auto bOverlaps = std::any_of(Spans.begin(), Spans.end(), [&](const SLightSpan& Span) {
+            return CompareSlopes(Span.Min, Max) < 0 && CompareSlopes(Min, Span.Max) < 0;
+        });
+        if (!bOverlaps && !(CompareSlopes(Min, Max) == 0 && IsLit(Min)))
+        {
+            return;
+        }
+
+        ScratchSpans.clear();
+        for (auto& Span : Spans)
+        {
+            Intersect(Span, { MinSlope, Min, false, !bMinOpen });
+            Intersect(Span, { Max, MaxSlope, !bMaxOpen, false });
+        }
+        std::swap(Spans, ScratchSpans);
+    }
+
+    void Intersect(const SLightSpan& Span, const SLightSpan& Bounds)
+    {
+        auto Result = Span;
+        auto MinOrder = CompareSlopes(Span.Min, Bounds.Min);
+        if (MinOrder < 0)
+        {
+            Result.Min = Bounds.Min;
+            Result.bMinOpen = Bounds.bMinOpen;
+        }
+        else if (MinOrder == 0)
+        {
+            Result.bMinOpen |= Bounds.bMinOpen;
+        }
+        auto MaxOrder = CompareSlopes(Span.Max, Bounds.Max);
+        if (MaxOrder > 0)
+        {
+            Result.Max = Bounds.Max;
+            Result.bMaxOpen = Bounds.bMaxOpen;
+        }
+        else if (MaxOrder == 0)
+        {
+            Result.bMaxOpen |= Bounds.bMaxOpen;
+        }
+        auto Order = CompareSlopes(Result.Min, Result.Max);
+        if (Order < 0 || (Order == 0 && !Result.bMinOpen && !Result.bMaxOpen))
+        {
+            ScratchSpans.push_back(Result);
+        }
+    }
+};
+
+std::pmr::vector<SVec2Int> FieldOfView::Compute(const STilemap& Tilemap, const SVec2Int& Origin, int Radius, ERevealShape::Type Shape)
+{
+    auto Visible = Memory::GetFrameVector<SVec2Int>();
+    SScratch Scratch{ Memory::GetFrameVector<SLightSpan>(), Memory::GetFrameVector<SLightSpan>() };
+    Compute(Tilemap, Origin, Radius, Shape, Visible, Scratch);
+    return Visible;
+}
+
+void FieldOfView::Compute(const STilemap& Tilemap, const SVec2Int& Origin, int Radius, ERevealShape::Type Shape, std::pmr::vector<SVec2Int>& OutVisible,
+    SScratch& Scratch)
+{
+    OutVisible.clear();
+    if (!Tilemap.IsValidTile(Origin))
+    {
+        return;
+    }
+    OutVisible.push_back(Origin);
+    if (Tilemap.Adjacency.size() != Tilemap.TileCount())
+    {
+        /* Not post-processed yet, every edge counts as blocked. */
+        return;
+    }
+
+    for (auto& Direction : SDirection::All())
+    {
+        CQuadrantCaster{ Tilemap, Origin, Direction, Scratch.Spans, Scratch.ScratchSpans }.Cast(Radius, Shape, OutVisible);
+    }
+}
+
+std::pmr::vector<SVec2Size> FieldOfView::Reveal(STilemap& Tilemap, const SVec2Int& Origin, int Radius, ERevealShape::Type Shape)
+{
+    /* Row-major order puts the tiles of one plane word next to each other, and yields the explored indices sorted. */
+    auto Visible = Compute(Tilemap, Origin, Radius, Shape);
+    std::sort(Visible.begin(), Visible.end(), [](const SVec2Int& A, const SVec2Int& B) {
+        return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+    });
+
+    auto& Planes = Tilemap.Bitplanes;
+    auto bHasPlanes = Planes.IsBuiltFor(Tilemap);
+    auto DirtyRanges = Memory::GetFrameVector<SVec2Size>();
+    for (std::size_t VisibleIndex = 0; VisibleIndex < Visible.size();)
+    {
+        auto Y = Visible[VisibleIndex].Y;
+        auto Word = Visible[VisibleIndex].X / 64;
+        uint64_t Bits{};
+        for (; VisibleIndex < Visible.size() && Visible[VisibleIndex].Y == Y && Visible[VisibleIndex].X / 64 == Word; ++VisibleIndex)
+        {
+            Bits |= uint64_t(1) << (Visible[VisibleIndex].X % 64);
+        }
+        if (bHasPlanes)
+        {
+            /* Keep only the tiles seen for the first time. */
+            auto& Explored = Planes.RowMutable(ETileBitplane::Explored, Y)[Word];
+            Bits &= ~Explored;
+            Explored |= Bits;
+        }
+        for (; Bits != 0; Bits &= Bits - 1)
+        {
+            auto Coords = SVec2Int{ Word * 64 + __builtin_ctzll(Bits), Y };
+            auto Tile = Tilemap.GetTileAtMutable(Coords);
+            if (Tile->CheckSpecialFlag(TILE_SPECIAL_EXPLORED_BIT))
+            {
+                continue;
+            }
+            Tile->SetSpecialFlag(TILE_SPECIAL_EXPLORED_BIT);
+
+            auto Index = Tilemap.CoordsToIndex(Coords);
+            if (!DirtyRanges.empty() && DirtyRanges.back().Y + 1 == Index)
+            {
+                DirtyRanges.back().Y = Index;
+            }
+            else
+            {
+                DirtyRanges.push_back({ Index, Index });
+            }
+        }
+    }
+    return DirtyRanges;
+}
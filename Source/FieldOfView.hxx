@@ -0,0 +1,73 @@
+#pragma once
+
+#include <memory_resource>
+#include "CommonTypes.hxx"
+#include "Math.hxx"
+#include "Memory.hxx"
+
+struct STilemap;
+
+namespace ERevealShape
+{
+    using Type = uint8_t;
+    enum : Type
+    {
+        Diamond, /* Manhattan distance. */
+        Square, /* Chebyshev distance. */
+        Circle /* Euclidean distance, rounded outwards so the flat sides aren't single tiles. */
+    };
+
+    [[nodiscard]] constexpr bool Contains(Type Shape, int X, int Y, int Radius)
+    {
+        X = X < 0 ? -X : X;
+        Y = Y < 0 ? -Y : Y;
+        switch (Shape)
+        {
+            case Square:
+                return X <= Radius && Y <= Radius;
+            case Circle:
+                return X * X + Y * Y <= Radius * Radius + Radius;
+            default:
+                return X + Y <= Radius;
+        }
+    }
+}
+
+/* Ray slope as lateral offset over depth, kept as a fraction so corner rays compare exactly. Depth is always positive. */
+struct SSlope
+{
+    int32_t Lateral;
+    int32_t Depth;
+};
+
+/* Rays that are still unobstructed, an interval of slopes. */
+struct SLightSpan
+{
+    SSlope Min;
+    SSlope Max;
+    bool bMinOpen;
+    bool bMaxOpen;
+};
+
+/* Shadowcasting over tile edges: walls and doors block sight, tiles themselves never do.
+ * A tile is visible when the ray from the center of Origin to its center doesn't cross a blocked edge or leave the level.
+ * A ray through a corner gets past when either way around the corner is clear. */
+namespace FieldOfView
+{
+    /* The spans Compute works through, kept by callers running it in a loop so it doesn't allocate every time. */
+    struct SScratch
+    {
+        std::pmr::vector<SLightSpan> Spans{ Memory::GetPoolResource() };
+        std::pmr::vector<SLightSpan> ScratchSpans{ Memory::GetPoolResource() };
+    };
+
+    /* Visible tiles within Radius of Origin, each once, Origin first. Empty if Origin is outside the level. */
+    std::pmr::vector<SVec2Int> Compute(const STilemap& Tilemap, const SVec2Int& Origin, int Radius, ERevealShape::Type Shape);
+
+    /* Same, into OutVisible, which is cleared first. */
+    void Compute(const STilemap& Tilemap, const SVec2Int& Origin, int Radius, ERevealShape::Type Shape, std::pmr::vector<SVec2Int>& OutVisible,
+        SScratch& Scratch);
+
+    /* Marks visible tiles as explored. Returns the newly explored tiles as sorted, merged inclusive index ranges. */
+    std::pmr::vector<SVec2Size> Reveal(STilemap& Tilemap, const SVec2Int& Origin, int Radius, ERevealShape::Type Shape);
+}
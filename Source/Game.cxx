@@ -7,11 +7,14 @@
 #include "Constants.hxx"
 #include "Log.hxx"
 #include "Math.hxx"
+#include "Memory.hxx"
 #include "Player.hxx"
 #include "SharedConstants.hxx"
 #include "AssetTools.hxx"
 #include "Audio.hxx"
 #include "Draw.hxx"
+#include "FieldOfView.hxx"
+#include "Jobs.hxx"
 #include "Serialization.hxx"
 
 namespace Asset::Common
@@ -63,6 +66,7 @@ static const SRectInt WorldRect{ Constants::ReferenceWidth - 128, MapRectMin.Min
 SGame::SGame()
     : MapRect(MapRectMin)
 {
+    Jobs::Init();
     Platform.Init();
     Audio.Init();
 
@@ -81,32 +85,48 @@ SGame::SGame()
     MapIcons[MAP_ICON_A] = CommonAtlas.AddSprite(Asset::HUD::MapIconA);
     MapIcons[MAP_ICON_B] = CommonAtlas.AddSprite(Asset::HUD::MapIconB);
     MapIcons[MAP_ICON_HOLE] = CommonAtlas.AddSprite(Asset::HUD::MapIconHole);
-    CommonAtlas.Build();
-
-    Renderer.SetMapIcons(MapIcons);
 
     auto& PrimaryAtlas2D = Renderer.Atlases[ATLAS_PRIMARY2D];
     AngelSprite = PrimaryAtlas2D.AddSprite(
         Asset::Common::AngelPNG);
     FrameSprite = PrimaryAtlas2D.AddSprite(
         Asset::Common::FramePNG);
-    PrimaryAtlas2D.Build();
 
     auto& PrimaryAtlas3D = Renderer.Atlases[ATLAS_PRIMARY3D];
     PrimaryAtlas3D.AddSprite(
         Asset::Tileset::Hotel::AtlasPNG);
-    PrimaryAtlas3D.Build();
-
-    Tileset.InitBasic(
-        Asset::Tileset::Hotel::FloorOBJ,
-        Asset::Tileset::Hotel::HoleOBJ,
-        Asset::Tileset::Hotel::WallOBJ,
-        Asset::Tileset::Hotel::WallJointOBJ,
-        Asset::Tileset::Hotel::DoorFrameOBJ,
-        Asset::Tileset::Hotel::DoorOBJ);
-    Tileset.DoorAnimationType = EDoorAnimationType::TwoDoors;
-    Tileset.DoorOffset = 0.22f;
-    Renderer.SetupTileset(&Tileset);
+
+    World.Init();
+
+    /* Decoding and the first level load run on the job threads, anything touching GL stays on the main thread. */
+    CFrameGraph Startup;
+    auto DecodeCommon = Startup.Add("Decode Common Atlas", [&] { CommonAtlas.Decode(); });
+    auto Decode2D = Startup.Add("Decode Primary 2D Atlas", [&] { PrimaryAtlas2D.Decode(); });
+    auto Decode3D = Startup.Add("Decode Primary 3D Atlas", [&] { PrimaryAtlas3D.Decode(); });
+    Startup.Add("Load Start Level", [this] { World.SetCurrentLevel(LevelStreamer, World.StartInfo.LevelIndex); });
+    Startup.Add(
+        "Build Atlases", [&] {
+            CommonAtlas.Build();
+            PrimaryAtlas2D.Build();
+            PrimaryAtlas3D.Build();
+            Renderer.SetMapIcons(MapIcons);
+        },
+        { DecodeCommon, Decode2D, Decode3D }, true);
+    Startup.Add(
+        "Init Tileset", [this] {
+            Tileset.InitBasic(
+                Asset::Tileset::Hotel::FloorOBJ,
+                Asset::Tileset::Hotel::HoleOBJ,
+                Asset::Tileset::Hotel::WallOBJ,
+                Asset::Tileset::Hotel::WallJointOBJ,
+                Asset::Tileset::Hotel::DoorFrameOBJ,
+                Asset::Tileset::Hotel::DoorOBJ);
+            Tileset.DoorAnimationType = EDoorAnimationType::TwoDoors;
+            Tileset.DoorOffset = 0.22f;
+            Renderer.SetupTileset(&Tileset);
+        },
+        {}, true);
+    Startup.Execute();
 
     Camera.RegenerateProjection();
 
@@ -149,8 +169,6 @@ SGame::SGame()
 
     // ChangeLevel(Asset::Map::TestMapERM);
 
-    World.Init();
-
     Renderer.DrawWorldLayers(&World, { 0, 4 });
 
     Blob.Coords = World.StartInfo.POV.Coords;
@@ -213,6 +231,16 @@ void SGame::Run()
         Platform.DeltaTime = (float)(Platform.Now - Platform.Last) / 1000.0f * Platform.TimeScale;
         Platform.Seconds += Platform.DeltaTime;
 
+        Memory::NextFrame();
+        Jobs::NextFrame();
+
+        if (World.UpdateStreaming(LevelStreamer))
+        {
+            /* Drawing the layers goes through the map texture, the current level is uploaded again afterwards. */
+            Renderer.DrawWorldLayers(&World, { 0, 4 });
+            Renderer.UploadMapData(World.GetLevel(), Blob.UnreliableCoordsAndDirection());
+        }
+
         SDL_Event Event;
         while (SDL_PollEvent(&Event))
         {
@@ -283,7 +311,7 @@ void SGame::Run()
             // Renderer.Draw3D({ -7.0f, 0.0f, -4.0f }, &Floor);
 
             World.Update(Platform.DeltaTime);
-            Renderer.Draw3DLevel(World.GetLevel(), Blob.Coords, Blob.Direction);
+            Renderer.Draw3DLevel(World.GetLevel(), Blob.Coords, Camera);
 
             MapRectTimeline.Advance(Platform.DeltaTime);
             auto MapRectFrom = SRect(bMapMaximized ? MapRectMin : MapRectMax);
@@ -335,6 +363,9 @@ void SGame::Run()
 #ifdef EQUINOX_REACH_DEVELOPMENT
     DevTools.Cleanup();
 #endif
+    LevelStreamer.Cleanup();
+    World.Cleanup();
+    Jobs::Cleanup();
     Renderer.Cleanup();
     /* @TODO: Fix this. */
     DoorCreek.Free();
@@ -487,13 +518,13 @@ void SGame::HandleBlobMovement()
 bool SGame::AttemptBlobStep(SDirection Direction)
 {
     auto Level = World.GetLevel();
-    auto CurrentTile = Level->GetTileAt(Blob.Coords);
-    if (CurrentTile == nullptr)
+    if (!Level->IsValidTile(Blob.Coords))
     {
         return false;
     }
+    auto Adjacency = Level->GetAdjacency(Blob.Coords);
 
-    if (!CurrentTile->IsEdgeTraversable(Direction))
+    if (!(Adjacency & ETileAdjacency::Open(Direction)))
     {
         if (Direction == Blob.Direction)
         {
@@ -503,14 +534,14 @@ bool SGame::AttemptBlobStep(SDirection Direction)
         return false;
     }
 
-    auto DirectionVector = Direction.GetVector<int>();
-    auto NextTile = Level->GetTileAt(Blob.Coords + DirectionVector);
-    if (NextTile == nullptr || !NextTile->IsWalkable())
+    if (!(Adjacency & ETileAdjacency::Passable(Direction)))
     {
         return false;
     }
 
-    if (CurrentTile->IsDoorEdge(Direction))
+    auto DirectionVector = Direction.GetVector<int>();
+
+    if (Adjacency & ETileAdjacency::Door(Direction))
     {
         if (Direction.Index != Blob.Direction.Index)
         {
@@ -523,7 +554,7 @@ bool SGame::AttemptBlobStep(SDirection Direction)
 
         Audio.Play(DoorCreek);
     }
-    else if (NextTile->CheckFlag(TILE_HOLE_BIT))
+    else if (Level->GetAdjacency(Blob.Coords + DirectionVector) & ETileAdjacency::Hole)
     {
         Blob.Step(DirectionVector, EBlobAnimationType::Fall);
     }
@@ -549,90 +580,35 @@ void SGame::OnBlobMoved()
         return;
     }
 
-    SVec2Size DirtyRange{ SIZE_MAX, SIZE_MAX };
-
     if (!CurrentTile->CheckSpecialFlag(TILE_SPECIAL_VISITED_BIT))
     {
         CurrentTile->SetSpecialFlag(TILE_SPECIAL_VISITED_BIT);
-
-        DirtyRange.X = Level->CoordsToIndex(Blob.Coords);
-        DirtyRange.Y = DirtyRange.X;
-    }
-
-    auto RevealTile = [&](SVec2Int Coords, SDirection Direction) {
-        auto Tile = Level->GetTileAtMutable(Coords);
-        if (Tile != nullptr)
+        if (Level->Bitplanes.IsBuiltFor(*Level))
         {
-            if (!Tile->CheckSpecialFlag(TILE_SPECIAL_EXPLORED_BIT))
-            {
-                Tile->SetSpecialFlag(TILE_SPECIAL_EXPLORED_BIT);
-                std::size_t Index = Level->CoordsToIndex(Coords);
-                DirtyRange.X = std::min(DirtyRange.X, Index);
-                DirtyRange.Y = std::max(DirtyRange.Y, Index);
-            }
-
-            if (Tile->IsEdgeEmpty(Direction))
-            {
-                return true;
-            }
+            Level->Bitplanes.Set(ETileBitplane::Visited, Blob.Coords.X, Blob.Coords.Y, true);
         }
-        return false;
-    };
 
-    auto RevealTileDiagonal = [&](SVec2Int Coords, SDirection DirectionA, SDirection DirectionB) {
-        auto TileA = Level->GetTileAt(Coords + DirectionA.GetVector<int>());
-        auto TileB = Level->GetTileAt(Coords + DirectionB.GetVector<int>());
-        if (TileA != nullptr && TileB != nullptr)
-        {
-            if (CurrentTile->IsEdgeEmpty(DirectionA) && CurrentTile->IsEdgeEmpty(DirectionB))
-            {
-                RevealTile(Blob.Coords + DirectionA.GetVector<int>() + DirectionB.GetVector<int>(), SDirection::North());
-            }
-        }
-    };
-
-    if (Player.Upgrades & EPlayerUpgrades::RevealShapeBlock)
-    {
-        for (auto Y = Blob.Coords.Y - Player.ExploreRadius(); Y <= Blob.Coords.Y + Player.ExploreRadius(); ++Y)
-        {
-            for (auto X = Blob.Coords.X - Player.ExploreRadius(); X <= Blob.Coords.X + Player.ExploreRadius(); ++X)
-            {
-                RevealTile({ X, Y }, SDirection());
-            }
-        }
+        auto Index = Level->CoordsToIndex(Blob.Coords);
+        Level->DirtySpans.Add(Index, Index);
     }
-    else
-    {
-        for (auto& Direction : SDirection::All())
-        {
-            for (auto Index = 0; Index < 3; Index++)
-            {
-                if (!RevealTile(Blob.Coords + Direction.GetVector<int>() * Index, Direction))
-                {
-                    break;
-                }
-            }
-        }
 
-        RevealTileDiagonal(Blob.Coords, SDirection::North(), SDirection::East());
-        RevealTileDiagonal(Blob.Coords, SDirection::South(), SDirection::East());
-        RevealTileDiagonal(Blob.Coords, SDirection::North(), SDirection::West());
-        RevealTileDiagonal(Blob.Coords, SDirection::South(), SDirection::West());
+    for (auto& Range : FieldOfView::Reveal(*Level, Blob.Coords, Player.ExploreRadius(), Player.RevealShape()))
+    {
+        Level->DirtySpans.Add(Range.X, Range.Y);
     }
 
-    if (DirtyRange.X != SIZE_MAX)
+    if (!Level->DirtySpans.IsEmpty())
     {
         Level->DirtyFlags |= ELevelDirtyFlags::DirtyRange;
-        Level->DirtyRange = DirtyRange;
     }
 
-    Level->DirtyFlags |= ELevelDirtyFlags::DrawSet;
     Level->DirtyFlags |= ELevelDirtyFlags::POVChanged;
 }
 
 void SGame::ChangeLevel()
 {
     World.GetLevel()->PostProcess();
+    World.GetLevel()->DirtyFlags |= ELevelDirtyFlags::Navigation | ELevelDirtyFlags::DrawSet;
     OnBlobMoved();
     Renderer.UploadMapData(World.GetLevel(), Blob.UnreliableCoordsAndDirection());
 }
@@ -640,13 +616,19 @@ void SGame::ChangeLevel()
 void SGame::ChangeLevel(const SWorldLevel& NewLevel)
 {
     *World.GetLevel() = NewLevel;
+    World.CancelVisibilityBake();
     ChangeLevel();
 }
 
 void SGame::ChangeLevel(const SAsset& LevelAsset)
 {
-    Serialization::MemoryStream LevelStream(LevelAsset.SignedCharPtr(), LevelAsset.Length);
-    World.GetLevel()->Deserialize(LevelStream);
+    Serialization::SpanReader LevelReader(LevelAsset.Data, LevelAsset.Length);
+    if (!World.GetLevel()->Deserialize(LevelReader))
+    {
+        Log::Game<ELogLevel::Critical>("%s(): Failed to load the level, keeping the current one", __func__);
+        return;
+    }
+    World.ResetVisibility();
     ChangeLevel();
 }
 
@@ -8,6 +8,7 @@
 #include "Platform.hxx"
 #include "GameSystem.hxx"
 #include "Player.hxx"
+#include "LevelStreamer.hxx"
 #include "World.hxx"
 
 #ifdef EQUINOX_REACH_DEVELOPMENT
@@ -33,6 +34,7 @@ public:
     SInputState OldInputState{}, BufferedInputState{}, InputState{};
     SCamera Camera;
     SWorld World;
+    CLevelStreamer LevelStreamer;
     SPlayer Player;
     SParty PlayerParty;
     SBlob Blob;
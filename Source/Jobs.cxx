@@ -0,0 +1,361 @@
+#include "Jobs.hxx"
+
+#include <chrono>
+#include <condition_variable>
+#include <thread>
+#include "Log.hxx"
+
+using Clock = std::chrono::steady_clock;
+
+/* Dependent jobs are kept as an intrusive list through their link slots, one per dependency. */
+static constexpr uint32_t NoLink = UINT32_MAX;
+
+struct SJob
+{
+    SJobFunction Function{};
+    const char* Name{};
+    /* Bumped once the job finished, handles from before then read as finished. */
+    std::atomic<uint32_t> Generation{};
+    /* Unfinished dependencies, plus one until Submit() returns. */
+    std::atomic<uint32_t> PendingCount{};
+    /* Guards FirstDependent and the links of jobs waiting on this one. */
+    std::mutex Mutex;
+    uint32_t FirstDependent = NoLink;
+    std::array<uint32_t, JobsMaxDependencies> Links{};
+};
+
+/* Ring buffer of job indices; never more entries than there are jobs. */
+struct SJobQueue
+{
+    std::mutex Mutex;
+    std::array<uint32_t, JobsMaxJobs> Items{};
+    std::size_t Head{};
+    std::size_t Tail{};
+};
+
+static std::array<SJob, JobsMaxJobs> Slots;
+static std::array<SJobQueue, JobsMaxWorkers + 1> Queues;
+
+static std::mutex FreeMutex;
+static std::array<uint32_t, JobsMaxJobs> FreeList;
+static std::size_t FreeCount{};
+
+static std::array<std::thread, JobsMaxWorkers> Workers;
+static std::size_t WorkerCount{};
+static std::atomic<std::size_t> QueuedCount{};
+static std::mutex SleepMutex;
+static std::condition_variable WorkAvailable;
+static bool bStopping{};
+
+static thread_local std::size_t ThreadIndex{};
+
+static std::mutex TimingMutex;
+static std::array<SJobTiming, JobsTimingHistory> Timings;
+static std::size_t TimingCount{};
+static std::atomic<std::size_t> FrameIndex{};
+static std::atomic<Clock::rep> FrameStart{};
+
+static void RecordTiming(const char* Name, Clock::time_point Start, Clock::time_point End)
+{
+    SJobTiming Timing{};
+    Timing.Name = Name;
+    Timing.Thread = ThreadIndex;
+    Timing.Frame = FrameIndex.load(std::memory_order_relaxed);
+    Timing.StartMilliseconds = std::chrono::duration<float, std::milli>(Start - Clock::time_point(Clock::duration(FrameStart.load(std::memory_order_relaxed)))).count();
+    Timing.Milliseconds = std::chrono::duration<float, std::milli>(End - Start).count();
+
+    std::lock_guard Lock{ TimingMutex };
+    Timings[TimingCount++ % JobsTimingHistory] = Timing;
+}
+
+static void Push(uint32_t Index)
+{
+    auto& Queue = Queues[ThreadIndex];
+    {
+        std::lock_guard Lock{ Queue.Mutex };
+        Queue.Items[Queue.Tail++ % JobsMaxJobs] = Index;
+    }
+    QueuedCount.fetch_add(1, std::memory_order_release);
+    {
+        /* Pairs with the check in the workers' wait, so the notification can't slip in between. */
+        std::lock_guard Lock{ SleepMutex };
+    }
+    WorkAvailable.notify_one();
+}
+
+static uint32_t Pop()
+{
+    auto& Own = Queues[ThreadIndex];
+    {
+        std::lock_guard Lock{ Own.Mutex };
+        if (Own.Head != Own.Tail)
+        {
+            return Own.Items[--Own.Tail % JobsMaxJobs];
+        }
+    }
+    for (std::size_t Offset = 1; Offset <= WorkerCount; ++Offset)
+    {
+        auto& Victim = Queues[(ThreadIndex + Offset) % (WorkerCount + 1)];
+        std::lock_guard Lock{ Victim.Mutex };
+        if (Victim.Head != Victim.Tail)
+        {
+            return Victim.Items[Victim.Head++ % JobsMaxJobs];
+        }
+    }
+    return NoLink;
+}
+
+static void Release(uint32_t Index)
+{
+    if (Slots[Index].PendingCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        Push(Index);
+    }
+}
+
+static void Finish(uint32_t Index)
+{
+    auto& Job = Slots[Index];
+    uint32_t Link;
+    {
+        std::lock_guard Lock{ Job.Mutex };
+        Job.Generation.fetch_add(1, std::memory_order_release);
+        Link = Job.FirstDependent;
+        Job.FirstDependent = NoLink;
+    }
+    while (Link != NoLink)
+    {
+        auto DependentIndex = Link / (uint32_t)JobsMaxDependencies;
+        /* Read before releasing, the dependent may run and be reused right after. */
+        auto Next = Slots[DependentIndex].Links[Link % JobsMaxDependencies];
+        Release(DependentIndex);
+        Link = Next;
+    }
+
+    std::lock_guard Lock{ FreeMutex };
+    FreeList[FreeCount++] = Index;
+}
+
+static bool TryRunOne()
+{
+    auto Index = Pop();
+    if (Index == NoLink)
+    {
+        return false;
+    }
+    QueuedCount.fetch_sub(1, std::memory_order_relaxed);
+
+    auto& Job = Slots[Index];
+    auto Start = Clock::now();
+    Job.Function();
+    RecordTiming(Job.Name, Start, Clock::now());
+    Finish(Index);
+    return true;
+}
+
+static void RunWorker(std::size_t Index)
+{
+    ThreadIndex = Index;
+    while (true)
+    {
+        if (TryRunOne())
+        {
+            continue;
+        }
+        std::unique_lock Lock{ SleepMutex };
+        WorkAvailable.wait(Lock, [] { return bStopping || QueuedCount.load(std::memory_order_acquire) > 0; });
+        if (bStopping)
+        {
+            return;
+        }
+    }
+}
+
+void Jobs::Init(std::size_t InWorkerCount)
+{
+    if (InWorkerCount == 0)
+    {
+        InWorkerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+    }
+    WorkerCount = std::min(InWorkerCount, JobsMaxWorkers);
+
+    FreeCount = JobsMaxJobs;
+    for (std::size_t Index = 0; Index < JobsMaxJobs; ++Index)
+    {
+        FreeList[Index] = (uint32_t)(JobsMaxJobs - 1 - Index);
+    }
+
+    bStopping = false;
+    NextFrame();
+    for (std::size_t Index = 0; Index < WorkerCount; ++Index)
+    {
+        Workers[Index] = std::thread(RunWorker, Index + 1);
+    }
+
+    Log::Jobs<ELogLevel::Info>("%s(): %zu workers", __func__, WorkerCount);
+}
+
+void Jobs::Cleanup()
+{
+    while (TryRunOne())
+    {
+    }
+    {
+        std::lock_guard Lock{ SleepMutex };
+        bStopping = true;
+    }
+    WorkAvailable.notify_all();
+    for (std::size_t Index = 0; Index < WorkerCount; ++Index)
+    {
+        Workers[Index].join();
+    }
+    WorkerCount = 0;
+}
+
+std::size_t Jobs::GetThreadCount()
+{
+    return WorkerCount + 1;
+}
+
+SJobHandle Jobs::Submit(const char* Name, const SJobFunction& Function, const SJobHandle* Dependencies, std::size_t DependencyCount)
+{
+    if (DependencyCount > JobsMaxDependencies)
+    {
+        Log::Jobs<ELogLevel::Critical>("%s(): %s has %zu dependencies, at most %zu are supported", __func__, Name, DependencyCount, JobsMaxDependencies);
+        abort();
+    }
+
+    uint32_t Index = NoLink;
+    while (Index == NoLink)
+    {
+        {
+            std::lock_guard Lock{ FreeMutex };
+            if (FreeCount > 0)
+            {
+                Index = FreeList[--FreeCount];
+                break;
+            }
+        }
+        /* Out of slots, make some room. */
+        if (!TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    auto& Job = Slots[Index];
+    Job.Function = Function;
+    Job.Name = Name;
+    Job.PendingCount.store(1, std::memory_order_relaxed);
+    SJobHandle Handle{ Index, Job.Generation.load(std::memory_order_relaxed) };
+
+    for (std::size_t Slot = 0; Slot < DependencyCount; ++Slot)
+    {
+        auto& Dependency = Dependencies[Slot];
+        if (!Dependency.IsValid())
+        {
+            continue;
+        }
+        auto& Other = Slots[Dependency.Index];
+        std::lock_guard Lock{ Other.Mutex };
+        if (Other.Generation.load(std::memory_order_relaxed) == Dependency.Generation)
+        {
+            Job.PendingCount.fetch_add(1, std::memory_order_relaxed);
+            Job.Links[Slot] = Other.FirstDependent;
+            Other.FirstDependent = Index * (uint32_t)JobsMaxDependencies + (uint32_t)Slot;
+        }
+    }
+
+    Release(Index);
+    return Handle;
+}
+
+bool Jobs::IsFinished(const SJobHandle& Handle)
+{
+    return !Handle.IsValid() || Slots[Handle.Index].Generation.load(std::memory_order_acquire) != Handle.Generation;
+}
+
+void Jobs::Wait(const SJobHandle& Handle)
+{
+    while (!IsFinished(Handle))
+    {
+        if (!TryRunOne())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void Jobs::Run(const char* Name, SJobFunction Function)
+{
+    auto Start = Clock::now();
+    Function();
+    RecordTiming(Name, Start, Clock::now());
+}
+
+void Jobs::NextFrame()
+{
+    FrameIndex.fetch_add(1, std::memory_order_relaxed);
+    FrameStart.store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+std::pmr::vector<SJobTiming> Jobs::GetRecentTimings()
+{
+    auto Recent = Memory::GetFrameVector<SJobTiming>();
+    std::lock_guard Lock{ TimingMutex };
+    auto Count = std::min(TimingCount, JobsTimingHistory);
+    for (auto Index = TimingCount - Count; Index < TimingCount; ++Index)
+    {
+        Recent.push_back(Timings[Index % JobsTimingHistory]);
+    }
+    return Recent;
+}
+
+std::size_t CFrameGraph::Add(const char* Name, const SJobFunction& Function, std::initializer_list<std::size_t> Dependencies, bool bMainThread)
+{
+    if (Dependencies.size() > JobsMaxDependencies)
+    {
+        Log::Jobs<ELogLevel::Critical>("%s(): %s has %zu dependencies, at most %zu are supported", __func__, Name, Dependencies.size(), JobsMaxDependencies);
+        abort();
+    }
+
+    auto& Node = Nodes.emplace_back();
+    Node.Name = Name;
+    Node.Function = Function;
+    std::copy(Dependencies.begin(), Dependencies.end(), Node.Dependencies.begin());
+    Node.DependencyCount = Dependencies.size();
+    Node.bMainThread = bMainThread;
+    return Nodes.size() - 1;
+}
+
+void CFrameGraph::Execute()
+{
+    /* Main thread nodes run as they come up, so by the time a node is submitted its main thread dependencies are done. */
+    for (auto& Node : Nodes)
+    {
+        std::array<SJobHandle, JobsMaxDependencies> Handles{};
+        for (std::size_t Slot = 0; Slot < Node.DependencyCount; ++Slot)
+        {
+            Handles[Slot] = Nodes[Node.Dependencies[Slot]].Handle;
+        }
+
+        if (Node.bMainThread)
+        {
+            for (std::size_t Slot = 0; Slot < Node.DependencyCount; ++Slot)
+            {
+                Jobs::Wait(Handles[Slot]);
+            }
+            Jobs::Run(Node.Name, Node.Function);
+            Node.Handle = {};
+        }
+        else
+        {
+            Node.Handle = Jobs::Submit(Node.Name, Node.Function, Handles.data(), Node.DependencyCount);
+        }
+    }
+
+    for (auto& Node : Nodes)
+    {
+        Jobs::Wait(Node.Handle);
+    }
+}
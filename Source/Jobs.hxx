@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <new>
+#include <type_traits>
+#include "Memory.hxx"
+
+inline constexpr std::size_t JobsMaxWorkers = 16;
+inline constexpr std::size_t JobsMaxJobs = 1024;
+inline constexpr std::size_t JobsMaxDependencies = 8;
+inline constexpr std::size_t JobsFunctionSize = 48;
+inline constexpr std::size_t JobsTimingHistory = 256;
+
+/* A callable stored in place. Captures have to be trivially copyable, so capture by reference or pointer. */
+struct SJobFunction
+{
+    alignas(std::max_align_t) std::byte Storage[JobsFunctionSize]{};
+    void (*Invoke)(void* Storage){};
+
+    SJobFunction() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, SJobFunction>>>
+    SJobFunction(F&& Func)
+    {
+        using TFunc = std::decay_t<F>;
+        static_assert(sizeof(TFunc) <= JobsFunctionSize, "Job captures too large.");
+        static_assert(alignof(TFunc) <= alignof(std::max_align_t));
+        static_assert(std::is_trivially_copyable_v<TFunc> && std::is_trivially_destructible_v<TFunc>);
+        new (Storage) TFunc(std::forward<F>(Func));
+        Invoke = [](void* InStorage) { (*std::launder(static_cast<TFunc*>(InStorage)))(); };
+    }
+
+    void operator()() { Invoke(Storage); }
+};
+
+/* Refers to a submitted job. Still safe to use after its slot was reused, it then reads as finished. */
+struct SJobHandle
+{
+    uint32_t Index = UINT32_MAX;
+    uint32_t Generation{};
+
+    [[nodiscard]] bool IsValid() const { return Index != UINT32_MAX; }
+};
+
+struct SJobTiming
+{
+    const char* Name{};
+    /* 0 is the main thread. */
+    std::size_t Thread{};
+    std::size_t Frame{};
+    /* Since the start of the frame. */
+    float StartMilliseconds{};
+    float Milliseconds{};
+};
+
+/* Work-stealing scheduler: every thread pushes and pops its own queue from the back, idle threads steal from the front of the others.
+ * Jobs never block on each other; a job with dependencies is queued by whichever thread finishes its last dependency.
+ * Threads waiting on a job run other jobs in the meantime. */
+namespace Jobs
+{
+    /* 0 workers picks one less than the hardware thread count. */
+    void Init(std::size_t WorkerCount = 0);
+
+    /* Runs whatever is still queued, then stops the workers. */
+    void Cleanup();
+
+    /* Worker threads plus the main thread. */
+    std::size_t GetThreadCount();
+
+    /* Queues Function once all Dependencies finished, invalid handles count as finished. */
+    SJobHandle Submit(const char* Name, const SJobFunction& Function, const SJobHandle* Dependencies = nullptr, std::size_t DependencyCount = 0);
+
+    inline SJobHandle Submit(const char* Name, const SJobFunction& Function, std::initializer_list<SJobHandle> Dependencies)
+    {
+        return Submit(Name, Function, Dependencies.begin(), Dependencies.size());
+    }
+
+    [[nodiscard]] bool IsFinished(const SJobHandle& Handle);
+
+    /* Runs other jobs until Handle finished. */
+    void Wait(const SJobHandle& Handle);
+
+    /* Runs Function on the calling thread, timed like a job. */
+    void Run(const char* Name, SJobFunction Function);
+
+    /* Calls Func(Begin, End) over [0, Count) in batches of Grain and returns once all of them ran. */
+    template <typename F>
+    void ParallelFor(const char* Name, std::size_t Count, std::size_t Grain, F&& Func)
+    {
+        Grain = std::max<std::size_t>(Grain, 1);
+        if (Count <= Grain || GetThreadCount() == 1)
+        {
+            Run(Name, [&] { Func(std::size_t{}, Count); });
+            return;
+        }
+
+        auto FuncPtr = &Func;
+        auto Handles = Memory::GetFrameVector<SJobHandle>();
+        for (std::size_t Begin = 0; Begin < Count; Begin += Grain)
+        {
+            auto End = std::min(Begin + Grain, Count);
+            Handles.push_back(Submit(Name, [FuncPtr, Begin, End] { (*FuncPtr)(Begin, End); }));
+        }
+        for (auto& Handle : Handles)
+        {
+            Wait(Handle);
+        }
+    }
+
+    /* Starts a new frame for job timings. */
+    void NextFrame();
+
+    /* The most recent job timings, oldest first. */
+    std::pmr::vector<SJobTiming> GetRecentTimings();
+}
+
+/* Work with dependencies between steps, built once and executed as a whole.
+ * Main thread nodes run on the thread calling Execute() in the order they were added, the others run as jobs as soon as their dependencies allow. */
+class CFrameGraph
+{
+public:
+    /* Dependencies are indices returned by earlier calls, at most JobsMaxDependencies of them. */
+    std::size_t Add(const char* Name, const SJobFunction& Function, std::initializer_list<std::size_t> Dependencies = {}, bool bMainThread = false);
+
+    /* Returns once every node ran. */
+    void Execute();
+
+    void Clear() { Nodes.clear(); }
+
+private:
+    struct SNode
+    {
+        const char* Name{};
+        SJobFunction Function{};
+        std::array<std::size_t, JobsMaxDependencies> Dependencies{};
+        std::size_t DependencyCount{};
+        bool bMainThread{};
+        SJobHandle Handle{};
+    };
+
+    std::pmr::vector<SNode> Nodes{ Memory::GetPoolResource() };
+};
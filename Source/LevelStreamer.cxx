@@ -0,0 +1,139 @@
+#include "LevelStreamer.hxx"
+
+#include <algorithm>
+#include <chrono>
+#include "Jobs.hxx"
+#include "Log.hxx"
+#include "Serialization.hxx"
+
+void CLevelStreamer::Cleanup()
+{
+    std::unique_lock Lock{ Mutex };
+    bStopping = true;
+    Queued.clear();
+    WorkFinished.wait(Lock, [&] { return PendingJobs == 0; });
+    Finished.clear();
+    Released.clear();
+}
+
+void CLevelStreamer::Request(std::size_t Index, const SAsset* Asset, bool bUrgent)
+{
+    {
+        std::lock_guard Lock{ Mutex };
+        if (bStopping)
+        {
+            return;
+        }
+        auto IsIndex = [&](const SJob& Job) { return Job.Index == Index; };
+        auto Existing = std::find_if(Queued.begin(), Queued.end(), IsIndex);
+        if (Existing != Queued.end())
+        {
+            if (bUrgent)
+            {
+                std::rotate(Queued.begin(), Existing, Existing + 1);
+            }
+            return;
+        }
+        if (std::find(Running.begin(), Running.end(), Index) != Running.end() || std::any_of(Finished.begin(), Finished.end(), IsIndex))
+        {
+            return;
+        }
+
+        SJob Job{};
+        Job.Index = Index;
+        Job.Asset = Asset;
+        Queued.insert(bUrgent ? Queued.begin() : Queued.end(), std::move(Job));
+        PendingJobs++;
+    }
+
+    Jobs::Submit("Load Level", [this] {
+        std::unique_lock Lock{ Mutex };
+        LoadNext(Lock);
+        PendingJobs--;
+        WorkFinished.notify_all();
+    });
+
+    Log::Game<ELogLevel::Debug>("%s(): Level %zu%s", __func__, Index, bUrgent ? ", urgent" : "");
+}
+
+void CLevelStreamer::Release(SWorldLevel&& Level)
+{
+    {
+        std::lock_guard Lock{ Mutex };
+        Released.push_back(std::move(Level));
+        PendingJobs++;
+    }
+
+    Jobs::Submit("Free Levels", [this] { FreeReleased(); });
+}
+
+void CLevelStreamer::Wait(std::size_t Index)
+{
+    std::unique_lock Lock{ Mutex };
+    while (IsQueuedOrRunning(Index))
+    {
+        auto Queue = std::find_if(Queued.begin(), Queued.end(), [&](const SJob& Job) { return Job.Index == Index; });
+        if (Queue != Queued.end())
+        {
+            /* Quicker to load it here than to wait for a job to get to it. */
+            std::rotate(Queued.begin(), Queue, Queue + 1);
+            LoadNext(Lock);
+        }
+        else
+        {
+            WorkFinished.wait(Lock);
+        }
+    }
+}
+
+bool CLevelStreamer::IsQueuedOrRunning(std::size_t Index) const
+{
+    return std::find(Running.begin(), Running.end(), Index) != Running.end() ||
+        std::any_of(Queued.begin(), Queued.end(), [&](const SJob& Job) { return Job.Index == Index; });
+}
+
+void CLevelStreamer::LoadNext(std::unique_lock<std::mutex>& Lock)
+{
+    if (Queued.empty())
+    {
+        return;
+    }
+
+    auto Job = std::move(Queued.front());
+    Queued.erase(Queued.begin());
+    Running.push_back(Job.Index);
+    Lock.unlock();
+
+    auto Start = std::chrono::steady_clock::now();
+    Serialization::SpanReader Reader(Job.Asset->Data, Job.Asset->Length);
+    Job.bLoaded = Job.Level.Deserialize(Reader);
+    auto Milliseconds = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - Start).count();
+
+    if (Job.bLoaded)
+    {
+        Log::Game<ELogLevel::Debug>("%s(): Level %zu loaded in %.2f ms", __func__, Job.Index, Milliseconds);
+    }
+    else
+    {
+        Log::Game<ELogLevel::Critical>("%s(): Level %zu failed to load", __func__, Job.Index);
+    }
+
+    Lock.lock();
+    Running.erase(std::find(Running.begin(), Running.end(), Job.Index));
+    Finished.push_back(std::move(Job));
+    WorkFinished.notify_all();
+}
+
+void CLevelStreamer::FreeReleased()
+{
+    auto Garbage = Memory::GetVector<SWorldLevel>();
+    {
+        std::lock_guard Lock{ Mutex };
+        std::swap(Garbage, Released);
+    }
+    Garbage.clear();
+
+    std::lock_guard Lock{ Mutex };
+    PendingJobs--;
+    WorkFinished.notify_all();
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <condition_variable>
+#include <mutex>
+#include "World.hxx"
+
+/* Deserializes and post-processes levels as jobs, and destroys evicted ones there too.
+ * Finished levels wait until Collect hands them out, so the world only changes at frame boundaries. */
+class CLevelStreamer
+{
+public:
+    /* Drops queued loads and waits for the running ones. Call before Jobs::Cleanup(). */
+    void Cleanup();
+
+    /* Queues a load for Index unless one is already queued, running or waiting to be collected. Urgent requests go to the front. */
+    void Request(std::size_t Index, const SAsset* Asset, bool bUrgent = false);
+
+    /* Hands Level over to be freed off the main thread. */
+    void Release(SWorldLevel&& Level);
+
+    /* Blocks until no load for Index is queued or running, loading it on the calling thread if it didn't start yet. */
+    void Wait(std::size_t Index);
+
+    /* Calls Func(Index, Level, bLoaded) for every finished load. */
+    template <typename F>
+    void Collect(F&& Func)
+    {
+        auto Ready = Memory::GetVector<SJob>();
+        {
+            std::lock_guard Lock{ Mutex };
+            std::swap(Ready, Finished);
+        }
+        for (auto& Job : Ready)
+        {
+            Func(Job.Index, Job.Level, Job.bLoaded);
+        }
+    }
+
+private:
+    struct SJob
+    {
+        std::size_t Index{};
+        const SAsset* Asset{};
+        SWorldLevel Level{};
+        bool bLoaded{};
+    };
+
+    std::mutex Mutex;
+    std::condition_variable WorkFinished;
+    /* Every job loads whichever level is first in line when it starts, there is at least one job per queued level. */
+    std::pmr::vector<SJob> Queued{ Memory::GetPoolResource() };
+    std::pmr::vector<SJob> Finished{ Memory::GetPoolResource() };
+    std::pmr::vector<SWorldLevel> Released{ Memory::GetPoolResource() };
+    std::pmr::vector<std::size_t> Running{ Memory::GetPoolResource() };
+    /* Submitted jobs that didn't return yet. */
+    std::size_t PendingJobs{};
+    bool bStopping{};
+
+    [[nodiscard]] bool IsQueuedOrRunning(std::size_t Index) const;
+
+    /* Loads the first queued level with Lock released meanwhile. */
+    void LoadNext(std::unique_lock<std::mutex>& Lock);
+
+    void FreeReleased();
+};
@@ -59,6 +59,7 @@ namespace Log
     LOG_CATEGORY(Platform)
     LOG_CATEGORY(Draw)
     LOG_CATEGORY(Game)
+    LOG_CATEGORY(Jobs)
 #ifdef EQUINOX_REACH_DEVELOPMENT
     LOG_CATEGORY(DevTools)
 #endif
@@ -4,7 +4,7 @@
 
 void EquinoxReach()
 {
-    auto Game = Memory::MakeShared<SGame>();
+    auto Game = Memory::MakeShared<SGame>(EMemoryTag::Game);
     Game->Run();
 }
 
@@ -409,6 +409,16 @@ struct TMat4x4
         Z = Current.X * Rotate.Z.X + Current.Y * Rotate.Z.Y + Current.Z * Rotate.Z.Z;
     }
 
+    constexpr TMat4x4<T> operator*(const TMat4x4<T>& Other) const
+    {
+        TMat4x4<T> Result;
+        Result.X = X * Other.X.X + Y * Other.X.Y + Z * Other.X.Z + W * Other.X.W;
+        Result.Y = X * Other.Y.X + Y * Other.Y.Y + Z * Other.Y.Z + W * Other.Y.W;
+        Result.Z = X * Other.Z.X + Y * Other.Z.Y + Z * Other.Z.Z + W * Other.Z.W;
+        Result.W = X * Other.W.X + Y * Other.W.Y + Z * Other.W.Z + W * Other.W.W;
+        return Result;
+    }
+
     static inline constexpr TMat4x4<T> One()
     {
         return { { T(1), T(1), T(1), T(1) },
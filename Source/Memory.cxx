@@ -1,12 +1,28 @@
 #include "Memory.hxx"
 
+#include <algorithm>
+#include <thread>
 #include "Log.hxx"
 #include "Utility.hxx"
 
+static thread_local EMemoryTag ScopedTag = EMemoryTag::Untagged;
+
 CInlineResource::CInlineResource(std::pmr::memory_resource* up)
     : Upstream(up)
 {
     Log::Memory<ELogLevel::Critical>("Creating inline resource, total size: %zu bytes, data(): %p", HeapSize, Buffer.data());
+
+    /* One free block spanning the whole buffer, followed by a zero-sized used block
+     * so that every free block always has a valid physical neighbor. */
+    auto FirstBlock = reinterpret_cast<SAllocationHeader*>(Buffer.data());
+    FirstBlock->PreviousPhysicalBlock = nullptr;
+    FirstBlock->Size = HeapSize - HeaderSize;
+
+    Sentinel = NextPhysicalBlock(FirstBlock);
+    Sentinel->PreviousPhysicalBlock = FirstBlock;
+    Sentinel->Size = 0;
+
+    FreeBlock(FirstBlock);
 }
 
 CInlineResource::~CInlineResource()
@@ -14,279 +30,675 @@ CInlineResource::~CInlineResource()
     Log::Memory<ELogLevel::Critical>("Destroying inline resource, NumberOfBlocks: %zu", NumberOfBlocks());
 }
 
-void CInlineResource::DestroyBlock(SAllocationHeader* AllocationHeader)
+void CInlineResource::MappingInsert(std::size_t Size, std::size_t& FL, std::size_t& SL)
 {
-    if (AllocationHeader->PreviousBlock == nullptr)
+    if (Size < SmallBlockSize)
     {
-        FirstAllocation = AllocationHeader->NextBlock;
+        FL = 0;
+        SL = Size / (SmallBlockSize / SLIndexCount);
     }
     else
     {
-        AllocationHeader->PreviousBlock->NextBlock = AllocationHeader->NextBlock;
+        auto MostSignificantBit = (std::size_t)(63 - __builtin_clzll(Size));
+        SL = (Size >> (MostSignificantBit - SLIndexCountLog2)) ^ SLIndexCount;
+        FL = MostSignificantBit - (FLIndexShift - 1);
     }
-    if (AllocationHeader->NextBlock != nullptr)
+}
+
+void CInlineResource::MappingSearch(std::size_t Size, std::size_t& FL, std::size_t& SL)
+{
+    /* Round up to the next list so that any block found there is large enough. */
+    if (Size >= SmallBlockSize)
     {
-        AllocationHeader->NextBlock->PreviousBlock = AllocationHeader->PreviousBlock;
+        auto MostSignificantBit = (std::size_t)(63 - __builtin_clzll(Size));
+        Size += (std::size_t(1) << (MostSignificantBit - SLIndexCountLog2)) - 1;
     }
+    MappingInsert(Size, FL, SL);
 }
 
-size_t CInlineResource::NumberOfBlocks()
+void CInlineResource::InsertFreeBlock(SAllocationHeader* Block)
 {
-    std::unique_lock Lock{ Mutex };
+    std::size_t FL, SL;
+    MappingInsert(GetBlockSize(Block), FL, SL);
 
-    if (FirstAllocation == nullptr)
+    auto& Head = FreeBlocks[FL][SL];
+    Block->PreviousFreeBlock = nullptr;
+    Block->NextFreeBlock = Head;
+    if (Head != nullptr)
     {
-        return 0;
+        Head->PreviousFreeBlock = Block;
     }
+    Head = Block;
 
-    size_t Num = 0;
+    FLBitmap |= 1u << FL;
+    SLBitmap[FL] |= 1u << SL;
 
-    SAllocationHeader* AllocationHeader = FirstAllocation;
-    while (AllocationHeader != nullptr)
+    Stats.FreeBytes += GetBlockSize(Block);
+}
+
+void CInlineResource::RemoveFreeBlock(SAllocationHeader* Block)
+{
+    std::size_t FL, SL;
+    MappingInsert(GetBlockSize(Block), FL, SL);
+
+    Stats.FreeBytes -= GetBlockSize(Block);
+
+    if (Block->PreviousFreeBlock != nullptr)
     {
-        Num++;
-        AllocationHeader = AllocationHeader->NextBlock;
+        Block->PreviousFreeBlock->NextFreeBlock = Block->NextFreeBlock;
+    }
+    if (Block->NextFreeBlock != nullptr)
+    {
+        Block->NextFreeBlock->PreviousFreeBlock = Block->PreviousFreeBlock;
     }
 
-    return Num;
+    auto& Head = FreeBlocks[FL][SL];
+    if (Head == Block)
+    {
+        Head = Block->NextFreeBlock;
+        if (Head == nullptr)
+        {
+            SLBitmap[FL] &= ~(1u << SL);
+            if (SLBitmap[FL] == 0)
+            {
+                FLBitmap &= ~(1u << FL);
+            }
+        }
+    }
 }
 
-void* CInlineResource::do_allocate(size_t bytes, size_t alignment)
+CInlineResource::SAllocationHeader* CInlineResource::TakeFreeBlock(std::size_t Size)
 {
-    std::unique_lock Lock{ Mutex };
-    return AllocateInline(nullptr, bytes, alignment);
+    std::size_t FL, SL;
+    MappingSearch(Size, FL, SL);
+    if (FL >= FLIndexCount)
+    {
+        return nullptr;
+    }
+
+    /* Look for a non-empty list in the same first level, then in any larger one. */
+    uint32_t SLMap = SLBitmap[FL] & (~0u << SL);
+    if (SLMap == 0)
+    {
+        uint32_t FLMap = FLBitmap & (~0u << (FL + 1));
+        if (FLMap == 0)
+        {
+            return nullptr;
+        }
+        FL = __builtin_ctz(FLMap);
+        SLMap = SLBitmap[FL];
+    }
+    SL = __builtin_ctz(SLMap);
+
+    auto Block = FreeBlocks[FL][SL];
+    RemoveFreeBlock(Block);
+    return Block;
 }
 
-void CInlineResource::do_deallocate(void* ptr, [[maybe_unused]] size_t bytes, [[maybe_unused]] size_t alignment)
+CInlineResource::SAllocationHeader* CInlineResource::AlignBlock(SAllocationHeader* Block, std::size_t Alignment)
 {
-    std::unique_lock Lock{ Mutex };
-    AllocateInline(ptr, 0);
+    auto Data = BlockToData(Block);
+    auto AlignedData = static_cast<std::byte*>(AlignPtr(Data, Alignment));
+    auto Gap = (std::size_t)(AlignedData - Data);
+
+    /* Leading gap has to be large enough to become a free block on its own. */
+    if (Gap != 0 && Gap < MinBlockSize)
+    {
+        AlignedData = static_cast<std::byte*>(AlignPtr(Data + MinBlockSize, Alignment));
+        Gap = (std::size_t)(AlignedData - Data);
+    }
+
+    if (Gap == 0)
+    {
+        return Block;
+    }
+
+    auto AlignedBlock = DataToBlock(AlignedData);
+    AlignedBlock->PreviousPhysicalBlock = Block;
+    AlignedBlock->Size = GetBlockSize(Block) - Gap;
+    NextPhysicalBlock(AlignedBlock)->PreviousPhysicalBlock = AlignedBlock;
+
+    Block->Size = Gap;
+    FreeBlock(Block);
+
+    return AlignedBlock;
 }
 
-void* CInlineResource::do_reallocate(void* ptr, size_t bytes)
+void CInlineResource::TrimBlock(SAllocationHeader* Block, std::size_t Size)
 {
-    std::unique_lock Lock{ Mutex };
-    return AllocateInline(ptr, bytes);
+    if (GetBlockSize(Block) < Size + MinBlockSize)
+    {
+        return;
+    }
+
+    auto Remainder = reinterpret_cast<SAllocationHeader*>(reinterpret_cast<std::byte*>(Block) + Size);
+    Remainder->PreviousPhysicalBlock = Block;
+    Remainder->Size = GetBlockSize(Block) - Size;
+    NextPhysicalBlock(Remainder)->PreviousPhysicalBlock = Remainder;
+
+    Block->Size = Size | (Block->Size & FlagMask);
+    FreeBlock(Remainder);
+}
+
+void CInlineResource::AbsorbNextBlock(SAllocationHeader* Block)
+{
+    auto NextBlock = NextPhysicalBlock(Block);
+    Block->Size += GetBlockSize(NextBlock);
+    NextPhysicalBlock(Block)->PreviousPhysicalBlock = Block;
 }
 
-void* CInlineResource::AllocateInline(void* SrcPtr, size_t Bytes, const size_t Alignment)
+void CInlineResource::FreeBlock(SAllocationHeader* Block)
 {
-    std::size_t BytesWithHeader = Bytes + sizeof(SAllocationHeader);
-    std::size_t FinalAllocationSize = BytesWithHeader + (Alignment - 1);
-    std::size_t ReallocBytes{};
-    if (SrcPtr != nullptr)
+    Block->Size |= FreeBit;
+
+    auto PreviousBlock = Block->PreviousPhysicalBlock;
+    if (PreviousBlock != nullptr && IsFreeBlock(PreviousBlock))
     {
-        auto BytePtr = static_cast<std::byte*>(SrcPtr);
-        auto AllocationHeader = reinterpret_cast<SAllocationHeader*>(BytePtr) - 1;
+        RemoveFreeBlock(PreviousBlock);
+        AbsorbNextBlock(PreviousBlock);
+        Block = PreviousBlock;
+    }
 
-        /* Freeing. */
-        if (Bytes == 0)
-        {
-            /* Check if the pointer is within our range. */
-            if (BytePtr < Buffer.data() || BytePtr >= Buffer.data() + Buffer.size())
-            {
-                Log::Memory<ELogLevel::Verbose>("Freeing from upstream at %p", BytePtr);
-                Upstream->deallocate(SrcPtr, Bytes, Alignment);
-                return nullptr;
-            }
+    auto NextBlock = NextPhysicalBlock(Block);
+    if (IsFreeBlock(NextBlock))
+    {
+        RemoveFreeBlock(NextBlock);
+        AbsorbNextBlock(Block);
+    }
 
-            DestroyBlock(AllocationHeader);
+    InsertFreeBlock(Block);
+}
 
-            Log::Memory<ELogLevel::Verbose>("Freeing %zu bytes at %p", AllocationHeader->Length, BytePtr);
+void* CInlineResource::Allocate(std::size_t Bytes, std::size_t Alignment, EMemoryTag Tag, std::size_t Headroom)
+{
+    Alignment = std::max(Alignment, AlignSize);
 
-            return nullptr;
-        }
+    auto BlockSize = AdjustBlockSize(Bytes);
+    auto SearchSize = Alignment > AlignSize ? BlockSize + Alignment + MinBlockSize : BlockSize;
 
-        /* Reallocating. */
-        if (AllocationHeader->NextBlock != nullptr)
-        {
-            if (BytePtr + BytesWithHeader >= reinterpret_cast<std::byte*>(AllocationHeader->NextBlock) || !IsAlignedPtr(SrcPtr, Alignment))
-            {
-                Log::Memory<ELogLevel::Verbose>("Pending reallocation of %zu bytes into %zu at %p", AllocationHeader->Length, Bytes, BytePtr);
-                /* Can't go beyond NextBlock! */
-                ReallocBytes = std::min(AllocationHeader->Length, Bytes);
-                DestroyBlock(AllocationHeader);
-            }
-            else
-            {
-                Log::Memory<ELogLevel::Verbose>("Reallocating %zu bytes at %p", Bytes, BytePtr);
-                AllocationHeader->Length = Bytes;
-                return SrcPtr;
-            }
-        }
-        else
-        {
-            if (BytePtr + BytesWithHeader >= Buffer.data() + Buffer.size() || !IsAlignedPtr(SrcPtr, Alignment))
-            {
-                Log::Memory<ELogLevel::Verbose>("Pending reallocation of %zu bytes into %zu at %p", AllocationHeader->Length, Bytes, BytePtr);
-                /* Can't go beyond end of the buffer! */
-                ReallocBytes = std::min(AllocationHeader->Length, Bytes);
-                DestroyBlock(AllocationHeader);
-            }
-            else
-            {
-                Log::Memory<ELogLevel::Verbose>("Reallocating %zu bytes at %p", Bytes, BytePtr);
-                AllocationHeader->Length = Bytes;
-                return SrcPtr;
-            }
-        }
+    Stats.Allocations++;
+    Stats.Tags[(std::size_t)Tag].Allocations++;
+
+    /* Headroom stays with the block as spare capacity for later reallocations. */
+    auto Block = Headroom > 0 ? TakeFreeBlock(SearchSize + Headroom) : nullptr;
+    if (Block == nullptr)
+    {
+        Block = TakeFreeBlock(SearchSize);
     }
-    else if (Bytes == 0)
+    if (Block == nullptr)
     {
-        return nullptr;
+        return AllocateUpstream(Bytes, Alignment);
+    }
+
+    Block->Size &= ~FreeBit;
+    if (Alignment > AlignSize)
+    {
+        Block = AlignBlock(Block, Alignment);
     }
+    TrimBlock(Block, BlockSize + Headroom);
+
+    Block->Size = (Block->Size & ~TagMask) | ((std::size_t)Tag << TagShift);
+    UpdateBlockStats(Block, 1, (std::ptrdiff_t)GetBlockSize(Block));
+
+    auto NewPtr = BlockToData(Block);
+
+    Log::Memory<ELogLevel::Verbose>("Allocating %zu bytes at %p", Bytes, NewPtr);
 
-    std::byte* NewPtr{};
-    SAllocationHeader* NewPreviousBlock = nullptr;
-    SAllocationHeader* NewNextBlock = nullptr;
+    return NewPtr;
+}
+
+void* CInlineResource::AllocateUpstream(std::size_t Bytes, std::size_t Alignment)
+{
+    /* Alignment is at least HeaderSize, so the header always fits in front of the data. */
+    auto Length = Bytes + Alignment;
+    auto Base = static_cast<std::byte*>(Upstream->allocate(Length, Alignment));
+    auto NewPtr = Base + Alignment;
+
+    auto Header = reinterpret_cast<SUpstreamHeader*>(NewPtr) - 1;
+    Header->Base = Base;
+    Header->Length = Length;
+
+    Stats.UpstreamFallbacks++;
+    Stats.UpstreamBytesLive += Length;
+
+    Log::Memory<ELogLevel::Verbose>("Allocating %zu bytes from upstream at %p", Bytes, NewPtr);
+
+    return NewPtr;
+}
 
-    if (FinalAllocationSize > Buffer.size())
+void CInlineResource::Deallocate(void* Ptr)
+{
+    if (!IsInlinePtr(Ptr))
     {
-        NewPtr = static_cast<std::byte*>(Upstream->allocate(Bytes, Alignment));
+        auto Header = static_cast<SUpstreamHeader*>(Ptr) - 1;
+        auto Alignment = (std::size_t)(static_cast<std::byte*>(Ptr) - static_cast<std::byte*>(Header->Base));
 
-        Log::Memory<ELogLevel::Verbose>("Allocating %zu bytes from upstream at %p", Bytes, NewPtr);
+        Log::Memory<ELogLevel::Verbose>("Freeing from upstream at %p", Ptr);
 
-        if (ReallocBytes != 0)
-        {
-            Log::Memory<ELogLevel::Verbose>("Copying %zu bytes to %p", std::min(ReallocBytes, Bytes), NewPtr);
-            std::memcpy(NewPtr, SrcPtr, std::min(ReallocBytes, Bytes));
-        }
+        Stats.UpstreamBytesLive -= Header->Length;
 
-        return NewPtr;
+        Upstream->deallocate(Header->Base, Header->Length, Alignment);
+        return;
     }
-    else
+
+    auto Block = DataToBlock(Ptr);
+
+    Log::Memory<ELogLevel::Verbose>("Freeing %zu bytes at %p", GetBlockSize(Block) - HeaderSize, Ptr);
+
+    UpdateBlockStats(Block, -1, -(std::ptrdiff_t)GetBlockSize(Block));
+    FreeBlock(Block);
+}
+
+void* CInlineResource::GrowBackwards(SAllocationHeader* Block, std::size_t BlockSize, std::size_t ReservedSize, std::size_t Alignment)
+{
+    auto PreviousBlock = Block->PreviousPhysicalBlock;
+    if (PreviousBlock == nullptr || !IsFreeBlock(PreviousBlock) || !IsAlignedPtr(BlockToData(PreviousBlock), Alignment))
     {
-        if (FirstAllocation == nullptr)
-        {
-            NewPtr = Buffer.data();
-        }
-        else
+        return nullptr;
+    }
+
+    auto NextBlock = NextPhysicalBlock(Block);
+    auto NextBlockSize = IsFreeBlock(NextBlock) ? GetBlockSize(NextBlock) : 0;
+    if (GetBlockSize(PreviousBlock) + GetBlockSize(Block) + NextBlockSize < BlockSize)
+    {
+        return nullptr;
+    }
+
+    auto OldBlockSize = GetBlockSize(Block);
+    if (NextBlockSize > 0)
+    {
+        RemoveFreeBlock(NextBlock);
+        AbsorbNextBlock(Block);
+    }
+
+    RemoveFreeBlock(PreviousBlock);
+    PreviousBlock->Size = GetBlockSize(PreviousBlock) | (Block->Size & TagMask);
+    AbsorbNextBlock(PreviousBlock);
+
+    /* Ranges overlap whenever the previous block is smaller than the data. */
+    auto NewPtr = BlockToData(PreviousBlock);
+    std::memmove(NewPtr, BlockToData(Block), OldBlockSize - HeaderSize);
+    Stats.ReallocBytesCopied += OldBlockSize - HeaderSize;
+
+    TrimBlock(PreviousBlock, ReservedSize);
+    UpdateBlockStats(PreviousBlock, 0, (std::ptrdiff_t)GetBlockSize(PreviousBlock) - (std::ptrdiff_t)OldBlockSize);
+
+    return NewPtr;
+}
+
+void* CInlineResource::Reallocate(void* Ptr, std::size_t Bytes, std::size_t Alignment, EMemoryTag Tag)
+{
+    std::size_t OldBytes;
+
+    Stats.Reallocations++;
+
+    /* Buffers that grow once usually keep growing, so growth reserves half as much again. */
+    auto BlockSize = AdjustBlockSize(Bytes);
+    auto ReservedSize = DoAlign(BlockSize + BlockSize / 2, AlignSize);
+
+    if (IsInlinePtr(Ptr))
+    {
+        auto Block = DataToBlock(Ptr);
+        auto OldBlockSize = GetBlockSize(Block);
+        OldBytes = OldBlockSize - HeaderSize;
+        Tag = GetBlockTag(Block);
+
+        if (IsAlignedPtr(Ptr, Alignment))
         {
-            if (reinterpret_cast<std::byte*>(FirstAllocation) > Buffer.data() && reinterpret_cast<std::byte*>(FirstAllocation) - Buffer.data() >= (int)BytesWithHeader)
+            if (OldBlockSize >= BlockSize)
             {
-                NewPtr = Buffer.data();
-                NewNextBlock = FirstAllocation;
-                FirstAllocation = nullptr;
+                /* Keep spare capacity unless most of the block would go unused. */
+                if (OldBlockSize >= BlockSize * 2)
+                {
+                    TrimBlock(Block, BlockSize);
+                    UpdateBlockStats(Block, 0, (std::ptrdiff_t)GetBlockSize(Block) - (std::ptrdiff_t)OldBlockSize);
+                }
+
+                Log::Memory<ELogLevel::Verbose>("Reallocating %zu bytes at %p", Bytes, Ptr);
+
+                Stats.ReallocationsInPlace++;
+                return Ptr;
             }
-            else
+
+            /* Grow into the next block if it's free and large enough. */
+            auto NextBlock = NextPhysicalBlock(Block);
+            if (IsFreeBlock(NextBlock) && OldBlockSize + GetBlockSize(NextBlock) >= BlockSize)
             {
-                SAllocationHeader* AllocationHeader = FirstAllocation;
-                while (AllocationHeader != nullptr)
+                Log::Memory<ELogLevel::Verbose>("Reallocating %zu bytes at %p", Bytes, Ptr);
+
+                RemoveFreeBlock(NextBlock);
+                AbsorbNextBlock(Block);
+                TrimBlock(Block, ReservedSize);
+                UpdateBlockStats(Block, 0, (std::ptrdiff_t)GetBlockSize(Block) - (std::ptrdiff_t)OldBlockSize);
+
+                Stats.ReallocationsInPlace++;
+                return Ptr;
+            }
+
+            /* Otherwise slide down into the previous block if it's free. */
+            if (Bytes < LargeBlockSize)
+            {
+                if (auto NewPtr = GrowBackwards(Block, BlockSize, ReservedSize, Alignment))
                 {
-                    auto DataAfterHeader = reinterpret_cast<std::byte*>(AllocationHeader) + AllocationHeader->Length + sizeof(SAllocationHeader);
-
-                    /* See if there is free space after the header. */
-                    if (AllocationHeader->NextBlock != nullptr)
-                    {
-                        auto NextBlockData = reinterpret_cast<std::byte*>(AllocationHeader->NextBlock);
-                        if (DataAfterHeader + FinalAllocationSize < NextBlockData)
-                        {
-                            /* We can fit an allocation between two. */
-                            NewPtr = DataAfterHeader;
-                            NewPreviousBlock = AllocationHeader;
-                            NewNextBlock = AllocationHeader->NextBlock;
-                            break;
-                        }
-                        else
-                        {
-                            AllocationHeader = AllocationHeader->NextBlock;
-                            continue;
-                        }
-                    }
-                    else
-                    {
-                        /* No next block; just check if it fits. */
-                        if (DataAfterHeader + FinalAllocationSize >= Buffer.data() + Buffer.size())
-                        {
-                            NewPtr = static_cast<std::byte*>(Upstream->allocate(Bytes, Alignment));
-
-                            Log::Memory<ELogLevel::Verbose>("Allocating %zu bytes from upstream at %p", Bytes, NewPtr);
-
-                            if (ReallocBytes != 0)
-                            {
-                                Log::Memory<ELogLevel::Verbose>("Copying %zu bytes to %p", std::min(ReallocBytes, Bytes), NewPtr);
-                                std::memcpy(NewPtr, SrcPtr, std::min(ReallocBytes, Bytes));
-                            }
-
-                            return NewPtr;
-                        }
-                        else
-                        {
-                            NewPtr = DataAfterHeader;
-                            NewPreviousBlock = AllocationHeader;
-                            NewNextBlock = AllocationHeader->NextBlock;
-                            break;
-                        }
-                    }
+                    Log::Memory<ELogLevel::Verbose>("Reallocating %zu bytes backwards from %p to %p", Bytes, Ptr, NewPtr);
+                    return NewPtr;
                 }
             }
         }
     }
+    else
+    {
+        auto Header = static_cast<SUpstreamHeader*>(Ptr) - 1;
+        OldBytes = Header->Length - (std::size_t)(static_cast<std::byte*>(Ptr) - static_cast<std::byte*>(Header->Base));
 
-    if (NewPtr == nullptr)
+        if (OldBytes >= Bytes && OldBytes < Bytes * 2 && IsAlignedPtr(Ptr, Alignment))
+        {
+            Log::Memory<ELogLevel::Verbose>("Reallocating %zu bytes at %p in upstream", Bytes, Ptr);
+
+            Stats.ReallocationsInPlace++;
+            return Ptr;
+        }
+    }
+
+    Log::Memory<ELogLevel::Verbose>("Pending reallocation of %zu bytes into %zu at %p", OldBytes, Bytes, Ptr);
+
+    void* NewPtr;
+    if (Bytes <= OldBytes)
+    {
+        NewPtr = Allocate(Bytes, Alignment, Tag);
+    }
+    else if (Bytes >= LargeBlockSize)
     {
-        Log::Memory<ELogLevel::Verbose>("Failed to allocate %zu bytes", Bytes);
-        exit(1);
+        Stats.Allocations++;
+        Stats.Tags[(std::size_t)Tag].Allocations++;
+        NewPtr = AllocateUpstream(ReservedSize - HeaderSize, std::max(Alignment, AlignSize));
     }
     else
     {
-        /* Shift pointer to point to allocated data. */
-        NewPtr = static_cast<std::byte*>(AlignPtr(NewPtr + sizeof(SAllocationHeader), Alignment));
-#ifdef EQUINOX_REACH_DEVELOPMENT
-        if (ReallocBytes == 0)
-        {
-            Log::Memory<ELogLevel::Verbose>("Allocating %zu bytes at %p", Bytes, NewPtr);
-        }
-#endif
+        NewPtr = Allocate(Bytes, Alignment, Tag, ReservedSize - BlockSize);
     }
 
-    auto NewAllocationHeader = reinterpret_cast<SAllocationHeader*>(NewPtr) - 1;
-    NewAllocationHeader->Length = Bytes;
-    NewAllocationHeader->NextBlock = NewNextBlock;
-    NewAllocationHeader->PreviousBlock = NewPreviousBlock;
+    Log::Memory<ELogLevel::Verbose>("Copying %zu bytes to %p", std::min(OldBytes, Bytes), NewPtr);
+    std::memcpy(NewPtr, Ptr, std::min(OldBytes, Bytes));
+    Stats.ReallocBytesCopied += std::min(OldBytes, Bytes);
+
+    Deallocate(Ptr);
+
+    return NewPtr;
+}
 
-    if (FirstAllocation == nullptr)
+void CInlineResource::UpdateBlockStats(const SAllocationHeader* Block, std::ptrdiff_t BlockCount, std::ptrdiff_t BlockSize)
+{
+    auto& TagStats = Stats.Tags[(std::size_t)GetBlockTag(Block)];
+    TagStats.BlocksLive += BlockCount;
+    TagStats.BytesLive += BlockSize;
+    Stats.BlocksLive += BlockCount;
+
+    if (BlockSize > 0)
     {
-        FirstAllocation = NewAllocationHeader;
+        Stats.PeakBytesLive = std::max(Stats.PeakBytesLive, GetBytesLive());
     }
+}
 
-    if (NewNextBlock != nullptr)
+std::size_t CInlineResource::FindLargestFreeBlock() const
+{
+    if (FLBitmap == 0)
     {
-        NewNextBlock->PreviousBlock = NewAllocationHeader;
+        return 0;
     }
 
-    if (NewPreviousBlock != nullptr)
+    /* Only the highest non-empty list can hold the largest block. */
+    auto FL = (std::size_t)(31 - __builtin_clz(FLBitmap));
+    auto SL = (std::size_t)(31 - __builtin_clz(SLBitmap[FL]));
+
+    std::size_t Largest = 0;
+    for (auto Block = FreeBlocks[FL][SL]; Block != nullptr; Block = Block->NextFreeBlock)
     {
-        NewPreviousBlock->NextBlock = NewAllocationHeader;
+        Largest = std::max(Largest, GetBlockSize(Block));
     }
+    return Largest;
+}
+
+size_t CInlineResource::NumberOfBlocks()
+{
+    std::unique_lock Lock{ Mutex };
+    return Stats.BlocksLive;
+}
+
+SInlineResourceStats CInlineResource::GetStats()
+{
+    std::unique_lock Lock{ Mutex };
+    Stats.BytesLive = GetBytesLive();
+    Stats.LargestFreeBlock = FindLargestFreeBlock();
+    return Stats;
+}
+
+void* CInlineResource::do_allocate(size_t bytes, size_t alignment)
+{
+    std::unique_lock Lock{ Mutex };
+    return AllocateInline(nullptr, bytes, alignment, ScopedTag);
+}
+
+void CInlineResource::do_deallocate(void* ptr, [[maybe_unused]] size_t bytes, [[maybe_unused]] size_t alignment)
+{
+    std::unique_lock Lock{ Mutex };
+    AllocateInline(ptr, 0);
+}
+
+void* CInlineResource::do_reallocate(void* ptr, size_t bytes)
+{
+    std::unique_lock Lock{ Mutex };
+    return AllocateInline(ptr, bytes, alignof(std::max_align_t), ScopedTag);
+}
 
-    if (ReallocBytes != 0)
+void* CInlineResource::AllocateInline(void* SrcPtr, size_t Bytes, const size_t Alignment, EMemoryTag Tag)
+{
+    if (SrcPtr == nullptr)
     {
-        Log::Memory<ELogLevel::Verbose>("Copying %zu bytes to %p", std::min(ReallocBytes, Bytes), NewPtr);
-        std::memcpy(NewPtr, SrcPtr, std::min(ReallocBytes, Bytes));
+        if (Bytes == 0)
+        {
+            return nullptr;
+        }
+        return Allocate(Bytes, Alignment, Tag);
     }
 
-    return NewPtr;
+    /* Freeing. */
+    if (Bytes == 0)
+    {
+        Deallocate(SrcPtr);
+        return nullptr;
+    }
+
+    /* Reallocating. */
+    return Reallocate(SrcPtr, Bytes, Alignment, Tag);
 }
 
 void* CTopmostResource::do_allocate(size_t Bytes, size_t Align)
 {
     Log::Memory<ELogLevel::Critical>("Allocating %d bytes through topmost resource", Bytes);
+
+    Allocations++;
+    auto NewBytesLive = BytesLive += Bytes;
+    auto Peak = PeakBytesLive.load();
+    while (Peak < NewBytesLive && !PeakBytesLive.compare_exchange_weak(Peak, NewBytesLive))
+    {
+    }
+
     return ::operator new(Bytes, std::align_val_t(Align));
 }
 
-void CTopmostResource::do_deallocate(void* Pointer, [[maybe_unused]] size_t Bytes, size_t Align) noexcept
+void CTopmostResource::do_deallocate(void* Pointer, size_t Bytes, size_t Align) noexcept
 
 {
     Log::Memory<ELogLevel::Critical>("Freeing %p through topmost resource", Pointer);
+
+    BytesLive -= Bytes;
+
     ::operator delete(Pointer, std::align_val_t(Align));
 }
 
+STopmostResourceStats CTopmostResource::GetStats() const
+{
+    return { BytesLive.load(), PeakBytesLive.load(), Allocations.load() };
+}
+
+/* Set once the thread cache is gone, so late frees during thread exit go straight to the pool. */
+static thread_local bool bThreadCacheDestroyed = false;
+
+CThreadCachedResource::SThreadCache::~SThreadCache()
+{
+    bThreadCacheDestroyed = true;
+    if (Owner == nullptr)
+    {
+        return;
+    }
+    for (std::size_t ClassIndex = 0; ClassIndex < ClassCount; ++ClassIndex)
+    {
+        auto& Magazine = Magazines[ClassIndex];
+        Owner->Flush(Magazine, ClassIndex, Magazine.Count);
+    }
+}
+
+CThreadCachedResource::CThreadCachedResource(std::pmr::memory_resource* up)
+    : Pool(up)
+{
+}
+
+std::size_t CThreadCachedResource::GetClassIndex(std::size_t Bytes)
+{
+    if (Bytes <= MinClassSize)
+    {
+        return 0;
+    }
+    return (sizeof(unsigned long long) * 8 - __builtin_clzll(Bytes - 1)) - MinClassSizeLog2;
+}
+
+CThreadCachedResource::SThreadCache* CThreadCachedResource::GetThreadCache()
+{
+    if (bThreadCacheDestroyed)
+    {
+        return nullptr;
+    }
+    thread_local SThreadCache ThreadCache;
+    if (ThreadCache.Owner == nullptr)
+    {
+        ThreadCache.Owner = this;
+    }
+    return ThreadCache.Owner == this ? &ThreadCache : nullptr;
+}
+
+void CThreadCachedResource::Refill(SMagazine& Magazine, std::size_t ClassIndex)
+{
+    std::lock_guard Lock(Mutex);
+    while (Magazine.Count < BatchSize)
+    {
+        Magazine.Blocks[Magazine.Count++] = Pool.allocate(GetClassSize(ClassIndex), MinClassSize);
+    }
+}
+
+void CThreadCachedResource::Flush(SMagazine& Magazine, std::size_t ClassIndex, std::size_t Count)
+{
+    std::lock_guard Lock(Mutex);
+    while (Count-- > 0)
+    {
+        Pool.deallocate(Magazine.Blocks[--Magazine.Count], GetClassSize(ClassIndex), MinClassSize);
+    }
+}
+
+void* CThreadCachedResource::do_allocate(size_t Bytes, size_t Alignment)
+{
+    if (IsCachedSize(Bytes, Alignment))
+    {
+        auto ClassIndex = GetClassIndex(Bytes);
+        if (auto ThreadCache = GetThreadCache())
+        {
+            auto& Magazine = ThreadCache->Magazines[ClassIndex];
+            if (Magazine.Count == 0)
+            {
+                Refill(Magazine, ClassIndex);
+            }
+            return Magazine.Blocks[--Magazine.Count];
+        }
+        std::lock_guard Lock(Mutex);
+        return Pool.allocate(GetClassSize(ClassIndex), MinClassSize);
+    }
+
+    std::lock_guard Lock(Mutex);
+    return Pool.allocate(Bytes, Alignment);
+}
+
+void CThreadCachedResource::do_deallocate(void* Ptr, size_t Bytes, size_t Alignment)
+{
+    if (IsCachedSize(Bytes, Alignment))
+    {
+        auto ClassIndex = GetClassIndex(Bytes);
+        if (auto ThreadCache = GetThreadCache())
+        {
+            auto& Magazine = ThreadCache->Magazines[ClassIndex];
+            if (Magazine.Count == MagazineSize)
+            {
+                Flush(Magazine, ClassIndex, BatchSize);
+            }
+            Magazine.Blocks[Magazine.Count++] = Ptr;
+            return;
+        }
+        std::lock_guard Lock(Mutex);
+        Pool.deallocate(Ptr, GetClassSize(ClassIndex), MinClassSize);
+        return;
+    }
+
+    std::lock_guard Lock(Mutex);
+    Pool.deallocate(Ptr, Bytes, Alignment);
+}
+
+CFrameResource::CFrameResource(std::pmr::memory_resource* up)
+    : Upstream(up)
+{
+    Log::Memory<ELogLevel::Critical>("Creating frame resource, total size: %zu bytes", FrameHeapSize * Buffers.size());
+}
+
+void CFrameResource::NextFrame()
+{
+    CurrentBuffer = (CurrentBuffer + 1) % Buffers.size();
+    Offset = 0;
+}
+
+void* CFrameResource::do_allocate(size_t Bytes, size_t Alignment)
+{
+    auto& Buffer = Buffers[CurrentBuffer];
+    void* Ptr = Buffer.data() + Offset;
+    std::size_t Space = Buffer.size() - Offset;
+    if (std::align(Alignment, Bytes, Ptr, Space) != nullptr)
+    {
+        Offset = Buffer.size() - Space + Bytes;
+        HighWaterMark = std::max(HighWaterMark, Offset);
+        return Ptr;
+    }
+
+    OverflowCount++;
+
+    Log::Memory<ELogLevel::Verbose>("Frame resource overflow, allocating %zu bytes from upstream", Bytes);
+
+    return Upstream->allocate(Bytes, Alignment);
+}
+
+void CFrameResource::do_deallocate(void* Ptr, size_t Bytes, size_t Alignment)
+{
+    /* Frame memory is only released by NextFrame(). */
+    if (!IsFramePtr(Ptr))
+    {
+        Upstream->deallocate(Ptr, Bytes, Alignment);
+    }
+}
+
 namespace Memory
 {
     CTopmostResource TopmostResource;
     CInlineResource InlineResource(&TopmostResource);
-    std::pmr::synchronized_pool_resource PoolResource(&InlineResource);
+    CThreadCachedResource PoolResource(&InlineResource);
+    CFrameResource FrameResource(&InlineResource);
+    /* Static initialization runs on the main thread. */
+    const std::thread::id FrameThreadID = std::this_thread::get_id();
 
     std::pmr::memory_resource* GetInlineResource()
     {
@@ -298,21 +710,53 @@ namespace Memory
         return &PoolResource;
     }
 
-    void* Malloc(size_t Bytes)
+    std::pmr::memory_resource* GetFrameResource()
+    {
+        /* Only the main thread reclaims frame memory, other threads get pool memory for the same scratch vectors. */
+        return std::this_thread::get_id() == FrameThreadID ? static_cast<std::pmr::memory_resource*>(&FrameResource) : &PoolResource;
+    }
+
+    SScopedTag::SScopedTag(EMemoryTag Tag)
+        : PreviousTag(ScopedTag)
+    {
+        ScopedTag = Tag;
+    }
+
+    SScopedTag::~SScopedTag()
+    {
+        ScopedTag = PreviousTag;
+    }
+
+    const char* GetTagName(EMemoryTag Tag)
     {
+        static constexpr std::array<const char*, (std::size_t)EMemoryTag::Count> Names = {
+            "Untagged",
+            "SDL",
+            "Image",
+            "Mesh",
+            "Game",
+        };
+        return Names[(std::size_t)Tag];
+    }
+
+    void* Malloc(size_t Bytes, EMemoryTag Tag)
+    {
+        SScopedTag Scope(Tag);
         void* Ptr = InlineResource.do_allocate(Bytes, alignof(std::max_align_t));
         return Ptr;
     }
 
-    void* Calloc(size_t Num, size_t Bytes)
+    void* Calloc(size_t Num, size_t Bytes, EMemoryTag Tag)
     {
+        SScopedTag Scope(Tag);
         void* Ptr = InlineResource.do_allocate(Num * Bytes, alignof(std::max_align_t));
         std::memset(Ptr, 0, Bytes * Num);
         return Ptr;
     }
 
-    void* Realloc(void* Ptr, size_t Bytes)
+    void* Realloc(void* Ptr, size_t Bytes, EMemoryTag Tag)
     {
+        SScopedTag Scope(Tag);
         return InlineResource.do_reallocate(Ptr, Bytes);
     }
 
@@ -325,4 +769,29 @@ namespace Memory
     {
         return InlineResource.NumberOfBlocks();
     }
-}
\ No newline at end of file
+
+    SInlineResourceStats GetInlineStats()
+    {
+        return InlineResource.GetStats();
+    }
+
+    STopmostResourceStats GetTopmostStats()
+    {
+        return TopmostResource.GetStats();
+    }
+
+    void NextFrame()
+    {
+        FrameResource.NextFrame();
+    }
+
+    std::size_t FrameHighWaterMark()
+    {
+        return FrameResource.GetHighWaterMark();
+    }
+
+    std::size_t FrameOverflowCount()
+    {
+        return FrameResource.GetOverflowCount();
+    }
+}
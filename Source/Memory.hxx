@@ -6,27 +6,121 @@
 #include <mutex>
 #include <memory_resource>
 #include <cstddef>
+#include <cstdint>
 #include <array>
+#include <atomic>
 
 static constexpr std::size_t HeapSize = 1024 * 1024 * 16;
+static constexpr std::size_t FrameHeapSize = 1024 * 1024;
 
+/* Attributes allocations to their call site, see Memory::SScopedTag. */
+enum class EMemoryTag : uint8_t
+{
+    Untagged,
+    SDL,
+    Image,
+    Mesh,
+    Game,
+    Count
+};
+
+struct SMemoryTagStats
+{
+    std::size_t Allocations{};
+    std::size_t BlocksLive{};
+    std::size_t BytesLive{};
+};
+
+struct SInlineResourceStats
+{
+    /* Inline byte counts include block headers, i.e. how much of HeapSize is taken. */
+    std::size_t BytesLive{};
+    std::size_t PeakBytesLive{};
+    std::size_t BlocksLive{};
+    std::size_t Allocations{};
+    std::size_t UpstreamFallbacks{};
+    std::size_t UpstreamBytesLive{};
+    std::size_t Reallocations{};
+    std::size_t ReallocationsInPlace{};
+    std::size_t ReallocBytesCopied{};
+    std::size_t FreeBytes{};
+    std::size_t LargestFreeBlock{};
+    std::array<SMemoryTagStats, (std::size_t)EMemoryTag::Count> Tags{};
+
+    [[nodiscard]] float GetFragmentation() const
+    {
+        return FreeBytes > 0 ? 1.0f - (float)LargestFreeBlock / (float)FreeBytes : 0.0f;
+    }
+};
+
+struct STopmostResourceStats
+{
+    std::size_t BytesLive{};
+    std::size_t PeakBytesLive{};
+    std::size_t Allocations{};
+};
+
+/* Two-level segregated fit allocator over an inline buffer.
+ * First level splits free blocks by power of two, second level splits each power of two linearly,
+ * so finding a fitting block and freeing one are both O(1). */
 class CInlineResource final : public std::pmr::memory_resource
 {
 private:
-    struct alignas(alignof(std::max_align_t)) SAllocationHeader
+    static constexpr std::size_t AlignSizeLog2 = 4;
+    static constexpr std::size_t AlignSize = 1 << AlignSizeLog2;
+
+    static constexpr std::size_t SLIndexCountLog2 = 4;
+    static constexpr std::size_t SLIndexCount = 1 << SLIndexCountLog2;
+    static constexpr std::size_t FLIndexShift = SLIndexCountLog2 + AlignSizeLog2;
+    static constexpr std::size_t FLIndexMax = 25;
+    static constexpr std::size_t FLIndexCount = FLIndexMax - FLIndexShift + 1;
+    static constexpr std::size_t SmallBlockSize = 1 << FLIndexShift;
+
+    static constexpr std::size_t FreeBit = 1 << 0;
+    static constexpr std::size_t TagShift = 1;
+    static constexpr std::size_t TagMask = 0b111 << TagShift;
+    static constexpr std::size_t FlagMask = AlignSize - 1;
+
+    static_assert((std::size_t)EMemoryTag::Count <= (TagMask >> TagShift) + 1);
+
+    static_assert(alignof(std::max_align_t) <= AlignSize);
+    static_assert(HeapSize < (std::size_t(1) << FLIndexMax));
+
+    struct alignas(AlignSize) SAllocationHeader
+    {
+        SAllocationHeader* PreviousPhysicalBlock{};
+        std::size_t Size{};
+
+        /* Only valid while the block is free, overlaps user data otherwise. */
+        SAllocationHeader* NextFreeBlock{};
+        SAllocationHeader* PreviousFreeBlock{};
+    };
+
+    /* Precedes allocations that didn't fit into the buffer. */
+    struct alignas(AlignSize) SUpstreamHeader
     {
+        void* Base{};
         std::size_t Length{};
-        SAllocationHeader* PreviousBlock{};
-        SAllocationHeader* NextBlock{};
     };
 
+    static constexpr std::size_t HeaderSize = AlignSize;
+    static constexpr std::size_t MinBlockSize = sizeof(SAllocationHeader);
+
+    /* Growing buffers past this size move to upstream instead of eating into the inline buffer. */
+    static constexpr std::size_t LargeBlockSize = HeapSize / 16;
+
+    static_assert(sizeof(SUpstreamHeader) == HeaderSize);
+    static_assert(2 * sizeof(void*) <= HeaderSize);
+
     alignas(alignof(std::max_align_t))
         std::array<std::byte, HeapSize> Buffer{};
-    SAllocationHeader* FirstAllocation{};
+    SAllocationHeader* Sentinel{};
+    uint32_t FLBitmap{};
+    std::array<uint32_t, FLIndexCount> SLBitmap{};
+    std::array<std::array<SAllocationHeader*, SLIndexCount>, FLIndexCount> FreeBlocks{};
     std::pmr::memory_resource* Upstream = std::pmr::new_delete_resource();
     std::mutex Mutex;
-
-    void DestroyBlock(SAllocationHeader* AllocationHeader);
+    SInlineResourceStats Stats{};
 
     static constexpr std::size_t DoAlign(std::size_t Num, std::size_t Alignment)
     {
@@ -43,6 +137,74 @@ private:
         return ((std::size_t)Ptr & (Alignment - 1)) == 0;
     }
 
+    static constexpr std::size_t AdjustBlockSize(std::size_t Bytes)
+    {
+        auto BlockSize = DoAlign(Bytes + HeaderSize, AlignSize);
+        return BlockSize < MinBlockSize ? MinBlockSize : BlockSize;
+    }
+
+    static inline std::size_t GetBlockSize(const SAllocationHeader* Block) { return Block->Size & ~FlagMask; }
+
+    static inline bool IsFreeBlock(const SAllocationHeader* Block) { return Block->Size & FreeBit; }
+
+    static inline EMemoryTag GetBlockTag(const SAllocationHeader* Block) { return EMemoryTag((Block->Size & TagMask) >> TagShift); }
+
+    static inline std::byte* BlockToData(SAllocationHeader* Block)
+    {
+        return reinterpret_cast<std::byte*>(Block) + HeaderSize;
+    }
+
+    static inline SAllocationHeader* DataToBlock(void* Ptr)
+    {
+        return reinterpret_cast<SAllocationHeader*>(static_cast<std::byte*>(Ptr) - HeaderSize);
+    }
+
+    static inline SAllocationHeader* NextPhysicalBlock(SAllocationHeader* Block)
+    {
+        return reinterpret_cast<SAllocationHeader*>(reinterpret_cast<std::byte*>(Block) + GetBlockSize(Block));
+    }
+
+    static void MappingInsert(std::size_t Size, std::size_t& FL, std::size_t& SL);
+
+    static void MappingSearch(std::size_t Size, std::size_t& FL, std::size_t& SL);
+
+    [[nodiscard]] bool IsInlinePtr(const void* Ptr) const
+    {
+        auto BytePtr = static_cast<const std::byte*>(Ptr);
+        return BytePtr >= Buffer.data() && BytePtr < Buffer.data() + Buffer.size();
+    }
+
+    void InsertFreeBlock(SAllocationHeader* Block);
+
+    void RemoveFreeBlock(SAllocationHeader* Block);
+
+    SAllocationHeader* TakeFreeBlock(std::size_t Size);
+
+    SAllocationHeader* AlignBlock(SAllocationHeader* Block, std::size_t Alignment);
+
+    void TrimBlock(SAllocationHeader* Block, std::size_t Size);
+
+    void AbsorbNextBlock(SAllocationHeader* Block);
+
+    void FreeBlock(SAllocationHeader* Block);
+
+    void* Allocate(std::size_t Bytes, std::size_t Alignment, EMemoryTag Tag, std::size_t Headroom = 0);
+
+    void* AllocateUpstream(std::size_t Bytes, std::size_t Alignment);
+
+    void Deallocate(void* Ptr);
+
+    void* GrowBackwards(SAllocationHeader* Block, std::size_t BlockSize, std::size_t ReservedSize, std::size_t Alignment);
+
+    void* Reallocate(void* Ptr, std::size_t Bytes, std::size_t Alignment, EMemoryTag Tag);
+
+    void UpdateBlockStats(const SAllocationHeader* Block, std::ptrdiff_t BlockCount, std::ptrdiff_t BlockSize);
+
+    /* Everything in the buffer except the sentinel is either free or in use. */
+    [[nodiscard]] std::size_t GetBytesLive() const { return HeapSize - HeaderSize - Stats.FreeBytes; }
+
+    [[nodiscard]] std::size_t FindLargestFreeBlock() const;
+
 public:
     explicit CInlineResource(std::pmr::memory_resource* up = std::pmr::new_delete_resource());
 
@@ -50,13 +212,15 @@ public:
 
     size_t NumberOfBlocks();
 
+    SInlineResourceStats GetStats();
+
     void* do_allocate(size_t bytes, size_t alignment) override;
 
     void do_deallocate(void* ptr, size_t bytes, size_t alignment) override;
 
     void* do_reallocate(void* ptr, size_t bytes);
 
-    void* AllocateInline(void* SrcPtr, size_t Bytes, size_t Alignment = alignof(std::max_align_t));
+    void* AllocateInline(void* SrcPtr, size_t Bytes, size_t Alignment = alignof(std::max_align_t), EMemoryTag Tag = EMemoryTag::Untagged);
 
     [[nodiscard]] inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
     {
@@ -66,10 +230,117 @@ public:
 
 class CTopmostResource final : public std::pmr::memory_resource
 {
+    std::atomic<std::size_t> BytesLive{};
+    std::atomic<std::size_t> PeakBytesLive{};
+    std::atomic<std::size_t> Allocations{};
+
     void* do_allocate(size_t Bytes, size_t Align) override;
 
     void do_deallocate(void* Pointer, size_t Bytes, size_t Align) noexcept override;
 
+    [[nodiscard]] inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+public:
+    [[nodiscard]] STopmostResourceStats GetStats() const;
+};
+
+/* Pool with per-thread magazines of small blocks in front of it.
+ * Common path only touches thread-local data, misses refill and flush in batches under a single lock. */
+class CThreadCachedResource final : public std::pmr::memory_resource
+{
+private:
+    static constexpr std::size_t MinClassSizeLog2 = 4;
+    static constexpr std::size_t MinClassSize = std::size_t(1) << MinClassSizeLog2;
+    static constexpr std::size_t ClassCount = 8;
+    static constexpr std::size_t MaxClassSize = MinClassSize << (ClassCount - 1);
+    static constexpr std::size_t MagazineSize = 32;
+    static constexpr std::size_t BatchSize = MagazineSize / 2;
+
+    static_assert(alignof(std::max_align_t) <= MinClassSize);
+
+    struct SMagazine
+    {
+        std::array<void*, MagazineSize> Blocks{};
+        std::size_t Count{};
+    };
+
+    struct SThreadCache
+    {
+        CThreadCachedResource* Owner{};
+        std::array<SMagazine, ClassCount> Magazines{};
+
+        ~SThreadCache();
+    };
+
+    std::pmr::unsynchronized_pool_resource Pool;
+    std::mutex Mutex;
+
+    static bool IsCachedSize(std::size_t Bytes, std::size_t Alignment)
+    {
+        return Bytes <= MaxClassSize && Alignment <= MinClassSize;
+    }
+
+    static std::size_t GetClassIndex(std::size_t Bytes);
+
+    static constexpr std::size_t GetClassSize(std::size_t ClassIndex)
+    {
+        return MinClassSize << ClassIndex;
+    }
+
+    SThreadCache* GetThreadCache();
+
+    void Refill(SMagazine& Magazine, std::size_t ClassIndex);
+
+    void Flush(SMagazine& Magazine, std::size_t ClassIndex, std::size_t Count);
+
+public:
+    explicit CThreadCachedResource(std::pmr::memory_resource* up);
+
+    void* do_allocate(size_t Bytes, size_t Alignment) override;
+
+    void do_deallocate(void* Ptr, size_t Bytes, size_t Alignment) override;
+
+    [[nodiscard]] inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+/* Double-buffered bump allocator for transient per-frame data.
+ * Memory stays valid until the end of the next frame. Main thread only, GetFrameResource() falls back to the pool elsewhere. */
+class CFrameResource final : public std::pmr::memory_resource
+{
+private:
+    alignas(alignof(std::max_align_t))
+        std::array<std::array<std::byte, FrameHeapSize>, 2> Buffers{};
+    std::size_t CurrentBuffer{};
+    std::size_t Offset{};
+    std::size_t HighWaterMark{};
+    std::size_t OverflowCount{};
+    std::pmr::memory_resource* Upstream{};
+
+    [[nodiscard]] bool IsFramePtr(const void* Ptr) const
+    {
+        auto BytePtr = static_cast<const std::byte*>(Ptr);
+        return BytePtr >= Buffers.front().data() && BytePtr < Buffers.back().data() + FrameHeapSize;
+    }
+
+public:
+    explicit CFrameResource(std::pmr::memory_resource* up);
+
+    void NextFrame();
+
+    [[nodiscard]] std::size_t GetHighWaterMark() const { return HighWaterMark; }
+
+    [[nodiscard]] std::size_t GetOverflowCount() const { return OverflowCount; }
+
+    void* do_allocate(size_t Bytes, size_t Alignment) override;
+
+    void do_deallocate(void* Ptr, size_t Bytes, size_t Alignment) override;
+
     [[nodiscard]] inline bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
     {
         return this == &other;
@@ -80,10 +351,24 @@ namespace Memory
 {
     std::pmr::memory_resource* GetInlineResource();
     std::pmr::memory_resource* GetPoolResource();
+    std::pmr::memory_resource* GetFrameResource();
+
+    /* Tags pmr allocations made by the current thread while in scope. */
+    struct SScopedTag
+    {
+        EMemoryTag PreviousTag;
+
+        explicit SScopedTag(EMemoryTag Tag);
+        ~SScopedTag();
+
+        SScopedTag(const SScopedTag&) = delete;
+        SScopedTag& operator=(const SScopedTag&) = delete;
+    };
 
     template <typename T>
-    inline static std::shared_ptr<T> MakeShared()
+    inline static std::shared_ptr<T> MakeShared(EMemoryTag Tag = EMemoryTag::Untagged)
     {
+        SScopedTag Scope(Tag);
         return std::allocate_shared<T, std::pmr::polymorphic_allocator<T>>(GetInlineResource());
     }
 
@@ -93,10 +378,24 @@ namespace Memory
         return std::pmr::vector<T>(GetPoolResource());
     }
 
-    void* Malloc(size_t Bytes);
-    void* Calloc(size_t Num, size_t Bytes);
-    void* Realloc(void* Ptr, size_t Bytes);
+    template <typename T>
+    inline static auto GetFrameVector()
+    {
+        return std::pmr::vector<T>(GetFrameResource());
+    }
+
+    const char* GetTagName(EMemoryTag Tag);
+
+    void* Malloc(size_t Bytes, EMemoryTag Tag = EMemoryTag::Untagged);
+    void* Calloc(size_t Num, size_t Bytes, EMemoryTag Tag = EMemoryTag::Untagged);
+    void* Realloc(void* Ptr, size_t Bytes, EMemoryTag Tag = EMemoryTag::Untagged);
     void Free(void* Ptr);
 
     std::size_t NumberOfBlocks();
+    SInlineResourceStats GetInlineStats();
+    STopmostResourceStats GetTopmostStats();
+
+    void NextFrame();
+    std::size_t FrameHighWaterMark();
+    std::size_t FrameOverflowCount();
 }
@@ -0,0 +1,204 @@
+#include "Pathfinding.hxx"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include "Tilemap.hxx"
+#include "World.hxx"
+
+bool SFlowField::GetStep(const SVec2Int& Coords, SDirection& OutDirection) const
+{
+    if (!bValid || Coords.X < 0 || Coords.Y < 0 || Coords.X >= Width || Coords.Y >= Height)
+    {
+        return false;
+    }
+    auto Direction = Directions[(std::size_t)Coords.Y * Width + Coords.X];
+    if (Direction == NoDirection)
+    {
+        return false;
+    }
+    OutDirection = SDirection{ Direction };
+    return true;
+}
+
+uint32_t SFlowField::GetDistance(const SVec2Int& Coords) const
+{
+    if (!bValid || Coords.X < 0 || Coords.Y < 0 || Coords.X >= Width || Coords.Y >= Height)
+    {
+        return Unreachable;
+    }
+    return Distances[(std::size_t)Coords.Y * Width + Coords.X];
+}
+
+bool CPathfinder::FindPath(const STilemap& Tilemap, const SVec2Int& Start, const SVec2Int& Goal, std::pmr::vector<SDirection>& OutSteps)
+{
+    if (!Tilemap.IsValidTile(Start) || !Tilemap.IsValidTile(Goal) || Tilemap.Adjacency.size() != Tilemap.TileCount())
+    {
+        return false;
+    }
+    if (Start == Goal)
+    {
+        return true;
+    }
+
+    auto TileCount = Tilemap.TileCount();
+    if (Stamps.size() != TileCount)
+    {
+        Costs.assign(TileCount, 0);
+        Stamps.assign(TileCount, 0);
+        CameFrom.assign(TileCount, 0);
+        Stamp = 0;
+    }
+    if (++Stamp == 0)
+    {
+        /* Wrapped around, old stamps could match again. */
+        std::fill(Stamps.begin(), Stamps.end(), 0);
+        Stamp = 1;
+    }
+
+    auto Heuristic = [&](const SVec2Int& Coords) {
+        return (uint32_t)(std::abs(Coords.X - Goal.X) + std::abs(Coords.Y - Goal.Y));
+    };
+
+    auto StartIndex = (uint32_t)Tilemap.CoordsToIndex(Start);
+    auto GoalIndex = (uint32_t)Tilemap.CoordsToIndex(Goal);
+    Stamps[StartIndex] = Stamp;
+    Costs[StartIndex] = 0;
+    OpenNodes.clear();
+    OpenNodes.push_back({ Heuristic(Start), 0, StartIndex });
+
+    while (!OpenNodes.empty())
+    {
+        std::pop_heap(OpenNodes.begin(), OpenNodes.end(), std::greater<>());
+        auto Node = OpenNodes.back();
+        OpenNodes.pop_back();
+
+        auto Coords = Tilemap.IndexToCoords(Node.Index);
+        auto Cost = Costs[Node.Index];
+        if (Node.Cost != Cost)
+        {
+            /* Superseded by a cheaper entry for the same tile. */
+            continue;
+        }
+
+        if (Node.Index == GoalIndex)
+        {
+            /* Walk back from the goal, filling steps from the end. */
+            auto First = OutSteps.size();
+            OutSteps.resize(First + Cost);
+            auto Index = GoalIndex;
+            for (auto Step = Cost; Step-- > 0;)
+            {
+                auto Direction = SDirection{ CameFrom[Index] };
+                OutSteps[First + Step] = Direction;
+                Index = (uint32_t)Tilemap.CoordsToIndex(Tilemap.IndexToCoords(Index) - Direction.GetVector<int>());
+            }
+            return true;
+        }
+
+        auto Adjacency = Tilemap.Adjacency[Node.Index];
+        for (auto& Direction : SDirection::All())
+        {
+            if (!(Adjacency & ETileAdjacency::Passable(Direction)))
+            {
+                continue;
+            }
+            auto NeighborCoords = Coords + Direction.GetVector<int>();
+            auto NeighborIndex = (uint32_t)Tilemap.CoordsToIndex(NeighborCoords);
+            if (Stamps[NeighborIndex] == Stamp && Costs[NeighborIndex] <= Cost + 1)
+            {
+                continue;
+            }
+            Stamps[NeighborIndex] = Stamp;
+            Costs[NeighborIndex] = Cost + 1;
+            CameFrom[NeighborIndex] = (uint8_t)Direction.Index;
+            OpenNodes.push_back({ Cost + 1 + Heuristic(NeighborCoords), Cost + 1, NeighborIndex });
+            std::push_heap(OpenNodes.begin(), OpenNodes.end(), std::greater<>());
+        }
+    }
+
+    return false;
+}
+
+const SFlowField* CPathfinder::GetFlowField(SWorldLevel& Level, const SVec2Int& Target)
+{
+    if (FlowFieldLevel != &Level || (Level.DirtyFlags & ELevelDirtyFlags::Navigation))
+    {
+        Invalidate();
+        FlowFieldLevel = &Level;
+        Level.DirtyFlags &= ~ELevelDirtyFlags::Navigation;
+    }
+    if (!Level.IsValidTile(Target) || Level.Adjacency.size() != Level.TileCount())
+    {
+        return nullptr;
+    }
+
+    /* Reuse the field for this target, else take an empty slot, else the least recently used one. */
+    auto Slot = &FlowFields[0];
+    for (auto& Field : FlowFields)
+    {
+        if (Field.bValid && Field.Target == Target)
+        {
+            Field.LastUsed = ++FlowFieldUses;
+            return &Field;
+        }
+        if (Slot->bValid && (!Field.bValid || Field.LastUsed < Slot->LastUsed))
+        {
+            Slot = &Field;
+        }
+    }
+
+    BuildFlowField(Level, *Slot, Target);
+    Slot->LastUsed = ++FlowFieldUses;
+    return Slot;
+}
+
+void CPathfinder::Invalidate()
+{
+    for (auto& Field : FlowFields)
+    {
+        Field.bValid = false;
+    }
+    FlowFieldLevel = nullptr;
+}
+
+void CPathfinder::BuildFlowField(const STilemap& Tilemap, SFlowField& Field, const SVec2Int& Target)
+{
+    auto TileCount = Tilemap.TileCount();
+    Field.Target = Target;
+    Field.Width = Tilemap.Width;
+    Field.Height = Tilemap.Height;
+    Field.Directions.assign(TileCount, SFlowField::NoDirection);
+    Field.Distances.assign(TileCount, SFlowField::Unreachable);
+    Field.bValid = true;
+
+    Queue.resize(TileCount);
+    std::size_t Head{};
+    std::size_t Tail{};
+    Field.Distances[Tilemap.CoordsToIndex(Target)] = 0;
+    Queue[Tail++] = Target;
+
+    while (Head < Tail)
+    {
+        auto Coords = Queue[Head++];
+        auto Index = Tilemap.CoordsToIndex(Coords);
+        for (auto& Direction : SDirection::All())
+        {
+            /* Edges are walked backwards: the neighbor has to be able to step into this tile. */
+            auto NeighborCoords = Coords + Direction.GetVector<int>();
+            if (!Tilemap.IsValidTile(NeighborCoords))
+            {
+                continue;
+            }
+            auto NeighborIndex = Tilemap.CoordsToIndex(NeighborCoords);
+            auto StepDirection = Direction.Inverted();
+            if (Field.Distances[NeighborIndex] != SFlowField::Unreachable || !(Tilemap.Adjacency[NeighborIndex] & ETileAdjacency::Passable(StepDirection)))
+            {
+                continue;
+            }
+            Field.Distances[NeighborIndex] = Field.Distances[Index] + 1;
+            Field.Directions[NeighborIndex] = (uint8_t)StepDirection.Index;
+            Queue[Tail++] = NeighborCoords;
+        }
+    }
+}
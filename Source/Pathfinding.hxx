@@ -0,0 +1,77 @@
+#pragma once
+
+#include <array>
+#include <memory_resource>
+#include "CommonTypes.hxx"
+#include "Math.hxx"
+#include "Memory.hxx"
+
+struct STilemap;
+struct SWorldLevel;
+
+/* Breadth-first field towards a single target, shared by every agent heading there. */
+struct SFlowField
+{
+    static constexpr uint8_t NoDirection = UINT8_MAX;
+    static constexpr uint32_t Unreachable = UINT32_MAX;
+
+    SVec2Int Target{};
+    int32_t Width{};
+    int32_t Height{};
+    /* Per tile: direction index of the next step towards Target. */
+    std::pmr::vector<uint8_t> Directions{ Memory::GetPoolResource() };
+    /* Per tile: steps left to Target. */
+    std::pmr::vector<uint32_t> Distances{ Memory::GetPoolResource() };
+    uint64_t LastUsed{};
+    bool bValid{};
+
+    [[nodiscard]] bool GetStep(const SVec2Int& Coords, SDirection& OutDirection) const;
+
+    [[nodiscard]] uint32_t GetDistance(const SVec2Int& Coords) const;
+};
+
+/* Shortest paths over STilemap::Adjacency, every step costs the same.
+ * Scratch buffers stay allocated between queries, so queries on a level of the same size don't allocate. */
+class CPathfinder
+{
+public:
+    static constexpr std::size_t MaxFlowFields = 8;
+
+    /* A* from Start to Goal. On success the steps are appended to OutSteps. */
+    bool FindPath(const STilemap& Tilemap, const SVec2Int& Start, const SVec2Int& Goal, std::pmr::vector<SDirection>& OutSteps);
+
+    /* Fields are cached per target, the cache is dropped when another level is passed in or
+     * ELevelDirtyFlags::Navigation is raised on this one. Returns nullptr for invalid targets. */
+    const SFlowField* GetFlowField(SWorldLevel& Level, const SVec2Int& Target);
+
+    void Invalidate();
+
+private:
+    struct SOpenNode
+    {
+        uint32_t Estimate;
+        uint32_t Cost;
+        uint32_t Index;
+
+        /* Ties go to the node furthest along, otherwise open rooms expand every equal-estimate tile. */
+        bool operator>(const SOpenNode& Other) const
+        {
+            return Estimate != Other.Estimate ? Estimate > Other.Estimate : Cost < Other.Cost;
+        }
+    };
+
+    /* A* state, a tile's entries are only meaningful when its stamp matches the current query. */
+    std::pmr::vector<uint32_t> Costs{ Memory::GetPoolResource() };
+    std::pmr::vector<uint32_t> Stamps{ Memory::GetPoolResource() };
+    std::pmr::vector<uint8_t> CameFrom{ Memory::GetPoolResource() };
+    std::pmr::vector<SOpenNode> OpenNodes{ Memory::GetPoolResource() };
+    uint32_t Stamp{};
+
+    std::pmr::vector<SVec2Int> Queue{ Memory::GetPoolResource() };
+
+    std::array<SFlowField, MaxFlowFields> FlowFields{};
+    const SWorldLevel* FlowFieldLevel{};
+    uint64_t FlowFieldUses{};
+
+    void BuildFlowField(const STilemap& Tilemap, SFlowField& Field, const SVec2Int& Target);
+};
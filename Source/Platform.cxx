@@ -7,6 +7,18 @@
 #include "SDL_video.h"
 #include "Constants.hxx"
 
+#ifdef EQUINOX_REACH_DEVELOPMENT
+    #ifdef _WIN32
+        #define WIN32_LEAN_AND_MEAN
+        #include <windows.h>
+    #else
+        #include <fcntl.h>
+        #include <sys/mman.h>
+        #include <sys/stat.h>
+        #include <unistd.h>
+    #endif
+#endif
+
 void SPlatform::SwapBuffers() const
 {
     SDL_GL_SwapWindow(Window);
@@ -25,7 +37,11 @@ void SPlatform::Init()
     },
         nullptr);
 
-    if (SDL_SetMemoryFunctions(&Memory::Malloc, &Memory::Calloc, &Memory::Realloc, &Memory::Free))
+    if (SDL_SetMemoryFunctions(
+            [](size_t Bytes) { return Memory::Malloc(Bytes, EMemoryTag::SDL); },
+            [](size_t Num, size_t Bytes) { return Memory::Calloc(Num, Bytes, EMemoryTag::SDL); },
+            [](void* Ptr, size_t Bytes) { return Memory::Realloc(Ptr, Bytes, EMemoryTag::SDL); },
+            &Memory::Free))
     {
         SDL_LogError(SDL_LOG_CATEGORY_CUSTOM, "Error %s", SDL_GetError());
         exit(1);
@@ -106,3 +122,117 @@ void SPlatform::SetOptimalWindowedResolution() const
     SDL_SetWindowPosition(Window, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED);
     SDL_SetWindowFullscreen(Window, false);
 }
+
+#ifdef EQUINOX_REACH_DEVELOPMENT
+    #ifdef _WIN32
+CMappedFile::CMappedFile(const std::filesystem::path& Path)
+{
+    FileHandle = CreateFileW(Path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        FileHandle = nullptr;
+        Log::Platform<ELogLevel::Critical>("Failed to open %s for mapping", Path.string().c_str());
+        return;
+    }
+
+    LARGE_INTEGER Size{};
+    GetFileSizeEx(FileHandle, &Size);
+    Length = (size_t)Size.QuadPart;
+
+    /* Empty files can't be mapped, but they are still valid (empty) views. */
+    if (Length > 0)
+    {
+        MappingHandle = CreateFileMappingW(FileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        Data = MappingHandle != nullptr ? static_cast<const unsigned char*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0)) : nullptr;
+        if (Data == nullptr)
+        {
+            Log::Platform<ELogLevel::Critical>("Failed to map %s", Path.string().c_str());
+            Length = 0;
+            return;
+        }
+    }
+    bValid = true;
+}
+
+CMappedFile::~CMappedFile()
+{
+    if (Data != nullptr)
+    {
+        UnmapViewOfFile(Data);
+    }
+    if (MappingHandle != nullptr)
+    {
+        CloseHandle(MappingHandle);
+    }
+    if (FileHandle != nullptr)
+    {
+        CloseHandle(FileHandle);
+    }
+}
+
+bool SyncFile(const std::filesystem::path& Path)
+{
+    auto FileHandle = CreateFileW(Path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (FileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    auto bSynced = FlushFileBuffers(FileHandle) != 0;
+    CloseHandle(FileHandle);
+    return bSynced;
+}
+    #else
+CMappedFile::CMappedFile(const std::filesystem::path& Path)
+{
+    int File = open(Path.c_str(), O_RDONLY);
+    if (File < 0)
+    {
+        Log::Platform<ELogLevel::Critical>("Failed to open %s for mapping", Path.c_str());
+        return;
+    }
+
+    struct stat Stat{};
+    if (fstat(File, &Stat) == 0)
+    {
+        Length = (size_t)Stat.st_size;
+
+        /* Empty files can't be mapped, but they are still valid (empty) views. */
+        void* Mapping = Length > 0 ? mmap(nullptr, Length, PROT_READ, MAP_PRIVATE, File, 0) : nullptr;
+        if (Mapping != MAP_FAILED)
+        {
+            Data = static_cast<const unsigned char*>(Mapping);
+            bValid = true;
+        }
+    }
+
+    /* The mapping keeps its own reference to the file. */
+    close(File);
+
+    if (!bValid)
+    {
+        Log::Platform<ELogLevel::Critical>("Failed to map %s", Path.c_str());
+        Length = 0;
+    }
+}
+
+CMappedFile::~CMappedFile()
+{
+    if (Data != nullptr)
+    {
+        munmap(const_cast<unsigned char*>(Data), Length);
+    }
+}
+
+bool SyncFile(const std::filesystem::path& Path)
+{
+    int File = open(Path.c_str(), O_WRONLY);
+    if (File < 0)
+    {
+        return false;
+    }
+    auto bSynced = fsync(File) == 0;
+    close(File);
+    return bSynced;
+}
+    #endif
+#endif
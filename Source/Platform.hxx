@@ -2,6 +2,11 @@
 
 #include "CommonTypes.hxx"
 
+#ifdef EQUINOX_REACH_DEVELOPMENT
+    #include <filesystem>
+    #include "AssetTools.hxx"
+#endif
+
 struct SPlatform : SPlatformState
 {
     struct SDL_Window* Window{};
@@ -20,3 +25,36 @@ struct SPlatform : SPlatformState
 
     void SetOptimalWindowedResolution() const;
 };
+
+#ifdef EQUINOX_REACH_DEVELOPMENT
+/* Read-only memory mapping of a file on disk, so development builds can consume loose files
+ * through the same zero-copy SAsset path as incbin'd assets. */
+class CMappedFile
+{
+    const unsigned char* Data{};
+    size_t Length{};
+    bool bValid{};
+    #ifdef _WIN32
+    void* FileHandle{};
+    void* MappingHandle{};
+    #endif
+
+public:
+    explicit CMappedFile(const std::filesystem::path& Path);
+    ~CMappedFile();
+
+    CMappedFile(const CMappedFile&) = delete;
+    CMappedFile& operator=(const CMappedFile&) = delete;
+
+    [[nodiscard]] bool IsValid() const { return bValid; }
+
+    /* The view is only valid for as long as this mapping is alive. */
+    [[nodiscard]] SAsset Asset(const char* RelativeAssetPath = "") const
+    {
+        return SAsset{ reinterpret_cast<const char*>(Data), Length, RelativeAssetPath };
+    }
+};
+
+/* Blocks until everything written to the file so far is on the disk. */
+bool SyncFile(const std::filesystem::path& Path);
+#endif
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "SharedConstants.hxx"
+#include "FieldOfView.hxx"
 
 namespace EPlayerUpgrades
 {
@@ -15,4 +16,9 @@ struct SPlayer
     UFlagType Upgrades{};
 
     [[nodiscard]] int ExploreRadius() const { return 3; }
+
+    [[nodiscard]] ERevealShape::Type RevealShape() const
+    {
+        return (Upgrades & EPlayerUpgrades::RevealShapeBlock) ? ERevealShape::Square : ERevealShape::Diamond;
+    }
 };
@@ -0,0 +1,99 @@
+#include "Serialization.hxx"
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #include <immintrin.h>
+    #define SERIALIZATION_SWAP_X64
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>
+    #define SERIALIZATION_SWAP_NEON
+#endif
+
+namespace Serialization
+{
+    void SwapInPlaceScalar(uint32_t* Values, std::size_t Count)
+    {
+        for (std::size_t Index = 0; Index < Count; ++Index)
+        {
+            Values[Index] = Byteswap(Values[Index]);
+        }
+    }
+
+#ifdef SERIALIZATION_SWAP_X64
+    /* SSE2 is always there on x86-64, so this is the baseline: swap bytes within 16-bit lanes, then swap the lanes. */
+    static void SwapInPlaceSSE2(uint32_t* Values, std::size_t Count)
+    {
+        std::size_t Index = 0;
+        for (; Index + 4 <= Count; Index += 4)
+        {
+            auto Ptr = reinterpret_cast<__m128i*>(Values + Index);
+            auto Value = _mm_loadu_si128(Ptr);
+            Value = _mm_or_si128(_mm_slli_epi16(Value, 8), _mm_srli_epi16(Value, 8));
+            Value = _mm_shufflelo_epi16(Value, _MM_SHUFFLE(2, 3, 0, 1));
+            Value = _mm_shufflehi_epi16(Value, _MM_SHUFFLE(2, 3, 0, 1));
+            _mm_storeu_si128(Ptr, Value);
+        }
+        SwapInPlaceScalar(Values + Index, Count - Index);
+    }
+
+    __attribute__((target("avx2"))) static void SwapInPlaceAVX2(uint32_t* Values, std::size_t Count)
+    {
+        const auto Mask = _mm256_setr_epi8(
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+            3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+        std::size_t Index = 0;
+        for (; Index + 8 <= Count; Index += 8)
+        {
+            auto Ptr = reinterpret_cast<__m256i*>(Values + Index);
+            _mm256_storeu_si256(Ptr, _mm256_shuffle_epi8(_mm256_loadu_si256(Ptr), Mask));
+        }
+        SwapInPlaceSSE2(Values + Index, Count - Index);
+    }
+#endif
+
+#ifdef SERIALIZATION_SWAP_NEON
+    static void SwapInPlaceNEON(uint32_t* Values, std::size_t Count)
+    {
+        std::size_t Index = 0;
+        for (; Index + 4 <= Count; Index += 4)
+        {
+            auto Ptr = reinterpret_cast<uint8_t*>(Values + Index);
+            vst1q_u8(Ptr, vrev32q_u8(vld1q_u8(Ptr)));
+        }
+        SwapInPlaceScalar(Values + Index, Count - Index);
+    }
+#endif
+
+    static SwapInPlaceFunc SelectSwapInPlace()
+    {
+#if defined(SERIALIZATION_SWAP_X64)
+        return __builtin_cpu_supports("avx2") ? &SwapInPlaceAVX2 : &SwapInPlaceSSE2;
+#elif defined(SERIALIZATION_SWAP_NEON)
+        return &SwapInPlaceNEON;
+#else
+        return &SwapInPlaceScalar;
+#endif
+    }
+
+    void SwapInPlace(uint32_t* Values, std::size_t Count)
+    {
+        static const SwapInPlaceFunc Func = SelectSwapInPlace();
+        Func(Values, Count);
+    }
+
+    std::size_t GetSwapInPlacePaths(SSwapInPlacePath (&Paths)[SwapInPlaceMaxPaths])
+    {
+        std::size_t Count = 0;
+        Paths[Count++] = { "Scalar", &SwapInPlaceScalar };
+#if defined(SERIALIZATION_SWAP_X64)
+        Paths[Count++] = { "SSE2", &SwapInPlaceSSE2 };
+        if (__builtin_cpu_supports("avx2"))
+        {
+            Paths[Count++] = { "AVX2", &SwapInPlaceAVX2 };
+        }
+#elif defined(SERIALIZATION_SWAP_NEON)
+        Paths[Count++] = { "NEON", &SwapInPlaceNEON };
+#endif
+        return Count;
+    }
+}
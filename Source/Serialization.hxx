@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <fstream>
 
 namespace Endianness
@@ -111,15 +113,43 @@ namespace Serialization
 {
     using namespace Endianness;
 
-    static inline void Write16(std::ofstream& Stream, uint16_t Value)
+    /* Byteswaps every value, picking the widest SIMD path the CPU supports. */
+    void SwapInPlace(uint32_t* Values, std::size_t Count);
+
+    /* Reference implementation, also used for the tails of the SIMD paths. */
+    void SwapInPlaceScalar(uint32_t* Values, std::size_t Count);
+
+    using SwapInPlaceFunc = void (*)(uint32_t*, std::size_t);
+
+    struct SSwapInPlacePath
+    {
+        const char* Name{};
+        SwapInPlaceFunc Func{};
+    };
+
+    inline constexpr std::size_t SwapInPlaceMaxPaths = 3;
+
+    /* Fills Paths with every implementation the CPU can run, scalar first, and returns how many there are. For tests and benchmarks. */
+    std::size_t GetSwapInPlacePaths(SSwapInPlacePath (&Paths)[SwapInPlaceMaxPaths]);
+
+    /* Converts between host and big-endian, i.e. a no-op on big-endian hosts. */
+    static inline void HtoBEInPlace32(uint32_t* Values, std::size_t Count)
+    {
+        if constexpr (!IsBE::Value)
+        {
+            SwapInPlace(Values, Count);
+        }
+    }
+
+    static inline void Write16(std::ostream& Stream, uint16_t Value)
     {
         uint16_t Temp16{};
 
         Temp16 = HtoBE16(Value);
-        Stream.write(reinterpret_cast<char*>(&Temp16), 4);
+        Stream.write(reinterpret_cast<char*>(&Temp16), 2);
     }
 
-    static inline void Write32(std::ofstream& Stream, uint32_t Value)
+    static inline void Write32(std::ostream& Stream, uint32_t Value)
     {
         uint32_t Temp32{};
 
@@ -132,7 +162,7 @@ namespace Serialization
     {
         char Temp[2]{};
 
-        Stream.read(Temp, 4);
+        Stream.read(Temp, 2);
         Value = static_cast<T>(HtoBE16(*reinterpret_cast<uint16_t*>(&Temp[0])));
     }
 
@@ -145,6 +175,106 @@ namespace Serialization
         Value = static_cast<T>(HtoBE32(*reinterpret_cast<uint32_t*>(&Temp[0])));
     }
 
+    template <typename T>
+    static inline void Append16(T& Buffer, uint16_t Value)
+    {
+        auto Temp16 = HtoBE16(Value);
+        auto Bytes = reinterpret_cast<const uint8_t*>(&Temp16);
+        Buffer.insert(Buffer.end(), Bytes, Bytes + sizeof(Temp16));
+    }
+
+    template <typename T>
+    static inline void Append32(T& Buffer, uint32_t Value)
+    {
+        auto Temp32 = HtoBE32(Value);
+        auto Bytes = reinterpret_cast<const uint8_t*>(&Temp32);
+        Buffer.insert(Buffer.end(), Bytes, Bytes + sizeof(Temp32));
+    }
+
+    static inline uint16_t Load16(const uint8_t* Data)
+    {
+        uint16_t Temp16{};
+        std::memcpy(&Temp16, Data, sizeof(Temp16));
+        return HtoBE16(Temp16);
+    }
+
+    static inline uint32_t Load32(const uint8_t* Data)
+    {
+        uint32_t Temp32{};
+        std::memcpy(&Temp32, Data, sizeof(Temp32));
+        return HtoBE32(Temp32);
+    }
+
+    /* Bounds-checked big-endian reader over memory it doesn't own, e.g. SAsset::Data.
+     * Reading past the end zeroes the output and latches the failure state. */
+    struct SpanReader
+    {
+        const uint8_t* Data{};
+        std::size_t Length{};
+        std::size_t Position{};
+        bool bFailed{};
+
+        SpanReader(const uint8_t* InData, std::size_t InLength)
+            : Data(InData), Length(InLength)
+        {
+        }
+
+        [[nodiscard]] bool Failed() const { return bFailed; }
+
+        [[nodiscard]] std::size_t Remaining() const { return Length - Position; }
+
+        bool Seek(std::size_t Offset)
+        {
+            if (Offset > Length)
+            {
+                bFailed = true;
+                return false;
+            }
+            Position = Offset;
+            return true;
+        }
+
+        /* Returns a view into the underlying memory, nullptr if out of bounds. */
+        const uint8_t* ReadBytes(std::size_t Count)
+        {
+            if (bFailed || Count > Remaining())
+            {
+                bFailed = true;
+                return nullptr;
+            }
+            auto Bytes = Data + Position;
+            Position += Count;
+            return Bytes;
+        }
+
+        template <typename T>
+        void Read16(T& Value)
+        {
+            auto Bytes = ReadBytes(sizeof(uint16_t));
+            Value = Bytes != nullptr ? static_cast<T>(Load16(Bytes)) : T{};
+        }
+
+        template <typename T>
+        void Read32(T& Value)
+        {
+            auto Bytes = ReadBytes(sizeof(uint32_t));
+            Value = Bytes != nullptr ? static_cast<T>(Load32(Bytes)) : T{};
+        }
+
+        /* Copies Count values at once and swaps them in place. */
+        void Read32Array(uint32_t* Values, std::size_t Count)
+        {
+            auto Bytes = ReadBytes(Count * sizeof(uint32_t));
+            if (Bytes == nullptr)
+            {
+                std::fill_n(Values, Count, 0);
+                return;
+            }
+            std::memcpy(Values, Bytes, Count * sizeof(uint32_t));
+            HtoBEInPlace32(Values, Count);
+        }
+    };
+
     struct MemoryBuf : std::streambuf
     {
         MemoryBuf(char const* Base, std::size_t Size)
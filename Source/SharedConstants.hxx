@@ -48,8 +48,8 @@ SHARED_CONSTU(TILE_EDGE_DOOR_SOUTH_BIT, 1 << 6)
 SHARED_CONSTU(TILE_EDGE_DOOR_WEST_BIT, 1 << 7)
 
 /* Level Constants */
-SHARED_CONST(MAX_LEVEL_WIDTH, 32)
-SHARED_CONST(MAX_LEVEL_HEIGHT, 32)
+SHARED_CONST(MAX_LEVEL_WIDTH, 1024)
+SHARED_CONST(MAX_LEVEL_HEIGHT, 1024)
 SHARED_CONST(MAX_LEVEL_TILE_COUNT, (MAX_LEVEL_WIDTH * MAX_LEVEL_HEIGHT))
 
 /* Uber2D Shader Modes */
@@ -64,9 +64,6 @@ SHARED_CONST(UBER2D_MODE_DISINTEGRATE_PLASMA, 5)
 SHARED_CONST(UBER3D_MODE_BASIC, 0)
 SHARED_CONST(UBER3D_MODE_LEVEL, 1)
 
-/* Uber3D Limits */
-SHARED_CONST(UBER3D_MODEL_COUNT, 64)
-
 /* HUD Shader Modes */
 SHARED_CONST(HUD_MODE_BORDER_DASHED, 0)
 SHARED_CONST(HUD_MODE_BUTTON, 1)
@@ -82,14 +79,18 @@ SHARED_CONST(WORLD_MAX_LAYERS, 8)
 SHARED_CONST(MAP_TILE_CELL_SIZE_PIXELS, 11)
 SHARED_CONST(MAP_TILE_EDGE_SIZE_PIXELS, 1)
 SHARED_CONST(MAP_TILE_SIZE_PIXELS, (MAP_TILE_CELL_SIZE_PIXELS + MAP_TILE_EDGE_SIZE_PIXELS))
-SHARED_CONST(MAP_MAX_WIDTH_PIXELS, (MAP_TILE_SIZE_PIXELS * MAX_LEVEL_WIDTH + MAP_TILE_EDGE_SIZE_PIXELS))
-SHARED_CONST(MAP_MAX_HEIGHT_PIXELS, (MAP_TILE_SIZE_PIXELS * MAX_LEVEL_HEIGHT + MAP_TILE_EDGE_SIZE_PIXELS))
+/* World map layers are rendered into fixed-size textures, larger levels get clipped there. */
+SHARED_CONST(MAP_LAYER_MAX_LEVEL_WIDTH, 32)
+SHARED_CONST(MAP_LAYER_MAX_LEVEL_HEIGHT, 32)
+
+SHARED_CONST(MAP_MAX_WIDTH_PIXELS, (MAP_TILE_SIZE_PIXELS * MAP_LAYER_MAX_LEVEL_WIDTH + MAP_TILE_EDGE_SIZE_PIXELS))
+SHARED_CONST(MAP_MAX_HEIGHT_PIXELS, (MAP_TILE_SIZE_PIXELS * MAP_LAYER_MAX_LEVEL_HEIGHT + MAP_TILE_EDGE_SIZE_PIXELS))
 
 SHARED_CONST(MAP_ISO_TILE_CELL_SIZE_PIXELS, 17)
 SHARED_CONST(MAP_ISO_TILE_EDGE_SIZE_PIXELS, 1)
 SHARED_CONST(MAP_ISO_TILE_SIZE_PIXELS, (MAP_ISO_TILE_CELL_SIZE_PIXELS + MAP_ISO_TILE_EDGE_SIZE_PIXELS))
-SHARED_CONST(MAP_ISO_MAX_WIDTH_PIXELS, (MAP_ISO_TILE_SIZE_PIXELS * MAX_LEVEL_WIDTH + MAP_ISO_TILE_EDGE_SIZE_PIXELS))
-SHARED_CONST(MAP_ISO_MAX_HEIGHT_PIXELS, (MAP_ISO_TILE_SIZE_PIXELS * MAX_LEVEL_HEIGHT + MAP_ISO_TILE_EDGE_SIZE_PIXELS))
+SHARED_CONST(MAP_ISO_MAX_WIDTH_PIXELS, (MAP_ISO_TILE_SIZE_PIXELS * MAP_LAYER_MAX_LEVEL_WIDTH + MAP_ISO_TILE_EDGE_SIZE_PIXELS))
+SHARED_CONST(MAP_ISO_MAX_HEIGHT_PIXELS, (MAP_ISO_TILE_SIZE_PIXELS * MAP_LAYER_MAX_LEVEL_HEIGHT + MAP_ISO_TILE_EDGE_SIZE_PIXELS))
 
 /* Map Icons */
 SHARED_CONSTU(MAP_ICON_PLAYER, 0)
@@ -16,6 +16,9 @@ struct STile
     ETileEdgeFlag EdgeFlags{};
     ETileSpecialEdgeFlag SpecialEdgeFlags{};
 
+    /* Tile arrays are read and swapped as flat uint32 arrays. */
+    static constexpr std::size_t FieldCount = 4;
+
     [[nodiscard]] static constexpr UFlagType DirectionBit(UFlagType NorthBit, SDirection Direction)
     {
         return NorthBit << Direction.Index;
@@ -227,6 +230,32 @@ struct STile
         return Tile;
     }
 
+    [[nodiscard]] bool IsEmpty() const
+    {
+        return (Flags | SpecialFlags | EdgeFlags | SpecialEdgeFlags) == 0;
+    }
+
+    /* Packed form used by .erm v2, one byte per field. */
+    [[nodiscard]] bool CanPack() const
+    {
+        return ((Flags | SpecialFlags | EdgeFlags | SpecialEdgeFlags) & ~0xFFu) == 0;
+    }
+
+    [[nodiscard]] uint32_t Pack() const
+    {
+        return Flags | (SpecialFlags << 8) | (EdgeFlags << 16) | (SpecialEdgeFlags << 24);
+    }
+
+    static STile Unpack(uint32_t Packed)
+    {
+        STile Tile;
+        Tile.Flags = Packed & 0xFF;
+        Tile.SpecialFlags = (Packed >> 8) & 0xFF;
+        Tile.EdgeFlags = (Packed >> 16) & 0xFF;
+        Tile.SpecialEdgeFlags = (Packed >> 24) & 0xFF;
+        return Tile;
+    }
+
     void Serialize(std::ofstream& Stream) const
     {
         Serialization::Write32(Stream, Flags);
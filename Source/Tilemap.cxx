@@ -2,46 +2,416 @@
 
 #include <iostream>
 #include <fstream>
+#include <algorithm>
 #include "CommonTypes.hxx"
 #include "Tile.hxx"
+#include "Log.hxx"
+#include "Memory.hxx"
 
-void STilemap::PostProcess()
+void SDirtySpans::Add(std::size_t First, std::size_t Last)
 {
-    WallJoints.reset();
-    if (!bUseWallJoints)
+    /* First span that overlaps or touches the new one, or the slot it goes into. */
+    std::size_t Begin = 0;
+    while (Begin < Count && Spans[Begin].Y + 1 < First)
     {
-        return;
+        ++Begin;
     }
-    SVec2Int Coords{};
-    for (; Coords.X < (int)Width; ++Coords.X)
+    std::size_t End = Begin;
+    while (End < Count && Spans[End].X <= Last + 1)
+    {
+        First = std::min(First, Spans[End].X);
+        Last = std::max(Last, Spans[End].Y);
+        ++End;
+    }
+
+    if (Begin == End)
+    {
+        std::copy_backward(Spans.begin() + Begin, Spans.begin() + Count, Spans.begin() + Count + 1);
+        ++Count;
+    }
+    else
+    {
+        std::copy(Spans.begin() + End, Spans.begin() + Count, Spans.begin() + Begin + 1);
+        Count -= End - Begin - 1;
+    }
+    Spans[Begin] = { First, Last };
+
+    if (Count > MaxSpans)
     {
-        for (Coords.Y = 0; Coords.Y < (int)Height; ++Coords.Y)
+        /* Give up the smallest gap. */
+        std::size_t Closest = 0;
+        for (std::size_t Index = 1; Index + 1 < Count; ++Index)
         {
-            auto CurrentTile = GetTileAtMutable(Coords);
-            if (CurrentTile == nullptr)
+            if (Spans[Index + 1].X - Spans[Index].Y < Spans[Closest + 1].X - Spans[Closest].Y)
             {
-                continue;
+                Closest = Index;
             }
-            if (CurrentTile->IsWallBasedEdge(SDirection::North()) && CurrentTile->IsWallBasedEdge(SDirection::West()))
+        }
+        Spans[Closest].Y = Spans[Closest + 1].Y;
+        std::copy(Spans.begin() + Closest + 2, Spans.begin() + Count, Spans.begin() + Closest + 1);
+        --Count;
+    }
+}
+
+std::size_t SDirtySpans::TileCount() const
+{
+    std::size_t Tiles{};
+    for (auto& Span : *this)
+    {
+        Tiles += Span.Y - Span.X + 1;
+    }
+    return Tiles;
+}
+
+const CTileChunks::SChunk CTileChunks::EmptyChunk{};
+
+CTileChunks::CTileChunks()
+    : Chunks(Memory::GetPoolResource())
+{
+}
+
+CTileChunks::CTileChunks(const CTileChunks& Other)
+    : Chunks(Memory::GetPoolResource())
+{
+    *this = Other;
+}
+
+CTileChunks::CTileChunks(CTileChunks&& Other) noexcept
+    : Chunks(std::move(Other.Chunks))
+{
+    Other.Chunks.clear();
+}
+
+CTileChunks& CTileChunks::operator=(const CTileChunks& Other)
+{
+    if (this == &Other)
+    {
+        return *this;
+    }
+    Clear();
+    Chunks.resize(Other.Chunks.size(), &EmptyChunk);
+    for (std::size_t Index = 0; Index < Other.Chunks.size(); ++Index)
+    {
+        if (Other.Chunks[Index] != &EmptyChunk)
+        {
+            auto Memory = Memory::GetPoolResource()->allocate(sizeof(SChunk), alignof(SChunk));
+            Chunks[Index] = new (Memory) SChunk(*Other.Chunks[Index]);
+        }
+    }
+    return *this;
+}
+
+CTileChunks& CTileChunks::operator=(CTileChunks&& Other) noexcept
+{
+    if (this != &Other)
+    {
+        Clear();
+        std::swap(Chunks, Other.Chunks);
+    }
+    return *this;
+}
+
+CTileChunks::~CTileChunks()
+{
+    Clear();
+}
+
+CTileChunks::SChunk* CTileChunks::FindOrAddChunk(int ChunkX, int ChunkY)
+{
+    auto Index = (std::size_t)(ChunkY * ChunksPerRow + ChunkX);
+    if (Index >= Chunks.size())
+    {
+        /* Grow by whole chunk rows, levels are rarely as wide as the maximum. */
+        Chunks.resize((std::size_t)(ChunkY + 1) * ChunksPerRow, &EmptyChunk);
+    }
+    auto& Chunk = Chunks[Index];
+    if (Chunk == &EmptyChunk)
+    {
+        Chunk = new (Memory::GetPoolResource()->allocate(sizeof(SChunk), alignof(SChunk))) SChunk{};
+    }
+    /* Everything but EmptyChunk was allocated here as mutable. */
+    return const_cast<SChunk*>(Chunk);
+}
+
+void CTileChunks::Set(int X, int Y, const STile& Tile)
+{
+    auto Index = (std::size_t)((Y >> ChunkShift) * ChunksPerRow + (X >> ChunkShift));
+    if (Tile.IsEmpty() && (Index >= Chunks.size() || Chunks[Index] == &EmptyChunk))
+    {
+        return;
+    }
+    GetMutable(X, Y) = Tile;
+}
+
+void CTileChunks::Clear()
+{
+    for (auto Chunk : Chunks)
+    {
+        if (Chunk != &EmptyChunk)
+        {
+            Chunk->~SChunk();
+            Memory::GetPoolResource()->deallocate(const_cast<SChunk*>(Chunk), sizeof(SChunk), alignof(SChunk));
+        }
+    }
+    Chunks.clear();
+}
+
+std::size_t CTileChunks::ChunkCount() const
+{
+    return (std::size_t)std::count_if(Chunks.begin(), Chunks.end(), [](const SChunk* Chunk) { return Chunk != &EmptyChunk; });
+}
+
+static_assert(64 % CTileChunks::ChunkSize == 0, "Chunk rows must not straddle plane words.");
+
+void STileBitplanes::Build(const STilemap& Tilemap)
+{
+    Width = Tilemap.Width;
+    Height = Tilemap.Height;
+    WordsPerRow = ((std::size_t)Width + 63) / 64;
+    Words.assign(WordsPerRow * Height * ETileBitplane::Count, 0);
+
+    /* Missing chunks hold empty tiles, which are already zero in every plane. */
+    for (int ChunkY = 0; ChunkY * CTileChunks::ChunkSize < Height; ++ChunkY)
+    {
+        for (int ChunkX = 0; ChunkX * CTileChunks::ChunkSize < Width; ++ChunkX)
+        {
+            auto Chunk = Tilemap.Tiles.FindChunk(ChunkX, ChunkY);
+            if (!Tilemap.Tiles.HasChunk(ChunkX, ChunkY))
             {
-                SetWallJoint(Coords);
+                continue;
             }
-            if (CurrentTile->IsWallBasedEdge(SDirection::North()) && CurrentTile->IsWallBasedEdge(SDirection::East()))
+            /* A chunk row is 16 tiles inside a single word, so gather the row per plane and store it once. */
+            auto MaxX = std::min((ChunkX + 1) * CTileChunks::ChunkSize, (int)Width);
+            auto MaxY = std::min((ChunkY + 1) * CTileChunks::ChunkSize, (int)Height);
+            auto MinX = ChunkX * CTileChunks::ChunkSize;
+            for (auto Y = ChunkY * CTileChunks::ChunkSize; Y < MaxY; ++Y)
             {
-                SetWallJoint({ Coords.X + 1, Coords.Y });
+                std::array<uint64_t, ETileBitplane::Count> Masks{};
+                for (auto X = MinX; X < MaxX; ++X)
+                {
+                    for (auto Key = TileKey(Chunk->Tiles[CTileChunks::TileIndexInChunk(X, Y)]); Key != 0; Key &= Key - 1)
+                    {
+                        Masks[__builtin_ctz(Key)] |= uint64_t(1) << (X - MinX);
+                    }
+                }
+                for (ETileBitplane::Type Plane = 0; Plane < ETileBitplane::Count; ++Plane)
+                {
+                    RowMutable(Plane, Y)[MinX / 64] |= Masks[Plane] << (MinX % 64);
+                }
             }
-            if (CurrentTile->IsWallBasedEdge(SDirection::South()) && CurrentTile->IsWallBasedEdge(SDirection::East()))
+        }
+    }
+}
+
+bool STileBitplanes::IsBuiltFor(const STilemap& Tilemap) const
+{
+    return Width == Tilemap.Width && Height == Tilemap.Height && Words.size() == WordsPerRow * Height * ETileBitplane::Count;
+}
+
+void STileBitplanes::Refresh(const STilemap& Tilemap, const SRectInt& Rect)
+{
+    auto MinX = std::max(Rect.Min.X, 0);
+    auto MinY = std::max(Rect.Min.Y, 0);
+    auto MaxX = std::min(Rect.Max.X, (int)Width - 1);
+    auto MaxY = std::min(Rect.Max.Y, (int)Height - 1);
+    for (auto Y = MinY; Y <= MaxY; ++Y)
+    {
+        for (auto X = MinX; X <= MaxX; ++X)
+        {
+            StoreKey(X, Y, TileKey(Tilemap.Tiles.Get(X, Y)));
+        }
+    }
+}
+
+void STileBitplanes::StoreKey(int X, int Y, uint32_t Key)
+{
+    auto WordIndex = (std::size_t)(X / 64);
+    auto Bit = uint64_t(1) << (X % 64);
+    for (ETileBitplane::Type Plane = 0; Plane < ETileBitplane::Count; ++Plane)
+    {
+        auto& Word = RowMutable(Plane, Y)[WordIndex];
+        Word = (Word & ~Bit) | (((Key >> Plane) & 1) ? Bit : 0);
+    }
+}
+
+void STilemap::PostProcess()
+{
+    Bitplanes.Build(*this);
+    Adjacency.assign(TileCount(), 0);
+    UpdateAdjacency(0, Height - 1, 0, Width - 1);
+    WallJoints.assign(WallJointWordsPerRow() * (Height + 1), 0);
+    if (!bUseWallJoints)
+    {
+        return;
+    }
+    UpdateWallJoints(0, Height, 0, Width);
+}
+
+void STilemap::PostProcessRegion(const SRectInt& Rect)
+{
+    if (!Bitplanes.IsBuiltFor(*this) || Adjacency.size() != TileCount() || WallJoints.size() != WallJointWordsPerRow() * (Height + 1))
+    {
+        PostProcess();
+        return;
+    }
+    auto Min = SVec2Int{ std::max(Rect.Min.X - 1, 0), std::max(Rect.Min.Y - 1, 0) };
+    auto Max = SVec2Int{ std::min(Rect.Max.X + 1, Width - 1), std::min(Rect.Max.Y + 1, Height - 1) };
+    if (Min.X > Max.X || Min.Y > Max.Y)
+    {
+        return;
+    }
+    Bitplanes.Refresh(*this, SRectInt{ Min, Max });
+    /* Flags only change inside Rect, so adjacency outside Min..Max still sees the same neighbors. */
+    UpdateAdjacency(Min.Y, Max.Y, Min.X, Max.X);
+    if (!bUseWallJoints)
+    {
+        return;
+    }
+    /* Tile (X, Y) owns the corners at joints X..X + 1 on joint rows Y..Y + 1. */
+    UpdateWallJoints(Min.Y, Max.Y + 1, Min.X, Max.X + 1);
+}
+
+/* Spreads the low 16 bits of Value four bits apart, bit N lands on bit 4 * N. */
+static uint64_t SpreadBits4(uint64_t Value)
+{
+    Value &= 0xFFFF;
+    Value = (Value | Value << 24) & 0x000000FF000000FFull;
+    Value = (Value | Value << 12) & 0x000F000F000F000Full;
+    Value = (Value | Value << 6) & 0x0303030303030303ull;
+    return (Value | Value << 3) & 0x1111111111111111ull;
+}
+
+static_assert(ETileAdjacency::PassableNorth == 1 << 4 && ETileAdjacency::DoorNorth == 1 << 8 && ETileAdjacency::Walkable == 1 << 12 &&
+    ETileAdjacency::Hole == 1 << 13, "UpdateAdjacency builds adjacency bits in this order.");
+
+void STilemap::UpdateAdjacency(int MinY, int MaxY, int MinX, int MaxX)
+{
+    if (MinX > MaxX || MinY > MaxY)
+    {
+        return;
+    }
+    auto WordsPerRow = Bitplanes.WordsPerRow;
+    auto Walkable = [&](int Y, std::size_t Word) -> uint64_t {
+        if (Y < 0 || Y >= Height || Word >= WordsPerRow)
+        {
+            return 0;
+        }
+        return Bitplanes.Row(ETileBitplane::Floor, Y)[Word] | Bitplanes.Row(ETileBitplane::Hole, Y)[Word];
+    };
+
+    for (auto Y = MinY; Y <= MaxY; ++Y)
+    {
+        for (auto Word = (std::size_t)MinX / 64; Word <= (std::size_t)MaxX / 64; ++Word)
+        {
+            auto Current = Walkable(Y, Word);
+            /* Bit X tells whether the neighbor of tile X in that direction is walkable. */
+            std::array<uint64_t, SDirection::Count> NeighborWalkable{
+                Walkable(Y - 1, Word),
+                Current >> 1 | Walkable(Y, Word + 1) << 63,
+                Walkable(Y + 1, Word),
+                Current << 1 | (Word > 0 ? Walkable(Y, Word - 1) >> 63 : 0)
+            };
+
+            std::array<uint64_t, SDirection::Count> Open{};
+            std::array<uint64_t, SDirection::Count> Passable{};
+            std::array<uint64_t, SDirection::Count> Door{};
+            for (auto& Direction : SDirection::All())
             {
-                SetWallJoint({ Coords.X + 1, Coords.Y + 1 });
+                Open[Direction.Index] = ~Bitplanes.Row(ETileBitplane::Wall(Direction), Y)[Word];
+                Passable[Direction.Index] = Open[Direction.Index] & NeighborWalkable[Direction.Index];
+                Door[Direction.Index] = Bitplanes.Row(ETileBitplane::Door(Direction), Y)[Word];
             }
-            if (CurrentTile->IsWallBasedEdge(SDirection::South()) && CurrentTile->IsWallBasedEdge(SDirection::West()))
+            auto Hole = Bitplanes.Row(ETileBitplane::Hole, Y)[Word];
+
+            auto Low = std::max(MinX - (int)Word * 64, 0);
+            auto High = std::min(MaxX - (int)Word * 64, 63);
+            for (auto Group = Low / 16; Group <= High / 16; ++Group)
             {
-                SetWallJoint({ Coords.X, Coords.Y + 1 });
+                /* 16 tiles at a time, a nibble per tile: one bit per direction, or walkable and hole. */
+                auto Shift = Group * 16;
+                auto Nibbles = [&](const std::array<uint64_t, SDirection::Count>& Words) {
+                    return SpreadBits4(Words[0] >> Shift) | SpreadBits4(Words[1] >> Shift) << 1 |
+                        SpreadBits4(Words[2] >> Shift) << 2 | SpreadBits4(Words[3] >> Shift) << 3;
+                };
+                auto OpenNibbles = Nibbles(Open);
+                auto PassableNibbles = Nibbles(Passable);
+                auto DoorNibbles = Nibbles(Door);
+                auto TileNibbles = SpreadBits4(Current >> Shift) | SpreadBits4(Hole >> Shift) << 1;
+
+                auto First = std::max(Low, Shift);
+                auto Last = std::min(High, Shift + 15);
+                auto Index = CoordsToIndex((int)Word * 64 + First, Y);
+                for (auto Bit = First; Bit <= Last; ++Bit, ++Index)
+                {
+                    auto NibbleShift = (Bit - Shift) * 4;
+                    Adjacency[Index] = (ETileAdjacency::Type)(((OpenNibbles >> NibbleShift) & 0xF) |
+                        ((PassableNibbles >> NibbleShift) & 0xF) << 4 |
+                        ((DoorNibbles >> NibbleShift) & 0xF) << 8 |
+                        ((TileNibbles >> NibbleShift) & 0x3) << 12);
+                }
             }
         }
     }
 }
 
+void STilemap::UpdateWallJoints(int MinY, int MaxY, int MinX, int MaxX)
+{
+    auto TileWords = Bitplanes.WordsPerRow;
+    auto JointWords = WallJointWordsPerRow();
+
+    /* Joint (X, Y) is a wall-based corner of one of the four tiles around it: north-west of tile (X, Y), north-east of (X - 1, Y),
+     * south-west of (X, Y - 1) or south-east of (X - 1, Y - 1). Returns the corners landing on column X and on column X + 1. */
+    auto Corners = [&](int Y, std::size_t Word, uint64_t& AtX, uint64_t& AtNextX) {
+        AtX = 0;
+        AtNextX = 0;
+        if (Word >= TileWords)
+        {
+            return;
+        }
+        auto WallBased = [&](SDirection Direction, int TileY) {
+            return Bitplanes.Row(ETileBitplane::Wall(Direction), TileY)[Word] | Bitplanes.Row(ETileBitplane::Door(Direction), TileY)[Word];
+        };
+        if (Y < Height)
+        {
+            auto North = WallBased(SDirection::North(), Y);
+            AtX |= North & WallBased(SDirection::West(), Y);
+            AtNextX |= North & WallBased(SDirection::East(), Y);
+        }
+        if (Y > 0)
+        {
+            auto South = WallBased(SDirection::South(), Y - 1);
+            AtX |= South & WallBased(SDirection::West(), Y - 1);
+            AtNextX |= South & WallBased(SDirection::East(), Y - 1);
+        }
+    };
+
+    auto FirstWord = (std::size_t)MinX / 64;
+    auto LastWord = std::min((std::size_t)MaxX / 64, JointWords - 1);
+    for (auto Y = MinY; Y <= MaxY; ++Y)
+    {
+        auto Row = &WallJoints[Y * JointWords];
+        uint64_t AtX{};
+        uint64_t AtNextX{};
+        uint64_t Carry{};
+        if (FirstWord > 0)
+        {
+            Corners(Y, FirstWord - 1, AtX, AtNextX);
+            Carry = AtNextX >> 63;
+        }
+        for (auto Word = FirstWord; Word <= LastWord; ++Word)
+        {
+            Corners(Y, Word, AtX, AtNextX);
+            auto Joints = AtX | AtNextX << 1 | Carry;
+            Carry = AtNextX >> 63;
+
+            auto Low = std::max(MinX - (int)Word * 64, 0);
+            auto High = std::min(MaxX - (int)Word * 64, 63);
+            auto Mask = (UINT64_MAX >> (63 - High)) & (UINT64_MAX << Low);
+            Row[Word] = (Row[Word] & ~Mask) | (Joints & Mask);
+        }
+    }
+}
+
 void STilemap::ToggleEdge(const SVec2Int& Coords, SDirection Direction, UFlagType NorthEdgeBit)
 {
     auto Tile = GetTileAtMutable(Coords);
@@ -54,13 +424,13 @@ void STilemap::ToggleEdge(const SVec2Int& Coords, SDirection Direction, UFlagTyp
     EdgeFlags = EdgeFlags ^ STile::DirectionBit(NorthEdgeBit, Direction);
 
     auto NeighborTile = GetNeighborTileAtMutable(Coords, Direction);
-    if (NeighborTile == nullptr)
+    if (NeighborTile != nullptr)
     {
-        return;
+        auto& NeighborEdgeFlags = NeighborTile->EdgeFlags;
+        NeighborEdgeFlags = NeighborEdgeFlags ^ STile::DirectionBit(NorthEdgeBit, Direction.Inverted());
     }
 
-    auto& NeighborEdgeFlags = NeighborTile->EdgeFlags;
-    NeighborEdgeFlags = NeighborEdgeFlags ^ STile::DirectionBit(NorthEdgeBit, Direction.Inverted());
+    PostProcessRegion(SRectInt{ Coords, Coords });
 }
 
 void STilemap::Edit(const SVec2Int& Coords, ETileFlag Flag, bool bHandleEdges)
@@ -72,90 +442,568 @@ void STilemap::Edit(const SVec2Int& Coords, ETileFlag Flag, bool bHandleEdges)
     auto Tile = GetTileAtMutable(Coords);
     Tile->Flags = Flag;
 
-    if (!bHandleEdges)
+    if (bHandleEdges)
     {
-        return;
+        for (auto& Direction : SDirection::All())
+        {
+            UpdateEdge(*Tile, GetTileAtMutable(Coords + Direction.GetVector<int>()), Direction, Flag);
+        }
     }
 
-    for (auto& Direction : SDirection::All())
+    PostProcessRegion(SRectInt{ Coords, Coords });
+}
+
+void STilemap::UpdateEdge(STile& Tile, STile* NeighborTile, SDirection Direction, ETileFlag Flag)
+{
+    if (NeighborTile != nullptr)
+    {
+        auto NeighborDirection = Direction.Inverted();
+
+        /* Clear edges if:
+         * a) Neighbor is of the same type.
+         * b) Both tiles are empty.
+         * c) Both tiles are not empty and are different.
+         * Otherwise set walls if:
+         * a) Both tiles are not floor-based (walkable) */
+        if (NeighborTile->CheckFlag(Flag) || (NeighborTile->Flags == 0 && Flag == 0))
+        {
+            Tile.ClearEdgeFlags(Direction);
+            NeighborTile->ClearEdgeFlags(NeighborDirection);
+        }
+        else if (!(Tile.IsWalkable() && NeighborTile->IsWalkable()))
+        {
+            Tile.SetWall(Direction);
+            NeighborTile->SetWall(NeighborDirection);
+        }
+    }
+    else
     {
-        auto NeighborTile = GetTileAtMutable(Coords + Direction.GetVector<int>());
-        if (NeighborTile != nullptr)
+        /* No valid neighbor tile; Clear edges if new type is empty. */
+        if (Flag == 0)
+        {
+            Tile.ClearEdgeFlags(Direction);
+        }
+        else
         {
-            auto NeighborDirection = Direction.Inverted();
+            Tile.SetWall(Direction);
+        }
+    }
+}
 
-            /* Clear edges if:
-             * a) Neighbor is of the same type.
-             * b) Both tiles are empty.
-             * c) Both tiles are not empty and are different.
-             * Otherwise set walls if:
-             * a) Both tiles are not floor-based (walkable) */
-            if (NeighborTile->CheckFlag(Flag) || (NeighborTile->Flags == 0 && Flag == 0))
-            {
-                Tile->ClearEdgeFlags(Direction);
-                NeighborTile->ClearEdgeFlags(NeighborDirection);
-            }
-            else if (!(Tile->IsWalkable() && NeighborTile->IsWalkable()))
+std::pmr::vector<SVec2Size> STilemap::EditBlock(const SRectInt& Rect, ETileFlag Flag)
+{
+    auto DirtyRanges = Memory::GetFrameVector<SVec2Size>();
+    auto Min = SVec2Int{ std::max(Rect.Min.X, 0), std::max(Rect.Min.Y, 0) };
+    auto Max = SVec2Int{ std::min(Rect.Max.X, Width - 1), std::min(Rect.Max.Y, Height - 1) };
+    if (Min.X > Max.X || Min.Y > Max.Y)
+    {
+        return DirtyRanges;
+    }
+
+    /* Editing tile by tile, whichever tile of an inner pair goes last sees a neighbor of its own type and clears the shared edge.
+     * So inner edges are simply cleared, and only edges facing outside the block need the neighbor rules. */
+    for (auto Y = Min.Y; Y <= Max.Y; ++Y)
+    {
+        for (auto X = Min.X; X <= Max.X; ++X)
+        {
+            auto& Tile = Tiles.GetMutable(X, Y);
+            Tile.Flags = Flag;
+            for (auto& Direction : SDirection::All())
             {
-                Tile->SetWall(Direction);
-                NeighborTile->SetWall(NeighborDirection);
+                auto NeighborCoords = SVec2Int{ X, Y } + Direction.GetVector<int>();
+                if (NeighborCoords.X >= Min.X && NeighborCoords.X <= Max.X && NeighborCoords.Y >= Min.Y && NeighborCoords.Y <= Max.Y)
+                {
+                    Tile.ClearEdgeFlags(Direction);
+                }
+                else
+                {
+                    UpdateEdge(Tile, GetTileAtMutable(NeighborCoords), Direction, Flag);
+                }
             }
         }
+    }
+
+    PostProcessRegion(SRectInt{ Min, Max });
+
+    /* The block plus the neighbors sharing an edge with it, one range per row, merged where rows run into each other. */
+    auto AddRange = [&](int Y, int MinX, int MaxX) {
+        auto First = CoordsToIndex(MinX, Y);
+        auto Last = CoordsToIndex(MaxX, Y);
+        if (!DirtyRanges.empty() && DirtyRanges.back().Y + 1 == First)
+        {
+            DirtyRanges.back().Y = Last;
+        }
         else
         {
-            /* No valid neighbor tile; Clear edges if new type is empty. */
-            if (Flag == 0)
-            {
-                Tile->ClearEdgeFlags(Direction);
-            }
-            else
+            DirtyRanges.push_back({ First, Last });
+        }
+    };
+    if (Min.Y > 0)
+    {
+        AddRange(Min.Y - 1, Min.X, Max.X);
+    }
+    for (auto Y = Min.Y; Y <= Max.Y; ++Y)
+    {
+        AddRange(Y, std::max(Min.X - 1, 0), std::min(Max.X + 1, Width - 1));
+    }
+    if (Max.Y + 1 < Height)
+    {
+        AddRange(Max.Y + 1, Min.X, Max.X);
+    }
+    return DirtyRanges;
+}
+
+void STilemap::EncodeTiles(std::size_t First, std::size_t Count, ETilemapEncoding::Type Encoding, std::pmr::vector<uint8_t>& Payload) const
+{
+    /* Fixed-width payloads are built in host order and converted to big-endian in a single pass. */
+    auto Values = Memory::GetFrameVector<uint32_t>();
+    if (Encoding == ETilemapEncoding::Packed)
+    {
+        Values.resize(Count);
+        ForEachTile(First, Count, [&](std::size_t Index, const STile& Tile) { Values[Index - First] = Tile.Pack(); });
+    }
+    else
+    {
+        Values.resize(Count * STile::FieldCount);
+        ForEachTile(First, Count, [&](std::size_t Index, const STile& Tile) {
+            std::memcpy(&Values[(Index - First) * STile::FieldCount], &Tile, sizeof(STile));
+        });
+    }
+    Serialization::HtoBEInPlace32(Values.data(), Values.size());
+
+    auto Bytes = reinterpret_cast<const uint8_t*>(Values.data());
+    Payload.assign(Bytes, Bytes + Values.size() * sizeof(uint32_t));
+}
+
+bool STilemap::CanPackRange(std::size_t First, std::size_t Count) const
+{
+    bool bCanPack = true;
+    ForEachTile(First, Count, [&](std::size_t, const STile& Tile) { bCanPack &= Tile.CanPack(); });
+    return bCanPack;
+}
+
+void STilemap::Serialize(std::ofstream& Stream, bool bFixedLayout) const
+{
+    auto TileCount = this->TileCount();
+    bool bCanPack = CanPackRange(0, TileCount);
+
+    auto TilesPayload = Memory::GetVector<uint8_t>();
+    auto TilesEncoding = bCanPack ? ETilemapEncoding::Packed : ETilemapEncoding::Wide;
+
+    if (bCanPack && !bFixedLayout)
+    {
+        auto Packed = Memory::GetFrameVector<uint32_t>();
+        Packed.resize(TileCount);
+        ForEachTile(0, TileCount, [&](std::size_t Index, const STile& Tile) { Packed[Index] = Tile.Pack(); });
+
+        auto PackedRLE = Memory::GetVector<uint8_t>();
+        for (std::size_t Index = 0; Index < TileCount;)
+        {
+            auto Value = Packed[Index];
+            std::size_t RunEnd = Index + 1;
+            while (RunEnd < TileCount && RunEnd - Index < UINT16_MAX && Packed[RunEnd] == Value)
             {
-                Tile->SetWall(Direction);
+                RunEnd++;
             }
+            Serialization::Append16(PackedRLE, (uint16_t)(RunEnd - Index));
+            Serialization::Append32(PackedRLE, Value);
+            Index = RunEnd;
+        }
+
+        if (PackedRLE.size() < TileCount * sizeof(uint32_t))
+        {
+            TilesEncoding = ETilemapEncoding::PackedRLE;
+            TilesPayload = std::move(PackedRLE);
         }
     }
+
+    if (TilesEncoding != ETilemapEncoding::PackedRLE)
+    {
+        EncodeTiles(0, TileCount, TilesEncoding, TilesPayload);
+    }
+
+    auto PropertiesPayload = Memory::GetVector<uint8_t>();
+    Serialization::Append32(PropertiesPayload, bUseWallJoints);
+
+    static constexpr uint32_t SectionCount = 2;
+    auto TilesOffset = ETilemapFormat::HeaderSize + SectionCount * ETilemapFormat::SectionEntrySize;
+    auto PropertiesOffset = TilesOffset + (uint32_t)TilesPayload.size();
+
+    Serialization::Write32(Stream, ETilemapFormat::Magic);
+    Serialization::Write32(Stream, ETilemapFormat::Version);
+    Serialization::Write32(Stream, Width);
+    Serialization::Write32(Stream, Height);
+    Serialization::Write32(Stream, SectionCount);
+
+    Serialization::Write32(Stream, ETilemapSection::Tiles);
+    Serialization::Write32(Stream, TilesEncoding);
+    Serialization::Write32(Stream, TilesOffset);
+    Serialization::Write32(Stream, (uint32_t)TilesPayload.size());
+
+    Serialization::Write32(Stream, ETilemapSection::Properties);
+    Serialization::Write32(Stream, 0);
+    Serialization::Write32(Stream, PropertiesOffset);
+    Serialization::Write32(Stream, (uint32_t)PropertiesPayload.size());
+
+    Stream.write(reinterpret_cast<const char*>(TilesPayload.data()), (std::streamsize)TilesPayload.size());
+    Stream.write(reinterpret_cast<const char*>(PropertiesPayload.data()), (std::streamsize)PropertiesPayload.size());
 }
 
-void STilemap::EditBlock(const SRectInt& Rect, ETileFlag Flag)
+bool STilemap::ReadFileLayout(Serialization::SpanReader& Reader, STilemapFileLayout& Layout)
 {
-    if (Rect.Min == Rect.Max)
+    auto Start = Reader.Position;
+
+    uint32_t Magic{};
+    uint32_t Version{};
+    uint32_t SectionCount{};
+    Reader.Read32(Magic);
+    Reader.Read32(Version);
+    Reader.Read32(Layout.Width);
+    Reader.Read32(Layout.Height);
+    Reader.Read32(SectionCount);
+    if (Reader.Failed() || Magic != ETilemapFormat::Magic || Version > ETilemapFormat::Version || SectionCount > ETilemapFormat::MaxSectionCount)
     {
-        Edit(Rect.Max, Flag);
+        return false;
     }
 
-    for (auto X = Rect.Min.X; X <= Rect.Max.X; ++X)
+    bool bHasTiles = false;
+    bool bHasProperties = false;
+    for (uint32_t Index = 0; Index < SectionCount; ++Index)
     {
-        for (auto Y = Rect.Min.Y; Y <= Rect.Max.Y; ++Y)
+        uint32_t Type{};
+        uint32_t Encoding{};
+        uint32_t Offset{};
+        uint32_t Length{};
+        Reader.Read32(Type);
+        Reader.Read32(Encoding);
+        Reader.Read32(Offset);
+        Reader.Read32(Length);
+        if (Reader.Failed() || Start + Offset + Length > Reader.Length)
+        {
+            return false;
+        }
+
+        if (Type == ETilemapSection::Tiles)
+        {
+            Layout.TilesEncoding = Encoding;
+            Layout.TilesOffset = Offset;
+            Layout.TilesLength = Length;
+            bHasTiles = true;
+        }
+        else if (Type == ETilemapSection::Properties)
         {
-            Edit({ X, Y }, Flag);
+            Layout.PropertiesOffset = Offset;
+            Layout.PropertiesLength = Length;
+            bHasProperties = true;
         }
     }
+
+    return bHasTiles && bHasProperties;
 }
 
-void STilemap::Serialize(std::ofstream& Stream) const
+bool STilemap::CanPatch(const STilemapFileLayout& Layout, const SDirtySpans& Spans) const
 {
-    Serialization::Write32(Stream, Width);
-    Serialization::Write32(Stream, Height);
+    if (Layout.Width != Width || Layout.Height != Height || Layout.PropertiesLength != sizeof(uint32_t))
+    {
+        return false;
+    }
+    for (auto& Span : Spans)
+    {
+        if (Span.X > Span.Y || Span.Y >= TileCount())
+        {
+            return false;
+        }
+        switch (Layout.TilesEncoding)
+        {
+            case ETilemapEncoding::Packed:
+                if (Layout.TilesLength != TileCount() * sizeof(uint32_t) || !CanPackRange(Span.X, Span.Y - Span.X + 1))
+                {
+                    return false;
+                }
+                break;
+            case ETilemapEncoding::Wide:
+                if (Layout.TilesLength != TileCount() * sizeof(STile))
+                {
+                    return false;
+                }
+                break;
+            default:
+                /* RLE runs move around when tiles change. */
+                return false;
+        }
+    }
+    return true;
+}
+
+static uint32_t JournalChecksum(const uint8_t* Data, std::size_t Length)
+{
+    /* FNV-1a, only there to catch a journal that didn't fully reach the disk. */
+    uint32_t Hash = 2166136261u;
+    for (std::size_t Index = 0; Index < Length; ++Index)
+    {
+        Hash = (Hash ^ Data[Index]) * 16777619u;
+    }
+    return Hash;
+}
+
+void STilemap::SerializePatch(std::pmr::vector<uint8_t>& Journal, const STilemapFileLayout& Layout, const SDirtySpans& Spans) const
+{
+    auto Stride = Layout.TilesEncoding == ETilemapEncoding::Packed ? sizeof(uint32_t) : sizeof(STile);
+    auto RecordsStart = Journal.size();
+
+    auto TilesPayload = Memory::GetFrameVector<uint8_t>();
+    for (auto& Span : Spans)
+    {
+        TilesPayload.clear();
+        EncodeTiles(Span.X, Span.Y - Span.X + 1, Layout.TilesEncoding, TilesPayload);
+        Serialization::Append32(Journal, (uint32_t)(Layout.TilesOffset + Span.X * Stride));
+        Serialization::Append32(Journal, (uint32_t)TilesPayload.size());
+        Journal.insert(Journal.end(), TilesPayload.begin(), TilesPayload.end());
+    }
+
+    Serialization::Append32(Journal, Layout.PropertiesOffset);
+    Serialization::Append32(Journal, sizeof(uint32_t));
+    Serialization::Append32(Journal, bUseWallJoints);
+
+    auto RecordsLength = Journal.size() - RecordsStart;
+    auto Checksum = JournalChecksum(Journal.data() + RecordsStart, RecordsLength);
+    Serialization::Append32(Journal, ETilemapFormat::JournalMagic);
+    Serialization::Append32(Journal, (uint32_t)RecordsLength);
+    Serialization::Append32(Journal, Checksum);
+}
+
+bool STilemap::IsPatchJournalSealed(const uint8_t* Data, std::size_t Length)
+{
+    if (Length < ETilemapFormat::JournalSealSize)
+    {
+        return false;
+    }
+    auto RecordsLength = Length - ETilemapFormat::JournalSealSize;
+    Serialization::SpanReader Seal(Data + RecordsLength, ETilemapFormat::JournalSealSize);
+    uint32_t Magic{};
+    uint32_t SealedLength{};
+    uint32_t Checksum{};
+    Seal.Read32(Magic);
+    Seal.Read32(SealedLength);
+    Seal.Read32(Checksum);
+    return Magic == ETilemapFormat::JournalMagic && SealedLength == RecordsLength && Checksum == JournalChecksum(Data, RecordsLength);
+}
+
+bool STilemap::ApplyPatchJournal(const uint8_t* Data, std::size_t Length, std::ostream& Stream)
+{
+    if (!IsPatchJournalSealed(Data, Length))
+    {
+        return false;
+    }
+
+    Serialization::SpanReader Reader(Data, Length - ETilemapFormat::JournalSealSize);
+    while (Reader.Remaining() > 0)
+    {
+        uint32_t Offset{};
+        uint32_t RecordLength{};
+        Reader.Read32(Offset);
+        Reader.Read32(RecordLength);
+        auto Bytes = Reader.ReadBytes(RecordLength);
+        if (Bytes == nullptr)
+        {
+            return false;
+        }
+        Stream.seekp(Offset);
+        Stream.write(reinterpret_cast<const char*>(Bytes), RecordLength);
+    }
+    return !Stream.fail();
+}
+
+bool STilemap::Deserialize(std::istream& Stream)
+{
+    auto Contents = Memory::GetFrameVector<uint8_t>();
+    std::array<char, 4096> Chunk{};
+    while (Stream.read(Chunk.data(), Chunk.size()) || Stream.gcount() > 0)
+    {
+        Contents.insert(Contents.end(), Chunk.begin(), Chunk.begin() + Stream.gcount());
+    }
+
+    Serialization::SpanReader Reader(Contents.data(), Contents.size());
+    return Deserialize(Reader);
+}
+
+bool STilemap::Deserialize(Serialization::SpanReader& Reader)
+{
+    STilemap Loaded;
+    if (!Loaded.DeserializeInPlace(Reader))
+    {
+        return false;
+    }
+    *this = std::move(Loaded);
+    return true;
+}
+
+bool STilemap::DeserializeInPlace(Serialization::SpanReader& Reader)
+{
+    auto Start = Reader.Position;
+
+    uint32_t Magic{};
+    Reader.Read32(Magic);
+    if (Magic != ETilemapFormat::Magic)
+    {
+        /* Legacy files start with the width instead. */
+        Width = (int32_t)Magic;
+        return DeserializeLegacy(Reader);
+    }
+
+    uint32_t Version{};
+    int32_t NewWidth{};
+    int32_t NewHeight{};
+    uint32_t SectionCount{};
+    Reader.Read32(Version);
+    Reader.Read32(NewWidth);
+    Reader.Read32(NewHeight);
+    Reader.Read32(SectionCount);
 
-    for (auto& Tile : Tiles)
+    if (Reader.Failed() || Version > ETilemapFormat::Version || SectionCount > ETilemapFormat::MaxSectionCount ||
+        NewWidth < 0 || NewWidth > MAX_LEVEL_WIDTH || NewHeight < 0 || NewHeight > MAX_LEVEL_HEIGHT)
     {
-        Tile.Serialize(Stream);
+        Log::Game<ELogLevel::Critical>("Unsupported or corrupted tilemap header (version %u, %dx%d)", Version, NewWidth, NewHeight);
+        return false;
     }
 
-    Serialization::Write32(Stream, bUseWallJoints);
+    Width = NewWidth;
+    Height = NewHeight;
+    Tiles.Clear();
+    bUseWallJoints = true;
+
+    for (uint32_t Index = 0; Index < SectionCount; ++Index)
+    {
+        uint32_t Type{};
+        uint32_t Encoding{};
+        uint32_t Offset{};
+        uint32_t Length{};
+        Reader.Read32(Type);
+        Reader.Read32(Encoding);
+        Reader.Read32(Offset);
+        Reader.Read32(Length);
+
+        /* Payloads are decoded in place, the reader only hands out a bounds-checked view. */
+        auto EntryEnd = Reader.Position;
+        const uint8_t* Payload = Reader.Seek(Start + Offset) ? Reader.ReadBytes(Length) : nullptr;
+        if (Payload == nullptr)
+        {
+            Log::Game<ELogLevel::Critical>("Truncated tilemap section %u", Type);
+            return false;
+        }
+        Reader.Seek(EntryEnd);
+
+        bool bSuccess = true;
+        switch (Type)
+        {
+            case ETilemapSection::Tiles:
+                bSuccess = DecodeTiles(Payload, Length, Encoding);
+                break;
+            case ETilemapSection::Properties:
+                bSuccess = DecodeProperties(Payload, Length);
+                break;
+            default:
+                /* Unknown sections are skipped for forward compatibility. */
+                break;
+        }
+        if (!bSuccess)
+        {
+            Log::Game<ELogLevel::Critical>("Corrupted tilemap section %u", Type);
+            return false;
+        }
+    }
+
+    PostProcess();
+
+    return true;
 }
 
-void STilemap::Deserialize(std::istream& Stream)
+bool STilemap::DecodeTiles(const uint8_t* Data, std::size_t Length, ETilemapEncoding::Type Encoding)
 {
-    Serialization::Read32(Stream, Width);
-    Serialization::Read32(Stream, Height);
+    auto TileCount = this->TileCount();
+    switch (Encoding)
+    {
+        case ETilemapEncoding::Packed:
+        {
+            if (Length != TileCount * sizeof(uint32_t))
+            {
+                return false;
+            }
+            auto Packed = Memory::GetFrameVector<uint32_t>();
+            Packed.resize(TileCount);
+            std::memcpy(Packed.data(), Data, Length);
+            Serialization::HtoBEInPlace32(Packed.data(), Packed.size());
+            SetTiles(0, TileCount, [&](std::size_t Index) { return STile::Unpack(Packed[Index]); });
+            return true;
+        }
+        case ETilemapEncoding::PackedRLE:
+        {
+            static constexpr std::size_t RunSize = sizeof(uint16_t) + sizeof(uint32_t);
+            std::size_t Index = 0;
+            for (std::size_t Offset = 0; Offset + RunSize <= Length; Offset += RunSize)
+            {
+                auto RunLength = Serialization::Load16(Data + Offset);
+                auto Tile = STile::Unpack(Serialization::Load32(Data + Offset + sizeof(uint16_t)));
+                if (Index + RunLength > TileCount)
+                {
+                    return false;
+                }
+                SetTiles(Index, RunLength, [&](std::size_t) { return Tile; });
+                Index += RunLength;
+            }
+            return Index == TileCount && Length % RunSize == 0;
+        }
+        case ETilemapEncoding::Wide:
+        {
+            if (Length != TileCount * sizeof(STile))
+            {
+                return false;
+            }
+            /* STile is four plain uint32 fields, so the whole array is swapped in one pass. */
+            auto Wide = Memory::GetFrameVector<STile>();
+            Wide.resize(TileCount);
+            std::memcpy(Wide.data(), Data, Length);
+            Serialization::HtoBEInPlace32(reinterpret_cast<uint32_t*>(Wide.data()), TileCount * STile::FieldCount);
+            SetTiles(0, TileCount, [&](std::size_t Index) { return Wide[Index]; });
+            return true;
+        }
+        default:
+            return false;
+    }
+}
 
-    for (auto& Tile : Tiles)
+bool STilemap::DecodeProperties(const uint8_t* Data, std::size_t Length)
+{
+    if (Length < sizeof(uint32_t))
+    {
+        return false;
+    }
+    bUseWallJoints = Serialization::Load32(Data);
+    return true;
+}
+
+bool STilemap::DeserializeLegacy(Serialization::SpanReader& Reader)
+{
+    Reader.Read32(Height);
+
+    auto LegacyTiles = Memory::GetFrameVector<STile>();
+    LegacyTiles.resize(ETilemapFormat::LegacyTileCount);
+    Reader.Read32Array(reinterpret_cast<uint32_t*>(LegacyTiles.data()), LegacyTiles.size() * STile::FieldCount);
+
+    Reader.Read32(bUseWallJoints);
+
+    if (Reader.Failed() || Width < 0 || Width > ETilemapFormat::LegacyMaxWidth || Height < 0 || Height > ETilemapFormat::LegacyMaxHeight)
     {
-        Tile.Deserialize(Stream);
+        Log::Game<ELogLevel::Critical>("Corrupted legacy tilemap (%dx%d)", Width, Height);
+        Width = 0;
+        Height = 0;
+        return false;
     }
 
-    Serialization::Read32(Stream, bUseWallJoints);
+    Tiles.Clear();
+    SetTiles(0, TileCount(), [&](std::size_t Index) { return LegacyTiles[Index]; });
 
     PostProcess();
+
+    return true;
 }
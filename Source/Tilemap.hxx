@@ -1,8 +1,9 @@
 #pragma once
 
 #include <array>
-#include <bitset>
+#include <memory_resource>
 #include "Math.hxx"
+#include "Memory.hxx"
 #include "Tile.hxx"
 #include "SharedConstants.hxx"
 
@@ -38,17 +39,294 @@ namespace ELevelDirtyFlags
         POVChanged = 1 << 0,
         DrawSet = 1 << 2,
         DirtyRange = 1 << 3,
+        Navigation = 1 << 4, /* Walls, doors or floors changed, cached paths are stale. */
+        Visibility = 1 << 5, /* Baked visibility changed, chunks picked from it are stale. */
         All = UINT32_MAX
     };
 }
 
+/* .erm v2: header, section table, then section payloads. All integers are big-endian.
+ * Files that don't start with the magic are legacy: Width, Height, all LegacyTileCount tiles, bUseWallJoints.
+ * Patch journals are records of file offset, byte count and bytes, sealed by JournalMagic, the record bytes and their checksum. */
+namespace ETilemapFormat
+{
+    static constexpr uint32_t Magic = 0x45524D4C; /* "ERML" */
+    static constexpr uint32_t Version = 2;
+    static constexpr uint32_t HeaderSize = 5 * sizeof(uint32_t);
+    static constexpr uint32_t SectionEntrySize = 4 * sizeof(uint32_t);
+    static constexpr uint32_t MaxSectionCount = 16;
+    static constexpr uint32_t JournalMagic = 0x45524D4A; /* "ERMJ" */
+    static constexpr uint32_t JournalSealSize = 3 * sizeof(uint32_t);
+
+    /* Legacy files always store a full 32x32 array. */
+    static constexpr int32_t LegacyMaxWidth = 32;
+    static constexpr int32_t LegacyMaxHeight = 32;
+    static constexpr uint32_t LegacyTileCount = LegacyMaxWidth * LegacyMaxHeight;
+}
+
+namespace ETilemapSection
+{
+    using Type = uint32_t;
+    enum : Type
+    {
+        Tiles = 1,
+        Properties = 2
+    };
+}
+
+/* Tiles section encodings, Width * Height tiles in row order. */
+namespace ETilemapEncoding
+{
+    using Type = uint32_t;
+    enum : Type
+    {
+        Packed = 0,    /* uint32 STile::Pack() per tile. */
+        PackedRLE = 1, /* uint16 run length followed by uint32 STile::Pack(). */
+        Wide = 2       /* Four uint32 fields per tile, for values that don't fit a byte. */
+    };
+}
+
+/* Where the payloads of an already written tilemap live, so fixed-size sections can be patched in place. */
+struct STilemapFileLayout
+{
+    int32_t Width{};
+    int32_t Height{};
+    ETilemapEncoding::Type TilesEncoding{};
+    uint32_t TilesOffset{};
+    uint32_t TilesLength{};
+    uint32_t PropertiesOffset{};
+    uint32_t PropertiesLength{};
+};
+
+/* Sorted, disjoint, inclusive tile index ranges. Touching ranges are merged, and past MaxSpans the two closest ones are. */
+struct SDirtySpans
+{
+    static constexpr std::size_t MaxSpans = 16;
+
+    /* One spare slot, filled only while Add decides which pair to merge. */
+    std::array<SVec2Size, MaxSpans + 1> Spans{};
+    std::size_t Count{};
+
+    void Add(std::size_t First, std::size_t Last);
+
+    void Clear() { Count = 0; }
+
+    [[nodiscard]] bool IsEmpty() const { return Count == 0; }
+
+    /* Tiles inside the spans. */
+    [[nodiscard]] std::size_t TileCount() const;
+
+    [[nodiscard]] const SVec2Size* begin() const { return Spans.data(); }
+
+    [[nodiscard]] const SVec2Size* end() const { return Spans.data() + Count; }
+};
+
+/* Tiles in 16x16 chunks, allocated from the pool on first write. Chunks that were never written read as empty tiles,
+ * so memory follows the occupied area. Chunks are addressed by absolute coordinates, resizing keeps every tile in place. */
+class CTileChunks
+{
+public:
+    static constexpr int ChunkShift = 4;
+    static constexpr int ChunkSize = 1 << ChunkShift;
+    static constexpr int ChunkMask = ChunkSize - 1;
+    static constexpr int ChunkTileCount = ChunkSize * ChunkSize;
+    static constexpr int ChunksPerRow = MAX_LEVEL_WIDTH / ChunkSize;
+    static constexpr int ChunksPerColumn = MAX_LEVEL_HEIGHT / ChunkSize;
+
+    /* Row-major, ChunkSize tiles per row. */
+    struct SChunk
+    {
+        std::array<STile, ChunkTileCount> Tiles{};
+    };
+
+    CTileChunks();
+    CTileChunks(const CTileChunks& Other);
+    CTileChunks(CTileChunks&& Other) noexcept;
+    CTileChunks& operator=(const CTileChunks& Other);
+    CTileChunks& operator=(CTileChunks&& Other) noexcept;
+    ~CTileChunks();
+
+    [[nodiscard]] const SChunk* FindChunk(int ChunkX, int ChunkY) const
+    {
+        auto Index = (std::size_t)(ChunkY * ChunksPerRow + ChunkX);
+        return Index < Chunks.size() ? Chunks[Index] : &EmptyChunk;
+    }
+
+    [[nodiscard]] bool HasChunk(int ChunkX, int ChunkY) const
+    {
+        return FindChunk(ChunkX, ChunkY) != &EmptyChunk;
+    }
+
+    [[nodiscard]] const STile& Get(int X, int Y) const
+    {
+        return FindChunk(X >> ChunkShift, Y >> ChunkShift)->Tiles[TileIndexInChunk(X, Y)];
+    }
+
+    [[nodiscard]] STile& GetMutable(int X, int Y)
+    {
+        return FindOrAddChunk(X >> ChunkShift, Y >> ChunkShift)->Tiles[TileIndexInChunk(X, Y)];
+    }
+
+    /* Unlike GetMutable, writing an empty tile into a missing chunk doesn't allocate it. */
+    void Set(int X, int Y, const STile& Tile);
+
+    /* Frees every chunk. */
+    void Clear();
+
+    [[nodiscard]] std::size_t ChunkCount() const;
+
+    [[nodiscard]] static constexpr int TileIndexInChunk(int X, int Y)
+    {
+        return ((Y & ChunkMask) << ChunkShift) | (X & ChunkMask);
+    }
+
+private:
+    static const SChunk EmptyChunk;
+
+    /* Missing chunks point at EmptyChunk, which saves a branch on every read. */
+    std::pmr::vector<const SChunk*> Chunks;
+
+    SChunk* FindOrAddChunk(int ChunkX, int ChunkY);
+};
+
+struct STilemap;
+
+/* Planes of STileBitplanes, each one is a single tile flag. Edge planes follow STile edge bits, so EdgeFlags map straight onto them. */
+namespace ETileBitplane
+{
+    using Type = uint32_t;
+    enum : Type
+    {
+        Floor,
+        Hole,
+        Visited,
+        Explored,
+        WallNorth,
+        WallEast,
+        WallSouth,
+        WallWest,
+        DoorNorth,
+        DoorEast,
+        DoorSouth,
+        DoorWest,
+        Count
+    };
+
+    [[nodiscard]] constexpr Type Wall(SDirection Direction) { return WallNorth + Direction.Index; }
+
+    [[nodiscard]] constexpr Type Door(SDirection Direction) { return DoorNorth + Direction.Index; }
+}
+
+/* Structure-of-arrays copy of a tilemap: one bit row per flag, rows padded to whole words.
+ * Lets whole-map queries test 64 tiles at a time. Tiles stay authoritative (and shader-facing), planes are rebuilt from them,
+ * except the fog planes: code that sets Visited or Explored on a tile sets the plane bit with it. */
+struct STileBitplanes
+{
+    int32_t Width{};
+    int32_t Height{};
+    std::size_t WordsPerRow{};
+    std::pmr::vector<uint64_t> Words{ Memory::GetPoolResource() };
+
+    /* Plane bits of a single tile, bit N is set when the tile belongs to plane N. */
+    [[nodiscard]] static uint32_t TileKey(const STile& Tile)
+    {
+        return ((Tile.Flags & (TILE_FLOOR_BIT | TILE_HOLE_BIT)) >> 1) |
+            ((Tile.SpecialFlags & (TILE_SPECIAL_VISITED_BIT | TILE_SPECIAL_EXPLORED_BIT)) << ETileBitplane::Visited) |
+            ((Tile.EdgeFlags & 0xFFu) << ETileBitplane::WallNorth);
+    }
+
+    /* Inverse of TileKey. Flags without a plane come back cleared. */
+    [[nodiscard]] static STile TileFromKey(uint32_t Key)
+    {
+        STile Tile;
+        Tile.Flags = (Key & 0x3u) << 1;
+        Tile.SpecialFlags = (Key >> ETileBitplane::Visited) & 0x3u;
+        Tile.EdgeFlags = (Key >> ETileBitplane::WallNorth) & 0xFFu;
+        return Tile;
+    }
+
+    void Build(const STilemap& Tilemap);
+
+    /* False until the planes are built for the tilemap's current size. */
+    [[nodiscard]] bool IsBuiltFor(const STilemap& Tilemap) const;
+
+    /* Re-reads the tiles inside Rect, planes must already match the tilemap size. */
+    void Refresh(const STilemap& Tilemap, const SRectInt& Rect);
+
+    [[nodiscard]] const uint64_t* Row(ETileBitplane::Type Plane, int Y) const
+    {
+        return &Words[((std::size_t)Plane * Height + Y) * WordsPerRow];
+    }
+
+    [[nodiscard]] uint64_t* RowMutable(ETileBitplane::Type Plane, int Y)
+    {
+        return &Words[((std::size_t)Plane * Height + Y) * WordsPerRow];
+    }
+
+    [[nodiscard]] bool Test(ETileBitplane::Type Plane, int X, int Y) const
+    {
+        return (Row(Plane, Y)[X / 64] >> (X % 64)) & 1;
+    }
+
+    void Set(ETileBitplane::Type Plane, int X, int Y, bool bValue)
+    {
+        auto& Word = RowMutable(Plane, Y)[X / 64];
+        auto Bit = uint64_t(1) << (X % 64);
+        Word = bValue ? (Word | Bit) : (Word & ~Bit);
+    }
+
+    [[nodiscard]] STile GetTile(int X, int Y) const
+    {
+        uint32_t Key{};
+        for (ETileBitplane::Type Plane = 0; Plane < ETileBitplane::Count; ++Plane)
+        {
+            Key |= (uint32_t)Test(Plane, X, Y) << Plane;
+        }
+        return TileFromKey(Key);
+    }
+
+private:
+    void StoreKey(int X, int Y, uint32_t Key);
+};
+
+/* Per-tile movement flags, so movement and AI queries are single lookups. */
+namespace ETileAdjacency
+{
+    using Type = uint16_t;
+    enum : Type
+    {
+        OpenNorth = 1 << 0, /* No wall on this side of the edge, doors count as open. */
+        PassableNorth = 1 << 4, /* Open, and the neighbor is a walkable tile. */
+        DoorNorth = 1 << 8,
+        Walkable = 1 << 12,
+        Hole = 1 << 13
+    };
+
+    [[nodiscard]] constexpr Type Open(SDirection Direction) { return OpenNorth << Direction.Index; }
+
+    [[nodiscard]] constexpr Type Passable(SDirection Direction) { return PassableNorth << Direction.Index; }
+
+    [[nodiscard]] constexpr Type Door(SDirection Direction) { return DoorNorth << Direction.Index; }
+
+    /* Neither wall nor door, sight goes through. */
+    [[nodiscard]] constexpr bool IsEmpty(Type Adjacency, SDirection Direction)
+    {
+        return (Adjacency & (Open(Direction) | Door(Direction))) == Open(Direction);
+    }
+}
+
 struct STilemap
 {
     int32_t Width{};
     int32_t Height{};
-    std::array<STile, MAX_LEVEL_TILE_COUNT> Tiles{};
-    std::bitset<(MAX_LEVEL_WIDTH + 1) * (MAX_LEVEL_HEIGHT + 1)> WallJoints{};
+    CTileChunks Tiles{};
+    /* One bit per joint, (Width + 1) * (Height + 1) of them, rows padded to whole words. */
+    std::pmr::vector<uint64_t> WallJoints{ Memory::GetPoolResource() };
     uint32_t bUseWallJoints = true;
+    /* Planes as of the last PostProcess or PostProcessRegion, wall joints are derived from their edge rows. */
+    STileBitplanes Bitplanes{};
+    /* ETileAdjacency per tile, kept current by PostProcess and the edit functions. */
+    std::pmr::vector<ETileAdjacency::Type> Adjacency{ Memory::GetPoolResource() };
 
     [[nodiscard]] uint32_t TileCount() const { return Width * Height; }
 
@@ -56,8 +334,7 @@ struct STilemap
     {
         if (IsValidTile(Coords))
         {
-            auto Index = CoordsToIndex(Coords);
-            return &Tiles[Index];
+            return &Tiles.GetMutable(Coords.X, Coords.Y);
         }
         return nullptr;
     }
@@ -70,10 +347,11 @@ struct STilemap
 
     void SetWallJoint(const SVec2Int& Coords, bool bValue = true)
     {
-        if (IsValidWallJoint(Coords))
+        auto Index = WallJointWordIndex(Coords.X, Coords.Y);
+        if (IsValidWallJoint(Coords) && Index < WallJoints.size())
         {
-            auto Index = WallJointCoordsToIndex(Coords.X, Coords.Y);
-            WallJoints.set(Index, bValue);
+            auto Bit = uint64_t(1) << (Coords.X % 64);
+            WallJoints[Index] = bValue ? (WallJoints[Index] | Bit) : (WallJoints[Index] & ~Bit);
         }
     }
 
@@ -81,21 +359,29 @@ struct STilemap
     {
         if (IsValidTile(Coords))
         {
-            auto Index = CoordsToIndex(Coords.X, Coords.Y);
-            return &Tiles[Index];
+            return &Tiles.Get(Coords.X, Coords.Y);
         }
         return nullptr;
     }
 
     [[nodiscard]] STile const* GetTile(const std::size_t Index) const
     {
-        if (Index < MAX_LEVEL_TILE_COUNT)
+        if (Index < TileCount())
         {
-            return &Tiles[Index];
+            return &Tiles.Get((int)(Index % Width), (int)(Index / Width));
         }
         return nullptr;
     }
 
+    [[nodiscard]] ETileAdjacency::Type GetAdjacency(const SVec2Int& Coords) const
+    {
+        if (IsValidTile(Coords) && CoordsToIndex(Coords) < Adjacency.size())
+        {
+            return Adjacency[CoordsToIndex(Coords)];
+        }
+        return 0;
+    }
+
     [[nodiscard]] bool IsValidTile(const SVec2Int& Coords) const
     {
         return IsValidTileX(Coords.X) && IsValidTileY(Coords.Y);
@@ -115,10 +401,32 @@ struct STilemap
 
     [[nodiscard]] inline std::size_t CoordsToIndex(const SVec2Int& Coords) const { return CoordsToIndex(Coords.X, Coords.Y); }
 
+    [[nodiscard]] inline SVec2Int IndexToCoords(std::size_t Index) const { return { (int)(Index % Width), (int)(Index / Width) }; }
+
+    /* Visits Count tiles in index order starting at First, without a division per tile. */
+    template <typename F>
+    void ForEachTile(std::size_t First, std::size_t Count, F&& Func) const
+    {
+        if (Count == 0)
+        {
+            return;
+        }
+        auto Coords = IndexToCoords(First);
+        for (std::size_t Index = First; Index < First + Count; ++Index)
+        {
+            Func(Index, Tiles.Get(Coords.X, Coords.Y));
+            if (++Coords.X == Width)
+            {
+                Coords.X = 0;
+                Coords.Y++;
+            }
+        }
+    }
+
     [[nodiscard]] bool IsWallJointAt(SVec2Int Coords) const
     {
-        auto Index = WallJointCoordsToIndex(Coords.X, Coords.Y);
-        return WallJoints.test(Index);
+        auto Index = WallJointWordIndex(Coords.X, Coords.Y);
+        return IsValidWallJoint(Coords) && Index < WallJoints.size() && (WallJoints[Index] >> (Coords.X % 64)) & 1;
     }
 
     [[nodiscard]] bool IsValidWallJoint(SVec2Int Coords) const
@@ -136,7 +444,9 @@ struct STilemap
         return Coord >= 0 && Coord < Height + 1;
     }
 
-    [[nodiscard]] inline std::size_t WallJointCoordsToIndex(int X, int Y) const { return (Y * (Width + 1)) + X; }
+    [[nodiscard]] inline std::size_t WallJointWordsPerRow() const { return ((std::size_t)Width + 1 + 63) / 64; }
+
+    [[nodiscard]] inline std::size_t WallJointWordIndex(int X, int Y) const { return Y * WallJointWordsPerRow() + X / 64; }
 
     [[nodiscard]] SVec2Int CalculateMapSize() const
     {
@@ -154,15 +464,88 @@ struct STilemap
         };
     }
 
+    /* Rebuilds bitplanes, adjacency and wall joints for the whole level. */
     void PostProcess();
 
+    /* Same as PostProcess, but only for tiles around Rect (neighbors included, edits change their facing edges).
+     * Edit, EditBlock and ToggleEdge call it themselves. */
+    void PostProcessRegion(const SRectInt& Rect);
+
     void ToggleEdge(const SVec2Int& Coords, SDirection Direction, UFlagType NorthEdgeBit);
 
     void Edit(const SVec2Int& Coords, ETileFlag Flag, bool bHandleEdges = true);
 
-    void EditBlock(const SRectInt& Rect, ETileFlag Flag);
+    /* Same result as calling Edit on every tile of Rect, in one pass. Returns the tiles it may have changed as inclusive index ranges. */
+    std::pmr::vector<SVec2Size> EditBlock(const SRectInt& Rect, ETileFlag Flag);
+
+    /* Fixed layout never uses RLE, so every tile stays at a known offset and the file can be patched later. */
+    void Serialize(std::ofstream& Stream, bool bFixedLayout = false) const;
+
+    static bool ReadFileLayout(Serialization::SpanReader& Reader, STilemapFileLayout& Layout);
+
+    [[nodiscard]] bool CanPatch(const STilemapFileLayout& Layout, const SDirtySpans& Spans) const;
+
+    /* Appends a sealed journal that rewrites the tiles in Spans and the properties of a file matching Layout. */
+    void SerializePatch(std::pmr::vector<uint8_t>& Journal, const STilemapFileLayout& Layout, const SDirtySpans& Spans) const;
+
+    /* False for journals that were cut short or corrupted on the way to the disk. */
+    [[nodiscard]] static bool IsPatchJournalSealed(const uint8_t* Data, std::size_t Length);
 
-    void Serialize(std::ofstream& Stream) const;
+    /* Writes every record of a sealed journal at its offset in Stream. Writes nothing and returns false for a torn one. */
+    static bool ApplyPatchJournal(const uint8_t* Data, std::size_t Length, std::ostream& Stream);
 
-    void Deserialize(std::istream& Stream);
+    bool Deserialize(std::istream& Stream);
+
+    /* Replaces the level only once the whole file decoded, on failure it is left as it was. */
+    bool Deserialize(Serialization::SpanReader& Reader);
+
+    bool DecodeTiles(const uint8_t* Data, std::size_t Length, ETilemapEncoding::Type Encoding);
+
+    bool DecodeProperties(const uint8_t* Data, std::size_t Length);
+
+private:
+    /* Tile rows MinY..MaxY and columns MinX..MaxX, inclusive. */
+    void UpdateAdjacency(int MinY, int MaxY, int MinX, int MaxX);
+
+    /* Joint rows MinY..MaxY and columns MinX..MaxX, inclusive. */
+    void UpdateWallJoints(int MinY, int MaxY, int MinX, int MaxX);
+
+    /* Edit rules for the edge between Tile and its neighbor (nullptr outside the map), with Tile just set to Flag. */
+    static void UpdateEdge(STile& Tile, STile* NeighborTile, SDirection Direction, ETileFlag Flag);
+
+    /* Decode straight into this level and leave it half-built on failure, Deserialize runs them on a temporary. */
+    bool DeserializeInPlace(Serialization::SpanReader& Reader);
+
+    bool DeserializeLegacy(Serialization::SpanReader& Reader);
+
+    void EncodeTiles(std::size_t First, std::size_t Count, ETilemapEncoding::Type Encoding, std::pmr::vector<uint8_t>& Payload) const;
+
+    [[nodiscard]] bool CanPackRange(std::size_t First, std::size_t Count) const;
+
+    /* Writes Count tiles in index order starting at First, taking each one from Func(Index). */
+    template <typename F>
+    void SetTiles(std::size_t First, std::size_t Count, F&& Func)
+    {
+        if (Count == 0)
+        {
+            return;
+        }
+        auto Coords = IndexToCoords(First);
+        for (std::size_t Index = First; Index < First + Count; ++Index)
+        {
+            Tiles.Set(Coords.X, Coords.Y, Func(Index));
+            if (++Coords.X == Width)
+            {
+                Coords.X = 0;
+                Coords.Y++;
+            }
+        }
+    }
 };
+
+static_assert(sizeof(STile) == STile::FieldCount * sizeof(uint32_t));
+
+/* TileKey relies on tile bits lining up with plane order. */
+static_assert(TILE_FLOOR_BIT == 1u << (ETileBitplane::Floor + 1) && TILE_HOLE_BIT == 1u << (ETileBitplane::Hole + 1));
+static_assert(TILE_SPECIAL_VISITED_BIT == 1u && TILE_SPECIAL_EXPLORED_BIT == 1u << (ETileBitplane::Explored - ETileBitplane::Visited));
+static_assert(TILE_EDGE_WALL_BIT == 1u && TILE_EDGE_DOOR_WEST_BIT == 1u << (ETileBitplane::DoorWest - ETileBitplane::WallNorth));
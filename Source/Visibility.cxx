@@ -0,0 +1,243 @@
+#include "Visibility.hxx"
+
+#include <algorithm>
+#include "FieldOfView.hxx"
+#include "Jobs.hxx"
+#include "Log.hxx"
+#include "Tilemap.hxx"
+
+/* Rows of tiles per job. */
+static constexpr std::size_t BakeGrain = 4;
+
+static int64_t Area(const SRectInt& Rect)
+{
+    return (int64_t)(Rect.Max.X - Rect.Min.X + 1) * (Rect.Max.Y - Rect.Min.Y + 1);
+}
+
+static SRectInt Union(const SRectInt& A, const SRectInt& B)
+{
+    return SRectInt{ { std::min(A.Min.X, B.Min.X), std::min(A.Min.Y, B.Min.Y) }, { std::max(A.Max.X, B.Max.X), std::max(A.Max.Y, B.Max.Y) } };
+}
+
+static bool Overlaps(const SRectInt& A, const SRectInt& B)
+{
+    return A.Min.X <= B.Max.X && B.Min.X <= A.Max.X && A.Min.Y <= B.Max.Y && B.Min.Y <= A.Max.Y;
+}
+
+void SDirtyRects::Add(const SRectInt& Rect)
+{
+    /* Swallow every rect the new one overlaps, growing it may reach ones it missed before. */
+    auto Merged = Rect;
+    for (std::size_t Index = 0; Index < Count;)
+    {
+        if (Overlaps(Rects[Index], Merged))
+        {
+            Merged = Union(Rects[Index], Merged);
+            Rects[Index] = Rects[--Count];
+            Index = 0;
+        }
+        else
+        {
+            ++Index;
+        }
+    }
+    Rects[Count++] = Merged;
+
+    if (Count > MaxRects)
+    {
+        /* Give up the pair that wastes the fewest tiles, the union then goes through the overlap check again. */
+        std::size_t BestA = 0;
+        std::size_t BestB = 1;
+        auto BestWaste = INT64_MAX;
+        for (std::size_t A = 0; A < Count; ++A)
+        {
+            for (auto B = A + 1; B < Count; ++B)
+            {
+                auto Waste = Area(Union(Rects[A], Rects[B])) - Area(Rects[A]) - Area(Rects[B]);
+                if (Waste < BestWaste)
+                {
+                    BestA = A;
+                    BestB = B;
+                    BestWaste = Waste;
+                }
+            }
+        }
+        auto Pair = Union(Rects[BestA], Rects[BestB]);
+        Rects[BestB] = Rects[--Count];
+        Rects[BestA] = Rects[--Count];
+        Add(Pair);
+    }
+}
+
+void CLevelVisibility::Bake(const STilemap& Tilemap, const std::atomic<bool>* bCancelled)
+{
+    Width = Tilemap.Width;
+    Height = Tilemap.Height;
+    Masks.assign(Tilemap.TileCount(), 0);
+    BakeRect(Tilemap, SRectInt{ { 0, 0 }, { Width - 1, Height - 1 } }, Masks.data(), bCancelled);
+
+    Log::Game<ELogLevel::Debug>("%s(): %dx%d tiles, %zu bytes", __func__, Width, Height, SizeBytes());
+}
+
+void CLevelVisibility::SetRect(const SRectInt& Rect, const uint64_t* InMasks)
+{
+    auto RectWidth = (std::size_t)(Rect.Max.X - Rect.Min.X + 1);
+    for (auto Y = Rect.Min.Y; Y <= Rect.Max.Y; ++Y, InMasks += RectWidth)
+    {
+        std::copy(InMasks, InMasks + RectWidth, Masks.begin() + (std::ptrdiff_t)Y * Width + Rect.Min.X);
+    }
+}
+
+bool CLevelVisibility::IsBaked(const STilemap& Tilemap) const
+{
+    return Width == Tilemap.Width && Height == Tilemap.Height && Masks.size() == Tilemap.TileCount();
+}
+
+void CLevelVisibility::Reset()
+{
+    Width = 0;
+    Height = 0;
+    Masks.clear();
+}
+
+uint64_t CLevelVisibility::GetMask(const SVec2Int& Coords) const
+{
+    if (Coords.X < 0 || Coords.Y < 0 || Coords.X >= Width || Coords.Y >= Height)
+    {
+        return 0;
+    }
+    return Masks[(std::size_t)Coords.Y * Width + Coords.X];
+}
+
+void CLevelVisibility::BakeRect(const STilemap& Tilemap, const SRectInt& Rect, uint64_t* OutMasks, const std::atomic<bool>* bCancelled)
+{
+    auto Rows = (std::size_t)(Rect.Max.Y - Rect.Min.Y + 1);
+    auto RectWidth = (std::size_t)(Rect.Max.X - Rect.Min.X + 1);
+    Jobs::ParallelFor("Bake Visibility", Rows, BakeGrain, [&](std::size_t Begin, std::size_t End) {
+        /* Shared by the tiles of the batch, the main thread's frame arena can't take a level's worth of them. */
+        std::pmr::vector<SVec2Int> Visible{ Memory::GetPoolResource() };
+        FieldOfView::SScratch Scratch{};
+        for (auto Row = Begin; Row < End && !(bCancelled && *bCancelled); ++Row)
+        {
+            auto Y = Rect.Min.Y + (int)Row;
+            for (auto X = Rect.Min.X; X <= Rect.Max.X; ++X)
+            {
+                auto Chunk = SVec2Int{ X / ChunkSize, Y / ChunkSize };
+                uint64_t Mask{};
+                FieldOfView::Compute(Tilemap, { X, Y }, Distance, ERevealShape::Square, Visible, Scratch);
+                for (auto& Coords : Visible)
+                {
+                    /* Sight goes center to center, but the geometry of tiles next to a visible one can show around corners.
+                     * Those neighbors span at most two chunks per axis. */
+                    auto MinX = std::max(Coords.X - 1, 0) / ChunkSize - Chunk.X + ChunkReach;
+                    auto MaxX = std::min(Coords.X + 1, Tilemap.Width - 1) / ChunkSize - Chunk.X + ChunkReach;
+                    auto MinY = std::max(Coords.Y - 1, 0) / ChunkSize - Chunk.Y + ChunkReach;
+                    auto MaxY = std::min(Coords.Y + 1, Tilemap.Height - 1) / ChunkSize - Chunk.Y + ChunkReach;
+                    auto ChunkRow = (uint64_t(1) << MinX) | (uint64_t(1) << MaxX);
+                    Mask |= (ChunkRow << (MinY * MaskWidth)) | (ChunkRow << (MaxY * MaskWidth));
+                }
+                OutMasks[Row * RectWidth + (std::size_t)(X - Rect.Min.X)] = Mask;
+            }
+        }
+    });
+}
+
+bool CVisibilityBaker::Update(CLevelVisibility& Visibility, const STilemap& Tilemap, SDirtyRects& DirtyRects)
+{
+    if (IsBusy())
+    {
+        /* Edits made meanwhile pile up in DirtyRects. */
+        return false;
+    }
+    auto bChanged = Apply(Visibility, Tilemap);
+    Start(Visibility, Tilemap, DirtyRects);
+    return bChanged;
+}
+
+bool CVisibilityBaker::Apply(CLevelVisibility& Visibility, const STilemap& Tilemap)
+{
+    if (!Handle.IsValid())
+    {
+        return false;
+    }
+    Jobs::Wait(Handle);
+    Handle = {};
+
+    auto bChanged = false;
+    auto bFits = !bCancelled && Snapshot.Width == Tilemap.Width && Snapshot.Height == Tilemap.Height;
+    if (bFits && Boxes.empty() && !Visibility.IsBaked(Tilemap))
+    {
+        Visibility = std::move(Result);
+        bChanged = true;
+    }
+    else if (bFits && !Boxes.empty() && Visibility.IsBaked(Tilemap))
+    {
+        auto Masks = BoxMasks.data();
+        for (auto& Box : Boxes)
+        {
+            Visibility.SetRect(Box, Masks);
+            Masks += Area(Box);
+        }
+        bChanged = true;
+    }
+
+    Snapshot = STilemap{};
+    Result.Reset();
+    Boxes.clear();
+    BoxMasks.clear();
+    return bChanged;
+}
+
+void CVisibilityBaker::Start(const CLevelVisibility& Visibility, const STilemap& Tilemap, SDirtyRects& DirtyRects)
+{
+    /* Until a whole bake is done the renderer draws the level unculled. */
+    auto bWhole = !Visibility.IsBaked(Tilemap);
+    if (!bWhole && DirtyRects.IsEmpty())
+    {
+        return;
+    }
+
+    if (!bWhole)
+    {
+        /* Sight is symmetric, so only tiles within Distance of an edited one see it. The neighbor an edit touches adds one more. */
+        static constexpr int Reach = CLevelVisibility::Distance + 1;
+        SDirtyRects Merged{};
+        for (auto& Rect : DirtyRects)
+        {
+            Merged.Add(SRectInt{
+                { std::max(Rect.Min.X - Reach, 0), std::max(Rect.Min.Y - Reach, 0) },
+                { std::min(Rect.Max.X + Reach, Tilemap.Width - 1), std::min(Rect.Max.Y + Reach, Tilemap.Height - 1) } });
+        }
+        int64_t Tiles{};
+        for (auto& Box : Merged)
+        {
+            Boxes.push_back(Box);
+            Tiles += Area(Box);
+        }
+        BoxMasks.resize((std::size_t)Tiles);
+    }
+    DirtyRects.Clear();
+
+    Snapshot.Width = Tilemap.Width;
+    Snapshot.Height = Tilemap.Height;
+    Snapshot.Adjacency = Tilemap.Adjacency;
+    bCancelled = false;
+    if (bWhole)
+    {
+        Handle = Jobs::Submit("Bake Visibility", [this] { Result.Bake(Snapshot, &bCancelled); });
+    }
+    else
+    {
+        Handle = Jobs::Submit("Rebake Visibility", [this] { BakeBoxes(); });
+    }
+}
+
+void CVisibilityBaker::BakeBoxes()
+{
+    auto Masks = BoxMasks.data();
+    for (auto& Box : Boxes)
+    {
+        CLevelVisibility::BakeRect(Snapshot, Box, Masks, &bCancelled);
+        Masks += Area(Box);
+    }
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory_resource>
+#include "CommonTypes.hxx"
+#include "Jobs.hxx"
+#include "Math.hxx"
+#include "Memory.hxx"
+#include "Tilemap.hxx"
+
+/* Disjoint inclusive tile rects. Overlapping rects are merged, and past MaxRects the pair whose union adds the fewest tiles is. */
+struct SDirtyRects
+{
+    static constexpr std::size_t MaxRects = 16;
+
+    /* One spare slot, filled only while Add decides which pair to merge. */
+    std::array<SRectInt, MaxRects + 1> Rects{};
+    std::size_t Count{};
+
+    void Add(const SRectInt& Rect);
+
+    void Clear() { Count = 0; }
+
+    [[nodiscard]] bool IsEmpty() const { return Count == 0; }
+
+    [[nodiscard]] const SRectInt* begin() const { return Rects.data(); }
+
+    [[nodiscard]] const SRectInt* end() const { return Rects.data() + Count; }
+};
+
+/* Baked potentially visible sets: per tile, the chunks that can be seen from it in any direction.
+ * Tiles in sight are found with FieldOfView out to Distance, and a chunk counts when it holds one of them or a neighbor.
+ * Facing is left to frustum culling, a step between two tiles is covered by the union of both. */
+class CLevelVisibility
+{
+public:
+    static constexpr int ChunkSize = 8;
+    static constexpr int Distance = 16;
+    /* Chunks a mask reaches around the tile's own one, per axis: Distance plus the neighbor, from anywhere in a chunk. */
+    static constexpr int ChunkReach = (Distance + 1 + ChunkSize - 1 + ChunkSize - 1) / ChunkSize;
+    static constexpr int MaskWidth = 2 * ChunkReach + 1;
+    static_assert(MaskWidth * MaskWidth <= 64, "Masks have to fit in 64 bits.");
+
+    /* Bakes every tile over the job threads. Adjacency has to be up to date. Gives up early once bCancelled is set. */
+    void Bake(const STilemap& Tilemap, const std::atomic<bool>* bCancelled = nullptr);
+
+    /* Bakes the tiles of the inclusive Rect into OutMasks, row by row, without touching any level's masks. */
+    static void BakeRect(const STilemap& Tilemap, const SRectInt& Rect, uint64_t* OutMasks, const std::atomic<bool>* bCancelled = nullptr);
+
+    /* Copies masks baked by BakeRect over the ones of Rect. */
+    void SetRect(const SRectInt& Rect, const uint64_t* InMasks);
+
+    /* False until baked, after Reset, or after the level was resized. */
+    [[nodiscard]] bool IsBaked(const STilemap& Tilemap) const;
+
+    /* Drops the masks. Has to be called whenever the tiles are replaced wholesale, a size check can't tell. */
+    void Reset();
+
+    /* 0 outside the level. Bit (ChunkOffset.Y + ChunkReach) * MaskWidth + ChunkOffset.X + ChunkReach, relative to the chunk of Coords. */
+    [[nodiscard]] uint64_t GetMask(const SVec2Int& Coords) const;
+
+    /* Calls Func(ChunkCoords) for every chunk in sight of Coords. */
+    template <typename F>
+    void ForEachChunk(const SVec2Int& Coords, F&& Func) const
+    {
+        auto Mask = GetMask(Coords);
+        auto Chunk = SVec2Int{ Coords.X / ChunkSize, Coords.Y / ChunkSize };
+        for (int Bit = 0; Mask != 0; ++Bit, Mask >>= 1)
+        {
+            if (Mask & 1)
+            {
+                Func(Chunk + SVec2Int{ Bit % MaskWidth - ChunkReach, Bit / MaskWidth - ChunkReach });
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t SizeBytes() const { return Masks.size() * sizeof(uint64_t); }
+
+private:
+    int Width{};
+    int Height{};
+    std::pmr::vector<uint64_t> Masks{ Memory::GetPoolResource() };
+};
+
+/* Keeps one level's visibility baked with jobs, off a snapshot of its adjacency so edits can go on meanwhile.
+ * Levels without masks are baked whole, after that only the tiles around edited rects are rebaked. */
+class CVisibilityBaker
+{
+public:
+    CVisibilityBaker() = default;
+
+    /* Copies start out idle, a running bake stays with the original. */
+    CVisibilityBaker(const CVisibilityBaker&) {}
+
+    CVisibilityBaker& operator=(const CVisibilityBaker&) { return *this; }
+
+    /* Applies a finished bake and starts the next one, unless one is still running. Returns true when masks changed. */
+    bool Update(CLevelVisibility& Visibility, const STilemap& Tilemap, SDirtyRects& DirtyRects);
+
+    [[nodiscard]] bool IsBusy() const { return Handle.IsValid() && !Jobs::IsFinished(Handle); }
+
+    /* Waits for the running bake and applies it, if it still fits. Returns true when masks changed. */
+    bool Apply(CLevelVisibility& Visibility, const STilemap& Tilemap);
+
+    /* Starts a whole bake when Visibility has none, or rebakes around the rects in DirtyRects, taking them. Call when not busy. */
+    void Start(const CLevelVisibility& Visibility, const STilemap& Tilemap, SDirtyRects& DirtyRects);
+
+    /* Drops the result of the running bake, after the level was replaced. It stops early, Apply() still has to collect it. */
+    void Cancel() { bCancelled = true; }
+
+    void Wait() const { Jobs::Wait(Handle); }
+
+private:
+    SJobHandle Handle{};
+    std::atomic<bool> bCancelled{};
+    /* Only the size and adjacency of the level, all FieldOfView looks at. */
+    STilemap Snapshot{};
+    /* Whole bakes. */
+    CLevelVisibility Result{};
+    /* Rebakes: the rects and their masks, one after another. */
+    std::pmr::vector<SRectInt> Boxes{ Memory::GetPoolResource() };
+    std::pmr::vector<uint64_t> BoxMasks{ Memory::GetPoolResource() };
+
+    void BakeBoxes();
+};
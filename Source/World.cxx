@@ -1,5 +1,8 @@
 #include "World.hxx"
+
+#include <algorithm>
 #include "AssetTools.hxx"
+#include "LevelStreamer.hxx"
 #include "Log.hxx"
 #include "Utility.hxx"
 
@@ -15,16 +18,91 @@ void SWorld::Init()
 {
     StartInfo.POV.Coords = { 6, 5 };
 
-    auto LoadLevel = [&](const SAsset& Asset, size_t Index) {
-        Serialization::MemoryStream LevelStream(Asset.SignedCharPtr(), Asset.Length);
-        Levels[Index].Deserialize(LevelStream);
-        Levels[Index].Color = { Utility::GetRandomFloat(), Utility::GetRandomFloat(), Utility::GetRandomFloat() };
+    /* Only registered here, levels are loaded by the streamer as the player gets near them. */
+    auto AddLevel = [&](const SAsset& Asset) {
+        auto& Info = LevelInfos[LevelCount++];
+        Info.Asset = &Asset;
+        Info.Position = { 0, 0, (int)LevelCount - 1 };
+        Info.Color = { Utility::GetRandomFloat(), Utility::GetRandomFloat(), Utility::GetRandomFloat() };
     };
 
-    LoadLevel(Asset::Map::Floor0, 0);
-    LoadLevel(Asset::Map::Floor1, 1);
-    LoadLevel(Asset::Map::Floor2, 2);
-    LoadLevel(Asset::Map::Floor3, 3);
+    AddLevel(Asset::Map::Floor0);
+    AddLevel(Asset::Map::Floor1);
+    AddLevel(Asset::Map::Floor2);
+    AddLevel(Asset::Map::Floor3);
+}
+
+bool SWorld::UpdateStreaming(CLevelStreamer& Streamer)
+{
+    auto bChanged = false;
+
+    Streamer.Collect([&](size_t Index, SWorldLevel& Level, bool bLoaded) {
+        if (!bLoaded)
+        {
+            Residency[Index] = ELevelResidency::Unloaded;
+            return;
+        }
+        /* Moved out of range while loading, not worth keeping. */
+        if (Residency[Index] != ELevelResidency::Loading || DistanceToCurrent(Index) > WorldEvictionDistance)
+        {
+            if (Residency[Index] == ELevelResidency::Loading)
+            {
+                Residency[Index] = ELevelResidency::Unloaded;
+            }
+            Streamer.Release(std::move(Level));
+            return;
+        }
+        Levels[Index] = std::move(Level);
+        Levels[Index].Color = LevelInfos[Index].Color;
+        Levels[Index].Position = LevelInfos[Index].Position;
+        Levels[Index].DirtyFlags |= ELevelDirtyFlags::Navigation;
+        Residency[Index] = ELevelResidency::Resident;
+        bChanged = true;
+    });
+
+    for (size_t Index = 0; Index < LevelCount; ++Index)
+    {
+        auto Distance = DistanceToCurrent(Index);
+        if (Residency[Index] == ELevelResidency::Unloaded && Distance <= WorldStreamingRadius)
+        {
+            Residency[Index] = ELevelResidency::Loading;
+            Streamer.Request(Index, LevelInfos[Index].Asset, Distance == 0);
+        }
+        else if (Residency[Index] == ELevelResidency::Resident && Distance > WorldEvictionDistance)
+        {
+            Log::Game<ELogLevel::Debug>("%s(): Evicting level %zu", __func__, Index);
+            Residency[Index] = ELevelResidency::Unloaded;
+            Streamer.Release(std::move(Levels[Index]));
+            Levels[Index] = SWorldLevel{};
+            bChanged = true;
+        }
+    }
+
+    return bChanged;
+}
+
+void SWorld::SetCurrentLevel(CLevelStreamer& Streamer, size_t Index)
+{
+    CurrentLevelIndex = Index;
+    UpdateStreaming(Streamer);
+    if (Residency[Index] == ELevelResidency::Resident)
+    {
+        return;
+    }
+
+    /* Already requested by the update above, or queued earlier and moved to the front now. */
+    Streamer.Request(Index, LevelInfos[Index].Asset, true);
+    Streamer.Wait(Index);
+    UpdateStreaming(Streamer);
+    if (Residency[Index] != ELevelResidency::Resident)
+    {
+        Log::Game<ELogLevel::Critical>("%s(): Level %zu is not loadable", __func__, Index);
+    }
+}
+
+void SWorld::Cleanup()
+{
+    VisibilityBaker.Wait();
 }
 
 void SWorld::Update(float DeltaTime)
@@ -32,4 +110,41 @@ void SWorld::Update(float DeltaTime)
     auto Level = GetLevel();
 
     Level->DoorInfo.Timeline.Advance(DeltaTime);
+
+    UpdateVisibility();
+}
+
+void SWorld::ResetVisibility()
+{
+    GetLevel()->Visibility.Reset();
+    CancelVisibilityBake();
+}
+
+void SWorld::CancelVisibilityBake()
+{
+    if (VisibilityLevelIndex == CurrentLevelIndex)
+    {
+        VisibilityBaker.Cancel();
+    }
+}
+
+void SWorld::UpdateVisibility()
+{
+    if (VisibilityBaker.IsBusy())
+    {
+        /* Edits made meanwhile pile up in VisibilityDirtyRects. */
+        return;
+    }
+
+    /* Evicted or reloaded levels fail the size checks, a reload of the same size gets the same bake. */
+    auto& Baked = Levels[VisibilityLevelIndex];
+    if (VisibilityBaker.Apply(Baked.Visibility, Baked))
+    {
+        Baked.DirtyFlags |= ELevelDirtyFlags::Visibility;
+    }
+
+    /* Streamed levels arrive unbaked, the whole bake of a large one takes a while. Until then the renderer draws it unculled. */
+    auto Level = GetLevel();
+    VisibilityLevelIndex = CurrentLevelIndex;
+    VisibilityBaker.Start(Level->Visibility, *Level, Level->VisibilityDirtyRects);
 }
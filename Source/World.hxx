@@ -3,16 +3,37 @@
 #include <array>
 #include "AssetTools.hxx"
 #include "CommonTypes.hxx"
+#include "Jobs.hxx"
 #include "Tilemap.hxx"
+#include "Pathfinding.hxx"
+#include "Visibility.hxx"
 #include "Math.hxx"
 
-inline constexpr int WorldMaxLevels = 8;
+inline constexpr int WorldMaxLevels = 64;
+
+/* Levels this close to the current one are loaded ahead of need, ones further than the eviction distance are dropped.
+ * The gap between the two keeps a level from being reloaded when stepping back and forth. */
+inline constexpr std::size_t WorldStreamingRadius = 3;
+inline constexpr std::size_t WorldEvictionDistance = 4;
+
+class CLevelStreamer;
+
+namespace ELevelResidency
+{
+    using Type = uint8_t;
+    enum : Type
+    {
+        Unloaded,
+        Loading,
+        Resident
+    };
+}
 
 struct SWorldLevelInfo
 {
     SVec3 Color{};
     SVec3Int Position{};
-    SAsset* Asset{};
+    const SAsset* Asset{};
 };
 
 struct SWorldLevel : STilemap
@@ -23,7 +44,50 @@ struct SWorldLevel : STilemap
     /* Draw State */
     SDrawDoorInfo DoorInfo{};
     uint32_t DirtyFlags = ELevelDirtyFlags::POVChanged | ELevelDirtyFlags::DrawSet;
-    TVec2<std::size_t> DirtyRange{};
+    SDirtySpans DirtySpans{};
+    CLevelVisibility Visibility{};
+    /* Tiles edited since visibility was last baked. */
+    SDirtyRects VisibilityDirtyRects{};
+
+    /* Editor State: tiles changed since the last save. */
+    SDirtySpans SaveDirtySpans{};
+
+    /* Every edit goes through here: the tiles count as unsaved, and cached paths, the draw set and the visibility around them are rebuilt. */
+    void MarkEdited(std::size_t First, std::size_t Last)
+    {
+        DirtyFlags |= ELevelDirtyFlags::Navigation | ELevelDirtyFlags::DrawSet;
+        SaveDirtySpans.Add(First, Last);
+
+        /* The partial first and last rows, and the whole ones between. */
+        auto FirstCoords = IndexToCoords(First);
+        auto LastCoords = IndexToCoords(Last);
+        if (FirstCoords.Y == LastCoords.Y)
+        {
+            VisibilityDirtyRects.Add(SRectInt{ FirstCoords, LastCoords });
+            return;
+        }
+        VisibilityDirtyRects.Add(SRectInt{ FirstCoords, { Width - 1, FirstCoords.Y } });
+        if (FirstCoords.Y + 1 < LastCoords.Y)
+        {
+            VisibilityDirtyRects.Add(SRectInt{ { 0, FirstCoords.Y + 1 }, { Width - 1, LastCoords.Y - 1 } });
+        }
+        VisibilityDirtyRects.Add(SRectInt{ { 0, LastCoords.Y }, LastCoords });
+    }
+
+    /* Edits touch the neighbors of the edited tiles too. */
+    void MarkEdited(const SRectInt& Rect)
+    {
+        auto Min = SVec2Int{ std::max(Rect.Min.X - 1, 0), std::max(Rect.Min.Y - 1, 0) };
+        auto Max = SVec2Int{ std::min(Rect.Max.X + 1, Width - 1), std::min(Rect.Max.Y + 1, Height - 1) };
+        DirtyFlags |= ELevelDirtyFlags::Navigation | ELevelDirtyFlags::DrawSet;
+        for (auto Y = Min.Y; Y <= Max.Y; ++Y)
+        {
+            SaveDirtySpans.Add(CoordsToIndex(Min.X, Y), CoordsToIndex(Max.X, Y));
+        }
+        VisibilityDirtyRects.Add(SRectInt{ Min, Max });
+    }
+
+    [[nodiscard]] bool IsSaveDirty() const { return !SaveDirtySpans.IsEmpty(); }
 };
 
 struct SWorldStartInfo
@@ -36,11 +100,53 @@ struct SWorld
 {
     SWorldStartInfo StartInfo{};
     size_t CurrentLevelIndex{};
+    size_t LevelCount{};
+    std::array<SWorldLevelInfo, WorldMaxLevels> LevelInfos;
+    std::array<ELevelResidency::Type, WorldMaxLevels> Residency{};
     std::array<SWorldLevel, WorldMaxLevels> Levels;
+    CPathfinder Pathfinder;
 
+    /* Registers the levels, SetCurrentLevel() loads the first one. */
     void Init();
 
+    /* Waits for a running visibility bake. Call before Jobs::Cleanup(). */
+    void Cleanup();
+
     void Update(float DeltaTime);
 
+    /* Drops the current level's visibility and the result of a bake of it still running, after its tiles were replaced wholesale. */
+    void ResetVisibility();
+
+    /* Only drops the result of a running bake, for a replacement level that brought its own visibility. */
+    void CancelVisibilityBake();
+
+    /* Swaps in finished loads, evicts distant levels and requests nearby ones. Call at frame boundaries.
+     * Returns true when a level came or went. */
+    bool UpdateStreaming(CLevelStreamer& Streamer);
+
+    /* Blocks until the level is resident, which is short when it was streamed in ahead of time. */
+    void SetCurrentLevel(CLevelStreamer& Streamer, size_t Index);
+
+    /* The current level is always resident. */
     [[nodiscard]] SWorldLevel* GetLevel() { return &Levels[CurrentLevelIndex]; }
+
+    /* Nullptr unless the level is resident. */
+    [[nodiscard]] const SWorldLevel* FindLevel(size_t Index) const
+    {
+        return Index < LevelCount && Residency[Index] == ELevelResidency::Resident ? &Levels[Index] : nullptr;
+    }
+
+private:
+    /* Bakes the current level's visibility once it is resident, and rebakes around edits after. */
+    CVisibilityBaker VisibilityBaker{};
+    /* Level the running bake is for, it is applied even if that is not the current one anymore. */
+    size_t VisibilityLevelIndex{};
+
+    /* Applies a finished bake, then starts the next one for the current level. */
+    void UpdateVisibility();
+
+    [[nodiscard]] size_t DistanceToCurrent(size_t Index) const
+    {
+        return Index > CurrentLevelIndex ? Index - CurrentLevelIndex : CurrentLevelIndex - Index;
+    }
 };
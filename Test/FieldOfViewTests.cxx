@@ -0,0 +1,204 @@
+#include "Test.hxx"
+
+#include <algorithm>
+#include <cstdlib>
+#include <random>
+#include "FieldOfView.hxx"
+#include "Memory.hxx"
+#include "Tilemap.hxx"
+
+static SDirection DirectionOf(const SVec2Int& Step)
+{
+    for (auto& Direction : SDirection::All())
+    {
+        if (Direction.GetVector<int>() == Step)
+        {
+            return Direction;
+        }
+    }
+    return SDirection::North();
+}
+
+/* Same rule as CQuadrantCaster::IsClear, read from the tile flags instead of the adjacency. */
+static bool IsEdgeClear(const STilemap& Level, const SVec2Int& Coords, const SVec2Int& Step)
+{
+    auto Neighbor = Coords + Step;
+    if (!Level.IsValidTile(Coords) || !Level.IsValidTile(Neighbor))
+    {
+        return false;
+    }
+    auto Direction = DirectionOf(Step);
+    return !Level.GetTileAt(Coords)->IsWallBasedEdge(Direction) && !Level.GetTileAt(Neighbor)->IsWallBasedEdge(Direction.Inverted());
+}
+
+/* Walks the ray from the center of Origin to the center of Target edge crossing by edge crossing, ordered exactly.
+ * Crossing the I-th column edge happens at (2I - 1) / (2 |DX|) of the way, the J-th row edge at (2J - 1) / (2 |DY|). */
+static bool IsVisibleByRayWalk(const STilemap& Level, const SVec2Int& Origin, const SVec2Int& Target)
+{
+    auto DX = std::abs(Target.X - Origin.X);
+    auto DY = std::abs(Target.Y - Origin.Y);
+    auto StepX = SVec2Int{ Target.X > Origin.X ? 1 : -1, 0 };
+    auto StepY = SVec2Int{ 0, Target.Y > Origin.Y ? 1 : -1 };
+    auto Current = Origin;
+    auto Column = 1;
+    auto Row = 1;
+    while (Column <= DX || Row <= DY)
+    {
+        auto Order = Column > DX ? 1 : Row > DY ? -1 : (int64_t)(2 * Column - 1) * DY - (int64_t)(2 * Row - 1) * DX;
+        if (Order < 0)
+        {
+            if (!IsEdgeClear(Level, Current, StepX))
+            {
+                return false;
+            }
+            Current = Current + StepX;
+            ++Column;
+        }
+        else if (Order > 0)
+        {
+            if (!IsEdgeClear(Level, Current, StepY))
+            {
+                return false;
+            }
+            Current = Current + StepY;
+            ++Row;
+        }
+        else
+        {
+            /* Through a corner: either way around it will do. */
+            auto bXFirst = IsEdgeClear(Level, Current, StepX) && IsEdgeClear(Level, Current + StepX, StepY);
+            auto bYFirst = IsEdgeClear(Level, Current, StepY) && IsEdgeClear(Level, Current + StepY, StepX);
+            if (!bXFirst && !bYFirst)
+            {
+                return false;
+            }
+            Current = Current + StepX + StepY;
+            ++Column;
+            ++Row;
+        }
+    }
+    return true;
+}
+
+static STilemap MakeRandomLevel(std::mt19937& Random)
+{
+    static constexpr ETileFlag Flags[] = { TILE_FLOOR_BIT, TILE_FLOOR_BIT, TILE_FLOOR_BIT, TILE_HOLE_BIT, 0 };
+
+    STilemap Level;
+    Level.Width = (int)(Random() % 40 + 1);
+    Level.Height = (int)(Random() % 40 + 1);
+    for (int Y = 0; Y < Level.Height; ++Y)
+    {
+        for (int X = 0; X < Level.Width; ++X)
+        {
+            if (Random() % 8 == 0)
+            {
+                continue;
+            }
+            STile Tile;
+            Tile.Flags = Flags[Random() % std::size(Flags)];
+            for (auto& Direction : SDirection::All())
+            {
+                auto Roll = Random() % 10;
+                if (Roll == 0)
+                {
+                    Tile.SetEdgeFlag(TILE_EDGE_WALL_BIT, Direction);
+                }
+                else if (Roll == 1)
+                {
+                    Tile.SetEdgeFlag(TILE_EDGE_DOOR_BIT, Direction);
+                }
+            }
+            Level.Tiles.Set(X, Y, Tile);
+        }
+    }
+    Level.PostProcess();
+    return Level;
+}
+
+/* Compute has to report exactly the tiles in range that a ray walk reaches, each once. */
+TEST(ComputeMatchesRayWalk)
+{
+    static constexpr ERevealShape::Type Shapes[] = { ERevealShape::Diamond, ERevealShape::Square, ERevealShape::Circle };
+
+    std::mt19937 Random(17);
+    FieldOfView::SScratch Scratch;
+    auto Visible = Memory::GetVector<SVec2Int>();
+    int Mismatches = 0;
+    for (int Iteration = 0; Iteration < 300; ++Iteration)
+    {
+        Memory::NextFrame();
+        auto Level = MakeRandomLevel(Random);
+        for (int Query = 0; Query < 20; ++Query)
+        {
+            /* Origins may be outside the level, which sees nothing. */
+            auto Origin = SVec2Int{ (int)(Random() % (Level.Width + 2)) - 1, (int)(Random() % (Level.Height + 2)) - 1 };
+            auto Radius = (int)(Random() % 12);
+            auto Shape = Shapes[Random() % std::size(Shapes)];
+            FieldOfView::Compute(Level, Origin, Radius, Shape, Visible, Scratch);
+
+            auto Sorted = Visible;
+            std::sort(Sorted.begin(), Sorted.end(), [](const SVec2Int& A, const SVec2Int& B) {
+                return A.Y != B.Y ? A.Y < B.Y : A.X < B.X;
+            });
+            EXPECT(std::adjacent_find(Sorted.begin(), Sorted.end()) == Sorted.end());
+            if (Level.IsValidTile(Origin))
+            {
+                EXPECT(!Visible.empty() && Visible.front() == Origin);
+            }
+
+            auto Expected = Memory::GetVector<SVec2Int>();
+            for (int Y = 0; Y < Level.Height && Level.IsValidTile(Origin); ++Y)
+            {
+                for (int X = 0; X < Level.Width; ++X)
+                {
+                    if (ERevealShape::Contains(Shape, X - Origin.X, Y - Origin.Y, Radius) && IsVisibleByRayWalk(Level, Origin, { X, Y }))
+                    {
+                        Expected.push_back({ X, Y });
+                    }
+                }
+            }
+            Sorted.erase(std::unique(Sorted.begin(), Sorted.end()), Sorted.end());
+            Mismatches += Sorted != Expected;
+        }
+    }
+    EXPECT(Mismatches == 0);
+}
+
+/* Reveal has to keep the Explored plane equal to the tile flags, and report exactly the tiles it explored. */
+TEST(RevealKeepsExploredPlane)
+{
+    std::mt19937 Random(23);
+    for (int Iteration = 0; Iteration < 200; ++Iteration)
+    {
+        Memory::NextFrame();
+        auto Level = MakeRandomLevel(Random);
+        for (int Step = 0; Step < 10; ++Step)
+        {
+            auto Before = Level;
+            auto Origin = SVec2Int{ (int)(Random() % Level.Width), (int)(Random() % Level.Height) };
+            auto Ranges = FieldOfView::Reveal(Level, Origin, (int)(Random() % 10), ERevealShape::Circle);
+
+            std::size_t Previous = SIZE_MAX;
+            for (auto& Range : Ranges)
+            {
+                EXPECT(Range.X <= Range.Y && (Previous == SIZE_MAX || Previous + 1 < Range.X));
+                Previous = Range.Y;
+            }
+            for (std::size_t Index = 0; Index < Level.TileCount(); ++Index)
+            {
+                auto Coords = Level.IndexToCoords(Index);
+                auto bWasExplored = Before.GetTileAt(Coords)->CheckSpecialFlag(TILE_SPECIAL_EXPLORED_BIT);
+                auto bExplored = Level.GetTileAt(Coords)->CheckSpecialFlag(TILE_SPECIAL_EXPLORED_BIT);
+                auto bReported = std::any_of(Ranges.begin(), Ranges.end(), [&](const SVec2Size& Range) { return Range.X <= Index && Index <= Range.Y; });
+                EXPECT(bReported == (bExplored && !bWasExplored));
+                EXPECT(!bWasExplored || bExplored);
+                EXPECT(Level.Bitplanes.Test(ETileBitplane::Explored, Coords.X, Coords.Y) == bExplored);
+            }
+        }
+
+        auto Rebuilt = Level;
+        Rebuilt.Bitplanes.Build(Rebuilt);
+        EXPECT(Rebuilt.Bitplanes.Words == Level.Bitplanes.Words);
+    }
+}
@@ -0,0 +1,124 @@
+#include "Test.hxx"
+
+#include <atomic>
+#include <random>
+#include <vector>
+#include "Jobs.hxx"
+
+struct SDagState
+{
+    std::vector<std::atomic<int>> RunCounts;
+    std::vector<std::atomic<bool>> bFinished;
+    std::vector<std::vector<std::size_t>> Dependencies;
+    std::atomic<int> OrderViolations{};
+
+    explicit SDagState(std::size_t Count)
+        : RunCounts(Count), bFinished(Count), Dependencies(Count)
+    {
+    }
+
+    void Run(std::size_t Index)
+    {
+        for (auto Dependency : Dependencies[Index])
+        {
+            OrderViolations += !bFinished[Dependency].load();
+        }
+        RunCounts[Index]++;
+        bFinished[Index] = true;
+    }
+};
+
+/* Every job of a random DAG has to run once, after all of its dependencies. Some dependencies are invalid handles. */
+TEST(RandomDagsRunAfterDependencies)
+{
+    std::mt19937 Random(20);
+    for (int Iteration = 0; Iteration < 200; ++Iteration)
+    {
+        auto Count = (std::size_t)(Random() % 300 + 1);
+        SDagState State(Count);
+        std::vector<SJobHandle> Handles(Count);
+        for (std::size_t Index = 0; Index < Count; ++Index)
+        {
+            std::array<SJobHandle, JobsMaxDependencies> Dependencies{};
+            auto DependencyCount = Index == 0 ? 0 : (std::size_t)(Random() % (JobsMaxDependencies + 1));
+            for (std::size_t Slot = 0; Slot < DependencyCount; ++Slot)
+            {
+                if (Random() % 10 == 0)
+                {
+                    continue;
+                }
+                auto Dependency = (std::size_t)(Random() % Index);
+                Dependencies[Slot] = Handles[Dependency];
+                State.Dependencies[Index].push_back(Dependency);
+            }
+            auto StatePtr = &State;
+            Handles[Index] = Jobs::Submit("Dag", [StatePtr, Index] { StatePtr->Run(Index); }, Dependencies.data(), DependencyCount);
+        }
+        for (auto& Handle : Handles)
+        {
+            Jobs::Wait(Handle);
+        }
+        for (std::size_t Index = 0; Index < Count; ++Index)
+        {
+            EXPECT(State.RunCounts[Index] == 1);
+            EXPECT(Jobs::IsFinished(Handles[Index]));
+        }
+        EXPECT(State.OrderViolations == 0);
+    }
+}
+
+/* Submitting more jobs than there are slots has to make room by running queued jobs, even down a dependency chain. */
+TEST(SubmitPastSlotLimit)
+{
+    static constexpr std::size_t Count = JobsMaxJobs * 3;
+
+    SDagState State(Count);
+    std::vector<SJobHandle> Handles(Count);
+    for (std::size_t Index = 0; Index < Count; ++Index)
+    {
+        /* Every other job waits on the one before it. */
+        auto bChained = Index > 0 && Index % 2 == 0;
+        if (bChained)
+        {
+            State.Dependencies[Index].push_back(Index - 1);
+        }
+        auto StatePtr = &State;
+        Handles[Index] = Jobs::Submit("Exhaust", [StatePtr, Index] { StatePtr->Run(Index); }, &Handles[Index - bChained], bChained);
+    }
+    for (auto& Handle : Handles)
+    {
+        Jobs::Wait(Handle);
+    }
+    for (std::size_t Index = 0; Index < Count; ++Index)
+    {
+        EXPECT(State.RunCounts[Index] == 1);
+    }
+    EXPECT(State.OrderViolations == 0);
+}
+
+/* ParallelFor inside ParallelFor jobs has to visit every index once, with the waiting threads running the inner batches. */
+TEST(NestedParallelForVisitsEachIndexOnce)
+{
+    static constexpr std::size_t Outer = 48;
+    static constexpr std::size_t Inner = 100;
+
+    std::vector<std::atomic<int>> Visits(Outer * Inner);
+    for (int Iteration = 0; Iteration < 20; ++Iteration)
+    {
+        Jobs::ParallelFor("Outer", Outer, 1 + Iteration % 3, [&](std::size_t OuterBegin, std::size_t OuterEnd) {
+            for (auto OuterIndex = OuterBegin; OuterIndex < OuterEnd; ++OuterIndex)
+            {
+                Jobs::ParallelFor("Inner", Inner, 7, [&](std::size_t Begin, std::size_t End) {
+                    for (auto Index = Begin; Index < End; ++Index)
+                    {
+                        Visits[OuterIndex * Inner + Index]++;
+                    }
+                });
+            }
+        });
+    }
+    for (auto& Count : Visits)
+    {
+        EXPECT(Count == 20);
+    }
+}
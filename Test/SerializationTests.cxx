@@ -0,0 +1,43 @@
+#include "Test.hxx"
+
+#include <random>
+#include <vector>
+#include "Serialization.hxx"
+
+/* Every SIMD path has to match the scalar one, for all lengths around their vector widths and any alignment. */
+TEST(SwapInPlacePathsMatchScalar)
+{
+    Serialization::SSwapInPlacePath Paths[Serialization::SwapInPlaceMaxPaths];
+    auto PathCount = Serialization::GetSwapInPlacePaths(Paths);
+    EXPECT(PathCount >= 1);
+
+    std::mt19937 Random(1);
+    for (std::size_t Count = 0; Count < 100; ++Count)
+    {
+        for (std::size_t Offset = 0; Offset < 8; ++Offset)
+        {
+            std::vector<uint32_t> Original(Count + Offset);
+            for (auto& Value : Original)
+            {
+                Value = Random();
+            }
+            auto Expected = Original;
+            Serialization::SwapInPlaceScalar(Expected.data() + Offset, Count);
+            for (std::size_t Index = 0; Index < Count; ++Index)
+            {
+                auto Value = Original[Offset + Index];
+                EXPECT(Expected[Offset + Index] == ((Value >> 24) | ((Value >> 8) & 0xFF00) | ((Value << 8) & 0xFF0000) | (Value << 24)));
+            }
+
+            for (std::size_t Path = 0; Path < PathCount; ++Path)
+            {
+                auto Values = Original;
+                Paths[Path].Func(Values.data() + Offset, Count);
+                EXPECT(Values == Expected);
+            }
+            auto Values = Original;
+            Serialization::SwapInPlace(Values.data() + Offset, Count);
+            EXPECT(Values == Expected);
+        }
+    }
+}
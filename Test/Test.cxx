@@ -0,0 +1,50 @@
+#include "Test.hxx"
+
+#include <vector>
+#include "Jobs.hxx"
+
+struct STestEntry
+{
+    const char* Name{};
+    Test::TestFunc Func{};
+};
+
+/* Function local, registration runs during static initialization of the other files. */
+static std::vector<STestEntry>& GetTests()
+{
+    static std::vector<STestEntry> Tests;
+    return Tests;
+}
+
+static int Failures = 0;
+
+bool Test::Register(const char* Name, TestFunc Func)
+{
+    GetTests().push_back({ Name, Func });
+    return true;
+}
+
+void Test::Fail(const char* File, int Line, const char* Expression)
+{
+    std::printf("  %s:%d: EXPECT(%s) failed\n", File, Line, Expression);
+    Failures++;
+}
+
+int main()
+{
+    Jobs::Init();
+
+    int FailedTests = 0;
+    for (auto& Entry : GetTests())
+    {
+        auto FailuresBefore = Failures;
+        Entry.Func();
+        auto bPassed = Failures == FailuresBefore;
+        std::printf("%s %s\n", bPassed ? "[ OK ]" : "[FAIL]", Entry.Name);
+        FailedTests += !bPassed;
+    }
+    std::printf("%zu tests, %d failed\n", GetTests().size(), FailedTests);
+
+    Jobs::Cleanup();
+    return FailedTests == 0 ? 0 : 1;
+}
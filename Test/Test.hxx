@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdio>
+
+/* Minimal test registry: TEST bodies register themselves at startup and Test.cxx runs them all.
+ * EXPECT keeps going after a failure, so one run reports every broken case. */
+namespace Test
+{
+    using TestFunc = void (*)();
+
+    bool Register(const char* Name, TestFunc Func);
+
+    /* Counts a failure against the running test. */
+    void Fail(const char* File, int Line, const char* Expression);
+}
+
+#define TEST(Name)                                                    \
+    static void Name();                                               \
+    static const bool Name##Registered = Test::Register(#Name, Name); \
+    static void Name()
+
+#define EXPECT(Expression) ((Expression) ? (void)0 : Test::Fail(__FILE__, __LINE__, #Expression))
@@ -0,0 +1,244 @@
+#include "Test.hxx"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <sstream>
+#include "Serialization.hxx"
+#include "Tilemap.hxx"
+
+static bool TilesEqual(const STilemap& A, const STilemap& B)
+{
+    for (int Y = 0; Y < A.Height; ++Y)
+    {
+        for (int X = 0; X < A.Width; ++X)
+        {
+            if (std::memcmp(&A.Tiles.Get(X, Y), &B.Tiles.Get(X, Y), sizeof(STile)) != 0)
+            {
+                return false;
+            }
+        }
+    }
+    return A.Adjacency == B.Adjacency && A.WallJoints == B.WallJoints;
+}
+
+/* EditBlock has to leave the level exactly as calling Edit on every tile of the rect would, and report every tile it changed. */
+TEST(EditBlockMatchesPerTileEdit)
+{
+    static constexpr ETileFlag Flags[] = { 0, TILE_FLOOR_BIT, TILE_HOLE_BIT, TILE_FLOOR_BIT | TILE_HOLE_BIT, TILE_NONE_BIT };
+
+    std::mt19937 Random(11);
+    for (int Iteration = 0; Iteration < 2000; ++Iteration)
+    {
+        STilemap Level;
+        Level.Width = (int)(Random() % 70 + 1);
+        Level.Height = (int)(Random() % 40 + 1);
+        for (int Y = 0; Y < Level.Height; ++Y)
+        {
+            for (int X = 0; X < Level.Width; ++X)
+            {
+                if (Random() % 3 == 0)
+                {
+                    continue;
+                }
+                STile Tile;
+                Tile.Flags = Flags[Random() % std::size(Flags)];
+                Tile.SpecialFlags = Random() % 4;
+                Tile.EdgeFlags = Random() % 5 == 0 ? Random() : Random() % 256;
+                Level.Tiles.Set(X, Y, Tile);
+            }
+        }
+        Level.PostProcess();
+
+        auto Block = Level;
+        auto PerTile = Level;
+        for (int Edit = 0; Edit < 4; ++Edit)
+        {
+            /* Rects may stick out of the level, and a quarter of them are a single tile. */
+            auto RandomCoords = [&] { return SVec2Int{ (int)(Random() % (Level.Width + 4)) - 2, (int)(Random() % (Level.Height + 4)) - 2 }; };
+            auto First = RandomCoords();
+            auto Rect = SRectInt::FromTwo(First, Random() % 4 == 0 ? First : RandomCoords());
+            auto Flag = Flags[Random() % std::size(Flags)];
+
+            auto Before = Block;
+            auto Ranges = Block.EditBlock(Rect, Flag);
+            for (auto X = Rect.Min.X; X <= Rect.Max.X; ++X)
+            {
+                for (auto Y = Rect.Min.Y; Y <= Rect.Max.Y; ++Y)
+                {
+                    PerTile.Edit({ X, Y }, Flag);
+                }
+            }
+            EXPECT(TilesEqual(Block, PerTile));
+
+            for (std::size_t Index = 1; Index < Ranges.size(); ++Index)
+            {
+                EXPECT(Ranges[Index].X > Ranges[Index - 1].Y + 1);
+            }
+            for (int Y = 0; Y < Level.Height; ++Y)
+            {
+                for (int X = 0; X < Level.Width; ++X)
+                {
+                    if (std::memcmp(&Block.Tiles.Get(X, Y), &Before.Tiles.Get(X, Y), sizeof(STile)) == 0)
+                    {
+                        continue;
+                    }
+                    auto TileIndex = Block.CoordsToIndex(X, Y);
+                    auto bReported = false;
+                    for (auto& Range : Ranges)
+                    {
+                        bReported |= TileIndex >= Range.X && TileIndex <= Range.Y;
+                    }
+                    EXPECT(bReported);
+                }
+            }
+            if (!TilesEqual(Block, PerTile))
+            {
+                /* Everything after the first difference would fail too. */
+                return;
+            }
+        }
+    }
+}
+
+static std::vector<uint8_t> SerializeFixedLayout(const STilemap& Level)
+{
+    auto Path = std::filesystem::temp_directory_path() / "EquinoxReachPatchTest.erm";
+    {
+        std::ofstream Stream(Path, std::ios::binary | std::ios::trunc);
+        Level.Serialize(Stream, true);
+    }
+    std::ifstream Stream(Path, std::ios::binary);
+    std::vector<uint8_t> Bytes(std::istreambuf_iterator<char>(Stream), {});
+    Stream.close();
+    std::error_code Error;
+    std::filesystem::remove(Path, Error);
+    return Bytes;
+}
+
+/* Applying a patch journal to the old file has to give the same bytes as writing the edited level out in full,
+ * and a journal that lost its tail or got corrupted must not touch the file at all. */
+TEST(PatchJournalMatchesFullWrite)
+{
+    std::mt19937 Random(5);
+    int Patched = 0;
+    for (int Iteration = 0; Iteration < 200; ++Iteration)
+    {
+        STilemap Level;
+        Level.Width = (int)(Random() % 60 + 4);
+        Level.Height = (int)(Random() % 60 + 4);
+        Level.EditBlock(SRectInt{ SVec2Int{ 1, 1 }, SVec2Int{ Level.Width - 2, Level.Height - 2 } }, TILE_FLOOR_BIT);
+        Level.PostProcess();
+        auto Original = SerializeFixedLayout(Level);
+
+        /* A few edits far apart, marked the way the editor marks them. */
+        SDirtySpans Spans;
+        for (int Edit = 0; Edit < 3; ++Edit)
+        {
+            SVec2Int Coords{ (int)(Random() % Level.Width), (int)(Random() % Level.Height) };
+            Level.Edit(Coords, Random() % 2 ? TILE_FLOOR_BIT : 0);
+            for (auto Y = std::max(Coords.Y - 1, 0); Y <= std::min(Coords.Y + 1, Level.Height - 1); ++Y)
+            {
+                Spans.Add(Level.CoordsToIndex(std::max(Coords.X - 1, 0), Y), Level.CoordsToIndex(std::min(Coords.X + 1, Level.Width - 1), Y));
+            }
+        }
+        Level.PostProcess();
+
+        Serialization::SpanReader Reader(Original.data(), Original.size());
+        STilemapFileLayout Layout{};
+        EXPECT(STilemap::ReadFileLayout(Reader, Layout));
+        if (!Level.CanPatch(Layout, Spans))
+        {
+            continue;
+        }
+        Patched++;
+
+        auto Journal = Memory::GetVector<uint8_t>();
+        Level.SerializePatch(Journal, Layout, Spans);
+        EXPECT(STilemap::IsPatchJournalSealed(Journal.data(), Journal.size()));
+
+        std::string OriginalString(Original.begin(), Original.end());
+        std::stringstream File(OriginalString, std::ios::in | std::ios::out | std::ios::binary);
+        EXPECT(STilemap::ApplyPatchJournal(Journal.data(), Journal.size(), File));
+        auto Expected = SerializeFixedLayout(Level);
+        EXPECT(File.str() == std::string(Expected.begin(), Expected.end()));
+
+        std::stringstream TornFile(OriginalString, std::ios::in | std::ios::out | std::ios::binary);
+        EXPECT(!STilemap::ApplyPatchJournal(Journal.data(), Journal.size() - 1, TornFile));
+        Journal[Random() % (Journal.size() - ETilemapFormat::JournalSealSize)] ^= 1;
+        EXPECT(!STilemap::ApplyPatchJournal(Journal.data(), Journal.size(), TornFile));
+        EXPECT(TornFile.str() == OriginalString);
+    }
+    EXPECT(Patched > 100);
+}
+
+/* Spans have to stay sorted, apart and within MaxSpans, and cover every added tile.
+ * Until more than MaxSpans separate runs are dirty they have to match the runs exactly. */
+TEST(DirtySpansCoverAddedTiles)
+{
+    std::mt19937 Random(18);
+    for (int Iteration = 0; Iteration < 2000; ++Iteration)
+    {
+        auto TileCount = (std::size_t)(Random() % 400 + 1);
+        std::vector<bool> Dirty(TileCount);
+        SDirtySpans Spans;
+        auto bExact = true;
+        for (int Add = 0; Add < 40; ++Add)
+        {
+            auto First = (std::size_t)(Random() % TileCount);
+            auto Last = std::min(First + (Random() % 3 == 0 ? Random() % 40 : 0), TileCount - 1);
+            std::fill(Dirty.begin() + (std::ptrdiff_t)First, Dirty.begin() + (std::ptrdiff_t)Last + 1, true);
+            Spans.Add(First, Last);
+
+            auto Runs = std::vector<SVec2Size>();
+            for (std::size_t Index = 0; Index < TileCount; ++Index)
+            {
+                if (!Dirty[Index])
+                {
+                    continue;
+                }
+                if (!Runs.empty() && Runs.back().Y + 1 == Index)
+                {
+                    Runs.back().Y = Index;
+                }
+                else
+                {
+                    Runs.push_back({ Index, Index });
+                }
+            }
+            bExact &= Runs.size() <= SDirtySpans::MaxSpans;
+
+            EXPECT(Spans.Count <= SDirtySpans::MaxSpans);
+            std::size_t Covered{};
+            for (std::size_t Index = 0; Index < Spans.Count; ++Index)
+            {
+                EXPECT(Spans.Spans[Index].X <= Spans.Spans[Index].Y);
+                EXPECT(Index == 0 || Spans.Spans[Index - 1].Y + 1 < Spans.Spans[Index].X);
+                for (auto Tile = Spans.Spans[Index].X; Tile <= Spans.Spans[Index].Y; ++Tile)
+                {
+                    Covered += Dirty[Tile];
+                }
+            }
+            EXPECT(Covered == (std::size_t)std::count(Dirty.begin(), Dirty.end(), true));
+            if (bExact)
+            {
+                EXPECT(std::equal(Runs.begin(), Runs.end(), Spans.begin(), Spans.end()));
+                EXPECT(Spans.TileCount() == Covered);
+            }
+        }
+    }
+
+    /* At the cap, the two spans with the smallest gap between them merge. */
+    SDirtySpans Spans;
+    for (std::size_t Span = 0; Span <= SDirtySpans::MaxSpans; ++Span)
+    {
+        auto First = Span * 10 - (Span > 5 ? 4 : 0);
+        Spans.Add(First, First + 1);
+    }
+    EXPECT(Spans.Count == SDirtySpans::MaxSpans);
+    EXPECT(Spans.Spans[4].X == 40 && Spans.Spans[4].Y == 41);
+    EXPECT(Spans.Spans[5].X == 50 && Spans.Spans[5].Y == 57);
+    EXPECT(Spans.TileCount() == SDirtySpans::MaxSpans * 2 + 6);
+}
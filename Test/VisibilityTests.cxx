@@ -0,0 +1,157 @@
+#include "Test.hxx"
+
+#include <random>
+#include <vector>
+#include "Memory.hxx"
+#include "Tilemap.hxx"
+#include "Visibility.hxx"
+
+/* Wide enough that rebakes around an edit leave most of the level alone. */
+static STilemap MakeRandomLevel(std::mt19937& Random)
+{
+    STilemap Level;
+    Level.Width = (int)(Random() % 25 + 40);
+    Level.Height = (int)(Random() % 17 + 8);
+    for (int Y = 0; Y < Level.Height; ++Y)
+    {
+        for (int X = 0; X < Level.Width; ++X)
+        {
+            if (Random() % 10 == 0)
+            {
+                continue;
+            }
+            STile Tile;
+            Tile.Flags = TILE_FLOOR_BIT;
+            for (auto& Direction : SDirection::All())
+            {
+                if (Random() % 12 == 0)
+                {
+                    Tile.SetEdgeFlag(TILE_EDGE_WALL_BIT, Direction);
+                }
+            }
+            Level.Tiles.Set(X, Y, Tile);
+        }
+    }
+    Level.PostProcess();
+    return Level;
+}
+
+static bool IsSameAsFullBake(const CLevelVisibility& Visibility, const STilemap& Level)
+{
+    CLevelVisibility Expected;
+    Expected.Bake(Level);
+    for (std::size_t Index = 0; Index < Level.TileCount(); ++Index)
+    {
+        if (Visibility.GetMask(Level.IndexToCoords(Index)) != Expected.GetMask(Level.IndexToCoords(Index)))
+        {
+            return false;
+        }
+    }
+    return Visibility.IsBaked(Level);
+}
+
+/* Every tile of every added rect has to stay covered, by at most MaxRects disjoint rects. */
+TEST(DirtyRectsCoverAddedRects)
+{
+    static constexpr int Size = 64;
+
+    std::mt19937 Random(24);
+    for (int Iteration = 0; Iteration < 300; ++Iteration)
+    {
+        SDirtyRects Rects;
+        std::vector<bool> Added(Size * Size);
+        auto Count = Random() % 40 + 1;
+        for (std::size_t Rect = 0; Rect < Count; ++Rect)
+        {
+            auto Min = SVec2Int{ (int)(Random() % Size), (int)(Random() % Size) };
+            auto Max = SVec2Int{ std::min(Min.X + (int)(Random() % 6), Size - 1), std::min(Min.Y + (int)(Random() % 6), Size - 1) };
+            Rects.Add(SRectInt{ Min, Max });
+            for (auto Y = Min.Y; Y <= Max.Y; ++Y)
+            {
+                for (auto X = Min.X; X <= Max.X; ++X)
+                {
+                    Added[Y * Size + X] = true;
+                }
+            }
+        }
+
+        EXPECT(Rects.Count <= SDirtyRects::MaxRects);
+        std::vector<int> Covered(Size * Size);
+        for (auto& Rect : Rects)
+        {
+            EXPECT(Rect.Min.X <= Rect.Max.X && Rect.Min.Y <= Rect.Max.Y);
+            for (auto Y = Rect.Min.Y; Y <= Rect.Max.Y; ++Y)
+            {
+                for (auto X = Rect.Min.X; X <= Rect.Max.X; ++X)
+                {
+                    Covered[Y * Size + X]++;
+                }
+            }
+        }
+        for (int Index = 0; Index < Size * Size; ++Index)
+        {
+            EXPECT(Covered[Index] <= 1);
+            EXPECT(!Added[Index] || Covered[Index] == 1);
+        }
+    }
+}
+
+/* Rebaking around edits, including ones made while a rebake runs, has to end up with the masks of a full bake. */
+TEST(BakerRebakesEditsLikeAFullBake)
+{
+    std::mt19937 Random(25);
+    for (int Iteration = 0; Iteration < 6; ++Iteration)
+    {
+        Memory::NextFrame();
+        auto Level = MakeRandomLevel(Random);
+        CLevelVisibility Visibility;
+        SDirtyRects DirtyRects;
+        CVisibilityBaker Baker;
+
+        /* A cancelled bake is dropped. */
+        Baker.Start(Visibility, Level, DirtyRects);
+        Baker.Cancel();
+        EXPECT(!Baker.Apply(Visibility, Level));
+        EXPECT(!Visibility.IsBaked(Level));
+
+        Baker.Start(Visibility, Level, DirtyRects);
+        EXPECT(Baker.Apply(Visibility, Level));
+        EXPECT(IsSameAsFullBake(Visibility, Level));
+
+        auto Edit = [&] {
+            auto Coords = SVec2Int{ (int)(Random() % Level.Width), (int)(Random() % Level.Height) };
+            if (Random() % 3 == 0)
+            {
+                Level.Edit(Coords, Random() % 2 ? TILE_FLOOR_BIT : 0);
+            }
+            else
+            {
+                Level.ToggleEdge(Coords, SDirection::All()[Random() % 4], TILE_EDGE_WALL_BIT);
+            }
+            /* What SWorldLevel::MarkEdited adds for the tile. */
+            DirtyRects.Add(SRectInt{
+                { std::max(Coords.X - 1, 0), std::max(Coords.Y - 1, 0) },
+                { std::min(Coords.X + 1, Level.Width - 1), std::min(Coords.Y + 1, Level.Height - 1) } });
+        };
+
+        for (int Round = 0; Round < 6; ++Round)
+        {
+            auto Edits = Random() % 4 + 1;
+            for (std::size_t Index = 0; Index < Edits; ++Index)
+            {
+                Edit();
+            }
+            Baker.Start(Visibility, Level, DirtyRects);
+            EXPECT(DirtyRects.IsEmpty());
+            if (Random() % 2)
+            {
+                /* Lands after the snapshot was taken, so it has to wait for the next rebake. */
+                Edit();
+            }
+            EXPECT(Baker.Apply(Visibility, Level));
+            Baker.Start(Visibility, Level, DirtyRects);
+            Baker.Apply(Visibility, Level);
+            EXPECT(IsSameAsFullBake(Visibility, Level));
+        }
+    }
+}